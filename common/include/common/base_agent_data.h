@@ -1,9 +1,10 @@
 #pragma once
 
 #include "base_agent_data_generic_storage.h"
+#include "storage_policies.h"
 
 namespace physicore {
 
-using base_agent_data = base_agent_data_generic_storage<std::vector>;
+using base_agent_data = base_agent_data_generic_storage<agent_column>;
 
 }
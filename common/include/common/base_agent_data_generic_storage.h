@@ -1,10 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <concepts>
 #include <cstring>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "column_view.h"
 #include "types.h"
 
 namespace physicore {
@@ -27,12 +33,41 @@ struct base_agent_data_generic_storage
 	index_t agents_count = 0;
 	index_t dims;
 
-	explicit base_agent_data_generic_storage(index_t dims = 3) : dims(dims) {}
+	// Columns of allocator aware policies such as arena_vector allocate from resource, if given
+	explicit base_agent_data_generic_storage(index_t dims = 3, std::pmr::memory_resource* resource = nullptr)
+		: dims(dims), positions(make_column<ContainerType<real_t>>(resource))
+	{}
 
-	void add()
+	void add() { add(1); }
+
+	// Appends count agents, growing every column once
+	void add(index_t count)
 	{
-		++agents_count;
-		positions.resize(agents_count * dims);
+		agents_count += count;
+		grow(positions, agents_count * dims);
+	}
+
+	// Allocates the columns for capacity agents without adding any
+	void reserve(index_t capacity) { reserve_column(positions, capacity * dims); }
+
+	// Reorders agents so that the agent at order[i] moves to position i, order is a permutation of all agents
+	void permute(std::span<const index_t> order)
+	{
+		assert(order.size() == agents_count);
+		gather(positions, order, dims);
+	}
+
+	// Typed view of a column, e.g. column<base_columns::positions>() is an agents x dims column_view
+	template <typename Column>
+	auto column()
+	{
+		return view_column<Column>(*this);
+	}
+
+	template <typename Column>
+	auto column() const
+	{
+		return view_column<Column>(*this);
 	}
 
 	void remove_at(index_t position)
@@ -51,6 +86,69 @@ struct base_agent_data_generic_storage
 		positions.resize(agents_count * dims);
 	}
 
+	// Moves agents by (destination, source) pairs and truncates the columns to count agents
+	// Pairs must not read a slot written by an earlier pair, all columns of an agent are moved together
+	void compact(std::span<const std::pair<index_t, index_t>> moves, index_t count)
+	{
+		assert(count <= agents_count);
+
+		for (const auto& [destination, source] : moves)
+			move_vector(&positions[destination * dims], &positions[source * dims], dims);
+
+		agents_count = count;
+		positions.resize(agents_count * dims);
+	}
+
+	// Empty column allocating from resource if its policy takes a std::pmr::memory_resource, a default one otherwise
+	template <typename ColumnType>
+	static ColumnType make_column(std::pmr::memory_resource* resource)
+	{
+		if constexpr (std::is_constructible_v<ColumnType, std::pmr::memory_resource*>)
+			if (resource != nullptr)
+				return ColumnType(resource);
+
+		return ColumnType();
+	}
+
+	// Resizes a column to size, growing its capacity geometrically so that adding agents one at a time is amortised
+	// O(1) even for containers that grow only by what is requested
+	template <typename ColumnType>
+	static void grow(ColumnType& column, std::size_t size, const typename ColumnType::value_type& value = {})
+	{
+		if constexpr (requires { column.capacity(); })
+			if (column.capacity() < size)
+				reserve_column(column, std::max(size, 2 * column.capacity()));
+
+		column.resize(size, value);
+	}
+
+	template <typename ColumnType>
+	static void reserve_column(ColumnType& column, std::size_t capacity)
+	{
+		if constexpr (requires { column.reserve(capacity); })
+			column.reserve(capacity);
+	}
+
+	// Rewrites a column of width values per agent in the order given by a permutation of agents
+	// The column keeps its buffer, so pointers to it held by solvers stay valid
+	template <typename ColumnType>
+	static void gather(ColumnType& column, std::span<const index_t> order, index_t width)
+	{
+		if (column.size() == 0)
+			return;
+
+		// columns with stateful allocators copy into their own memory resource
+		const ColumnType source = [&] {
+			if constexpr (requires { column.get_allocator(); })
+				return ColumnType(column.begin(), column.end(), column.get_allocator());
+			else
+				return ColumnType(column.begin(), column.end());
+		}();
+
+		for (index_t i = 0; i < order.size(); ++i)
+			move_vector(&column[i * width], &source[order[i] * width], width);
+	}
+
 	template <typename T>
 	static void move_scalar(T* dst, const T* src)
 	{
@@ -66,4 +164,14 @@ struct base_agent_data_generic_storage
 	ContainerType<real_t> positions;
 };
 
+namespace base_columns {
+
+struct positions
+{
+	static auto& of(auto& data) { return data.positions; }
+	static index_t width(const auto& data) { return data.dims; }
+};
+
+} // namespace base_columns
+
 } // namespace physicore
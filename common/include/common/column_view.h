@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <ranges>
+#include <span>
+#include <tuple>
+
+#include "types.h"
+
+namespace physicore {
+
+template <typename T>
+struct column_row
+{
+	T* data;
+	index_t width;
+
+	std::span<T> operator()(index_t row) const { return std::span<T>(data + row * width, width); }
+};
+
+/*
+Non-owning, row-major agents x width view of one column of agent data.
+
+It is a random access range yielding a std::span per agent and is indexed without virtual dispatch. values() exposes the
+whole column as a single contiguous span, the form to hand to vectorized loops and parallel algorithms.
+The view is invalidated when agents are added or removed.
+*/
+template <typename T>
+class column_view : public std::ranges::transform_view<std::ranges::iota_view<index_t, index_t>, column_row<T>>
+{
+	using base_view = std::ranges::transform_view<std::ranges::iota_view<index_t, index_t>, column_row<T>>;
+
+	T* data_;
+	index_t rows_;
+	index_t width_;
+
+public:
+	column_view(T* data, index_t rows, index_t width)
+		: base_view(std::views::iota(index_t(0), rows), column_row<T> { data, width }),
+		  data_(data),
+		  rows_(rows),
+		  width_(width)
+	{}
+
+	index_t width() const { return width_; }
+
+	std::span<T> values() const { return std::span<T>(data_, rows_ * width_); }
+
+	// View of count agents starting at first
+	column_view subview(index_t first, index_t count) const
+	{
+		assert(first + count <= rows_);
+		return column_view(data_ + first * width_, count, width_);
+	}
+};
+
+/*
+Views the column of data named by the tag type Column.
+
+A tag provides of(data), the column container, and for columns with several values per agent width(data). Those are
+viewed as a column_view, columns with one value per agent as a std::span. Columns have a row per agent unless the tag
+provides the count of rows by rows(data).
+*/
+template <typename Column, typename Data>
+auto view_column(Data& data)
+{
+	auto& values = Column::of(data);
+
+	index_t rows = data.agents_count;
+	if constexpr (requires { Column::rows(data); })
+		rows = Column::rows(data);
+
+	if constexpr (requires { Column::width(data); })
+		return column_view(values.data(), rows, Column::width(data));
+	else
+		return std::span(values.data(), rows);
+}
+
+/*
+Zips columns of the same agents into a random access range of tuples, one per agent.
+
+Elements are the columns' references, a std::span per agent of a column_view and a reference to the value of a scalar
+column, so structured bindings write through to the data:
+
+for (auto [internalized, volume] : zip_columns(data.column<columns::internalized_substrates>(),
+											   data.column<columns::volumes>()))
+	...
+
+All columns must have the same number of rows. Parameter columns shared by agent types have a row per type rather than
+per agent and are not zipped with per agent columns.
+*/
+template <std::ranges::random_access_range... Columns>
+auto zip_columns(Columns... columns)
+{
+	const index_t rows = std::min({ static_cast<index_t>(std::ranges::size(columns))... });
+	assert(((static_cast<index_t>(std::ranges::size(columns)) == rows) && ...));
+
+	return std::views::iota(index_t(0), rows) | std::views::transform([columns...](index_t row) {
+			   return std::tuple<std::ranges::range_reference_t<const Columns>...>(columns[row]...);
+		   });
+}
+
+} // namespace physicore
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <set>
+#include <string>
+
+namespace physicore {
+
+// Names of the shared data arrays (e.g. "positions", "volumes") a module reads and writes while it runs
+struct data_access
+{
+	std::set<std::string> reads;
+	std::set<std::string> writes;
+
+	// Concurrent execution is safe if neither side writes an array the other one reads or writes
+	bool conflicts_with(const data_access& other) const
+	{
+		auto intersects = [](const std::set<std::string>& a, const std::set<std::string>& b) {
+			for (const auto& name : a)
+				if (b.contains(name))
+					return true;
+			return false;
+		};
+
+		return intersects(writes, other.writes) || intersects(writes, other.reads) || intersects(reads, other.writes);
+	}
+};
+
+} // namespace physicore
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <span>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+#ifdef __linux__
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+#include "types.h"
+
+namespace physicore {
+
+/*
+Worker threads a module runs its parallel work on.
+
+Modules receive a context before they are initialized and size their OpenMP teams or TBB arenas by it. Workers are
+pinned to the context cpus, so modules given contexts over disjoint cpu sets (e.g. diffusion and mechanics) do not
+compete for cores, while modules sharing a context share them.
+*/
+class execution_context
+{
+	index_t threads_count_;
+	std::vector<unsigned> cpus_;
+
+public:
+	// threads_count 0 means one thread per cpu, or the threading runtime default if cpus are empty too
+	explicit execution_context(index_t threads_count = 0, std::vector<unsigned> cpus = {})
+		: threads_count_(threads_count == 0 ? cpus.size() : threads_count), cpus_(std::move(cpus))
+	{}
+
+	// 0 leaves the team size to the threading runtime
+	index_t get_threads_count() const { return threads_count_; }
+
+	std::span<const unsigned> get_cpus() const { return cpus_; }
+
+	// Pins the calling thread, the worker_index-th worker of a team, to its cpu (round robin over cpus)
+	// No-op if the context has no cpus or the platform does not support thread affinity
+	void pin_current_thread(index_t worker_index) const
+	{
+		if (cpus_.empty())
+			return;
+
+#ifdef __linux__
+		// workers of persistent thread pools enter many teams, the affinity call is needed only once
+		auto& pinned = pinned_to();
+		if (pinned == std::pair { this, worker_index })
+			return;
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpus_[worker_index % cpus_.size()], &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+		pinned = { this, worker_index };
+#else
+		(void)worker_index;
+#endif
+	}
+
+	/*
+	Pins the calling thread like pin_current_thread while the guard lives. With restore set, the thread gets its
+	previous affinity back when the guard is destroyed, which is what the thread opening a parallel region needs:
+	unlike the pooled workers, it goes on running the caller's code once the region ends.
+	*/
+	class scoped_pin
+	{
+#ifdef __linux__
+		cpu_set_t previous_;
+		bool restore_ = false;
+#endif
+
+	public:
+		scoped_pin(const execution_context* context, index_t worker_index, bool restore)
+		{
+			if (!context || context->cpus_.empty())
+				return;
+
+#ifdef __linux__
+			restore_ = restore && pthread_getaffinity_np(pthread_self(), sizeof(previous_), &previous_) == 0;
+#else
+			(void)restore;
+#endif
+
+			context->pin_current_thread(worker_index);
+		}
+
+		scoped_pin(const scoped_pin&) = delete;
+		scoped_pin& operator=(const scoped_pin&) = delete;
+
+		~scoped_pin()
+		{
+#ifdef __linux__
+			if (!restore_)
+				return;
+
+			pthread_setaffinity_np(pthread_self(), sizeof(previous_), &previous_);
+			pinned_to() = { nullptr, 0 };
+#endif
+		}
+	};
+
+private:
+	// Context and worker index the calling thread is pinned to
+	static std::pair<const execution_context*, index_t>& pinned_to()
+	{
+		thread_local std::pair<const execution_context*, index_t> pinned = { nullptr, 0 };
+		return pinned;
+	}
+};
+
+// Team size of OpenMP parallel regions run in the given execution context, null or a zero threads count fall back to
+// the runtime default
+inline int get_team_size(const execution_context* context)
+{
+	if (context && context->get_threads_count() != 0)
+		return static_cast<int>(context->get_threads_count());
+
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+} // namespace physicore
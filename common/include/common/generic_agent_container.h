@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <memory>
+#include <ranges>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include "base_agent_interface.h"
@@ -19,12 +24,37 @@ protected:
 public:
 	virtual AgentType* create() = 0;
 
+	// Creates count agents at once and returns the contiguous range of their indices
+	virtual std::ranges::iota_view<index_t, index_t> create_n(index_t count) = 0;
+
+	// Allocates storage for capacity agents so that creating up to that many does not reallocate
+	virtual void reserve(index_t capacity) = 0;
+
+	// Creates the handle of the agent on first access, so it must not be called concurrently unless all handles were
+	// created beforehand by materialize_handles
 	virtual AgentType* get_agent_at(index_t position) = 0;
 
+	// Creates the handles of all agents, afterwards get_agent_at only reads and may be called from parallel loops
+	virtual void materialize_handles() = 0;
+
 	virtual void remove_agent(base_agent_interface* agent) = 0;
 
 	virtual void remove_at(index_t position) = 0;
 
+	// Removes the agents at positions (duplicates are ignored) moving each data column once
+	// Unless preserve_order is set, holes are filled by the last surviving agents like remove_at does
+	virtual void remove_many(std::span<const index_t> positions, bool preserve_order = false) = 0;
+
+	// Defers removal of the agent at position until the next compact call, positions stay valid until then
+	virtual void mark_for_removal(index_t position) = 0;
+
+	// Removes all agents marked for removal at once
+	virtual void compact(bool preserve_order = false) = 0;
+
+	// Reorders agents so that the agent at order[i] moves to position i, order is a permutation of all agents
+	// Handles follow their agents
+	virtual void permute(std::span<const index_t> order) = 0;
+
 	virtual std::size_t size() const = 0;
 
 	virtual ~generic_agent_interface_container() = default;
@@ -51,8 +81,134 @@ class generic_agent_and_data_container : public generic_agent_impl_container<Age
 protected:
 	using MostConcreteAgentType = std::tuple_element_t<sizeof...(AgentTypes) - 1, std::tuple<AgentTypes...>>;
 
+	index_t agents_count = 0;
+
+	// Handles are created on demand by get_agent_at and create, agents without one cost only their data columns
+	// Slots past the end or holding nullptr have no handle yet
 	std::vector<std::unique_ptr<MostConcreteAgentType>> agents;
 
+#ifndef NDEBUG
+	// threads creating a handle right now, creation resizes and writes the handles and must not run concurrently
+	std::atomic<int> creating_handles = 0;
+#endif
+
+	std::vector<index_t> marked_for_removal;
+	std::vector<index_t> removal_scratch;
+
+	// (destination, source) pairs of a compaction
+	std::vector<std::pair<index_t, index_t>> moves;
+
+	// Plans moves that close the holes left by the sorted unique removed positions
+	void plan_compaction(std::span<const index_t> removed, bool preserve_order)
+	{
+		const index_t count = this->size();
+		const index_t new_count = count - removed.size();
+
+		moves.clear();
+
+		if (removed.empty())
+			return;
+
+		if (preserve_order)
+		{
+			// survivors slide down in order, every destination was read by an earlier pair or removed
+			auto next_removed = removed.begin();
+			index_t destination = removed.front();
+
+			for (index_t source = removed.front(); source < count; ++source)
+			{
+				if (next_removed != removed.end() && *next_removed == source)
+				{
+					++next_removed;
+					continue;
+				}
+
+				moves.emplace_back(destination++, source);
+			}
+		}
+		else
+		{
+			// holes below the new size take the survivors above it, sources and destinations are disjoint
+			const auto holes_end = std::ranges::lower_bound(removed, new_count);
+			auto tail_removed = holes_end;
+			index_t source = new_count;
+
+			for (auto hole = removed.begin(); hole != holes_end; ++hole)
+			{
+				while (tail_removed != removed.end() && *tail_removed == source)
+				{
+					++tail_removed;
+					++source;
+				}
+
+				moves.emplace_back(*hole, source++);
+			}
+		}
+	}
+
+	// Removes the agents at positions, which are sorted and deduplicated in place
+	void remove_positions(std::vector<index_t>& positions, bool preserve_order)
+	{
+		std::ranges::sort(positions);
+		positions.erase(std::ranges::unique(positions).begin(), positions.end());
+
+		assert(positions.empty() || positions.back() < this->size());
+
+		plan_compaction(positions, preserve_order);
+		apply_compaction(this->size() - positions.size());
+	}
+
+	// Applies the planned moves to all datas and to the agent handles
+	void apply_compaction(index_t new_count)
+	{
+		(std::get<std::unique_ptr<typename AgentTypes::DataType>>(agent_datas)->compact(moves, new_count), ...);
+
+		move_handles(new_count);
+	}
+
+	// Moves the handles along with their agents, destinations of both removal modes are ascending
+	void move_handles(index_t new_count)
+	{
+		for (const auto& [destination, source] : moves)
+		{
+			if (destination >= agents.size())
+				break;
+
+			agents[destination] = source < agents.size() ? std::move(agents[source]) : nullptr;
+
+			if (agents[destination])
+				generic_agent_interface_container<base_agent_interface>::get_agent_index(agents[destination].get()) =
+					destination;
+		}
+
+		agents_count = new_count;
+
+		if (agents.size() > agents_count)
+			agents.resize(agents_count);
+	}
+
+	MostConcreteAgentType* materialize_handle(index_t position)
+	{
+		if (position < agents.size() && agents[position])
+			return agents[position].get();
+
+#ifndef NDEBUG
+		[[maybe_unused]] const int concurrent = creating_handles.fetch_add(1);
+		assert(concurrent == 0 && "Handles must be created by materialize_handles before concurrent get_agent_at");
+#endif
+
+		if (position >= agents.size())
+			agents.resize(agents_count);
+
+		agents[position] = std::make_unique<MostConcreteAgentType>(position, agent_datas);
+
+#ifndef NDEBUG
+		creating_handles.fetch_sub(1);
+#endif
+
+		return agents[position].get();
+	}
+
 public:
 	std::tuple<std::unique_ptr<typename AgentTypes::DataType>...> agent_datas;
 
@@ -63,10 +219,28 @@ public:
 	MostConcreteAgentType* create() override
 	{
 		(std::get<std::unique_ptr<typename AgentTypes::DataType>>(agent_datas)->add(), ...);
-		auto new_agent = std::make_unique<MostConcreteAgentType>(this->size(), agent_datas);
-		MostConcreteAgentType* agent_ptr = new_agent.get();
-		agents.emplace_back(std::move(new_agent));
-		return agent_ptr;
+		++agents_count;
+
+		return materialize_handle(agents_count - 1);
+	}
+
+	// Creates no handles, agents are accessed by index through proxies or the data columns
+	std::ranges::iota_view<index_t, index_t> create_n(index_t count) override
+	{
+		const index_t first = agents_count;
+
+		(std::get<std::unique_ptr<typename AgentTypes::DataType>>(agent_datas)->add(count), ...);
+		agents_count += count;
+
+		return std::views::iota(first, agents_count);
+	}
+
+	void reserve(index_t capacity) override
+	{
+		(std::get<std::unique_ptr<typename AgentTypes::DataType>>(agent_datas)->reserve(capacity), ...);
+
+		if (!agents.empty())
+			agents.reserve(capacity);
 	}
 
 	void remove_agent(base_agent_interface* agent) override
@@ -79,27 +253,95 @@ public:
 	{
 		assert(position < this->size());
 
-		if (static_cast<size_t>(position) >= agents.size())
+		if (position >= agents_count)
 			return;
 
 		(std::get<std::unique_ptr<typename AgentTypes::DataType>>(agent_datas)->remove_at(position), ...);
 
-		index_t& index = generic_agent_interface_container<base_agent_interface>::get_agent_index(agents.back().get());
-		index = position;
-		std::swap(agents[position], agents.back());
-		agents.resize(this->size() - 1);
+		moves.clear();
+		if (position != agents_count - 1)
+			moves.emplace_back(position, agents_count - 1);
+
+		move_handles(agents_count - 1);
 	}
 
+	void remove_many(std::span<const index_t> positions, bool preserve_order = false) override
+	{
+		removal_scratch.assign(positions.begin(), positions.end());
+		remove_positions(removal_scratch, preserve_order);
+	}
+
+	void mark_for_removal(index_t position) override
+	{
+		assert(position < this->size());
+		marked_for_removal.push_back(position);
+	}
+
+	void compact(bool preserve_order = false) override
+	{
+		remove_positions(marked_for_removal, preserve_order);
+		marked_for_removal.clear();
+	}
+
+	void permute(std::span<const index_t> order) override
+	{
+		assert(order.size() == this->size());
+
+		(std::get<std::unique_ptr<typename AgentTypes::DataType>>(agent_datas)->permute(order), ...);
+
+		if (agents.empty())
+			return;
+
+		std::vector<std::unique_ptr<MostConcreteAgentType>> permuted(agents_count);
+
+		for (index_t i = 0; i < agents_count; ++i)
+		{
+			if (order[i] >= agents.size() || !agents[order[i]])
+				continue;
+
+			permuted[i] = std::move(agents[order[i]]);
+			generic_agent_interface_container<base_agent_interface>::get_agent_index(permuted[i].get()) = i;
+		}
+
+		agents = std::move(permuted);
+	}
+
+	// Returns the handle of the agent, creating it on first access (concurrent creation is asserted in debug builds)
 	MostConcreteAgentType* get_agent_at(index_t position) override
 	{
-		assert(position < agents.size());
-		if (position >= agents.size())
+		assert(position < this->size());
+		if (position >= agents_count)
 			return nullptr;
 
-		return agents[position].get();
+		return materialize_handle(position);
+	}
+
+	void materialize_handles() override
+	{
+		agents.resize(agents_count);
+
+		for (index_t i = 0; i < agents_count; ++i)
+			if (!agents[i])
+				agents[i] = std::make_unique<MostConcreteAgentType>(i, agent_datas);
+	}
+
+	// Lightweight stack proxy of the agent at position, it does not follow the agent when agents are removed
+	MostConcreteAgentType make_proxy(index_t position)
+	{
+		assert(position < this->size());
+		return MostConcreteAgentType(position, agent_datas);
+	}
+
+	// Handle-free iteration over all agents
+	std::ranges::iota_view<index_t, index_t> indices() const { return std::views::iota(index_t(0), agents_count); }
+
+	// Number of agents that have a handle, the rest cost only their data columns
+	std::size_t handles_count() const
+	{
+		return std::ranges::count_if(agents, [](const auto& agent) { return agent != nullptr; });
 	}
 
-	std::size_t size() const override { return agents.size(); }
+	std::size_t size() const override { return agents_count; }
 };
 
 } // namespace physicore
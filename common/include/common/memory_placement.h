@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+namespace physicore {
+
+// Size of a transparent huge page on x86-64 and most aarch64 configurations
+inline constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+// Asks the kernel to back the huge-page-aligned part of [data, data + bytes) by transparent huge pages
+// Pages faulted in afterwards are allocated as huge pages, already present ones are collapsed in the background
+inline void advise_huge_pages(const void* data, std::size_t bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	const auto begin = (reinterpret_cast<std::uintptr_t>(data) + huge_page_size - 1) / huge_page_size * huge_page_size;
+	const auto end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / huge_page_size * huge_page_size;
+
+	if (begin < end)
+		madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+#else
+	(void)data;
+	(void)bytes;
+#endif
+}
+
+struct huge_page_deleter
+{
+	std::align_val_t alignment;
+
+	void operator()(void* data) const { ::operator delete(data, alignment); }
+};
+
+template <typename T>
+using huge_page_array = std::unique_ptr<T[], huge_page_deleter>;
+
+/*
+Allocates an uninitialized array of n elements for placement by first touch.
+
+Arrays of at least a huge page are aligned to huge pages and advised to be backed by them, smaller ones are aligned to
+alignment. Nothing is written, so the pages land on the NUMA nodes of the threads that initialize them.
+*/
+template <typename T>
+huge_page_array<T> make_huge_page_array(std::size_t n, std::size_t alignment = alignof(T))
+{
+	static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+				  "Elements of a huge page array are left uninitialized");
+
+	const std::size_t bytes = n * sizeof(T);
+	const auto align = std::align_val_t(bytes >= huge_page_size ? huge_page_size : alignment);
+
+	void* data = ::operator new(bytes, align);
+
+	if (bytes >= huge_page_size)
+		advise_huge_pages(data, bytes);
+
+	return huge_page_array<T>(static_cast<T*>(data), huge_page_deleter { align });
+}
+
+// NUMA node the page holding data resides on, -1 if it is not resident or the platform can not tell
+inline int numa_node_of(const void* data)
+{
+#if defined(__linux__) && defined(SYS_move_pages)
+	void* page = const_cast<void*>(data);
+	int status = -1;
+
+	// with no target nodes move_pages only reports where the pages are
+	if (syscall(SYS_move_pages, 0, 1, &page, nullptr, &status, 0) != 0)
+		return -1;
+
+	return status >= 0 ? status : -1;
+#else
+	(void)data;
+	return -1;
+#endif
+}
+
+// NUMA node of the cpu the calling thread runs on, -1 if the platform can not tell
+inline int current_numa_node()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+	unsigned cpu = 0;
+	unsigned node = 0;
+
+	if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+		return -1;
+
+	return static_cast<int>(node);
+#else
+	return -1;
+#endif
+}
+
+} // namespace physicore
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "types.h"
+
+namespace physicore {
+
+// Spreads the lower 21 bits of value apart so that two zero bits follow each of them
+constexpr std::uint64_t spread_bits_by_3(std::uint64_t value)
+{
+	value &= 0x1fffff;
+	value = (value | value << 32) & 0x1f00000000ffff;
+	value = (value | value << 16) & 0x1f0000ff0000ff;
+	value = (value | value << 8) & 0x100f00f00f00f00f;
+	value = (value | value << 4) & 0x10c30c30c30c30c3;
+	value = (value | value << 2) & 0x1249249249249249;
+	return value;
+}
+
+// Morton (Z-order) key of a voxel, interleaving the bits of its coordinates with x least significant
+// Coordinates are limited to 21 bits, unused dimensions are expected to be 0
+constexpr std::uint64_t morton_key(std::array<index_t, 3> voxel)
+{
+	return spread_bits_by_3(voxel[0]) | spread_bits_by_3(voxel[1]) << 1 | spread_bits_by_3(voxel[2]) << 2;
+}
+
+} // namespace physicore
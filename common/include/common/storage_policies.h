@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "memory_placement.h"
+
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+/*
+Ready-made ContainerType policies for the agent data storage templates.
+
+Each policy is a std::vector with an allocator deciding where columns live:
+- aligned_vector aligns columns to simd_alignment, so vectorized loops start on a full register and cache line
+- huge_page_vector backs columns of at least a huge page by transparent huge pages, cutting TLB misses of agent loops
+- arena_vector allocates from a std::pmr::memory_resource, the one given to the agent data constructors or else the
+default one current when the column is constructed, so a whole population can be allocated from an arena and released
+at once between runs
+- mapped_vector backs columns by memory mapped files in mapped_storage_directory(), so populations larger than RAM are
+paged in and out by the kernel
+
+agent_column is the policy of the agent data used by the microenvironment, selected by the PHYSICORE_AGENT_STORAGE build
+option.
+*/
+
+namespace physicore {
+
+// Alignment of the widest SIMD registers (AVX-512) and of a cache line
+inline constexpr std::size_t simd_alignment = 64;
+
+template <typename T, std::size_t Alignment = simd_alignment>
+struct aligned_allocator
+{
+	using value_type = T;
+
+	template <typename U>
+	struct rebind
+	{
+		using other = aligned_allocator<U, Alignment>;
+	};
+
+	aligned_allocator() = default;
+
+	template <typename U>
+	aligned_allocator(const aligned_allocator<U, Alignment>&)
+	{}
+
+	T* allocate(std::size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+
+	void deallocate(T* data, std::size_t) { ::operator delete(data, std::align_val_t(Alignment)); }
+
+	template <typename U>
+	bool operator==(const aligned_allocator<U, Alignment>&) const
+	{
+		return true;
+	}
+};
+
+// Allocations of at least a huge page are aligned to huge pages and advised to be backed by them
+template <typename T>
+struct huge_page_allocator
+{
+	using value_type = T;
+
+	huge_page_allocator() = default;
+
+	template <typename U>
+	huge_page_allocator(const huge_page_allocator<U>&)
+	{}
+
+	T* allocate(std::size_t n)
+	{
+		const std::size_t bytes = n * sizeof(T);
+		void* data = ::operator new(bytes, alignment_of(bytes));
+
+		if (bytes >= huge_page_size)
+			advise_huge_pages(data, bytes);
+
+		return static_cast<T*>(data);
+	}
+
+	void deallocate(T* data, std::size_t n) { ::operator delete(data, alignment_of(n * sizeof(T))); }
+
+	template <typename U>
+	bool operator==(const huge_page_allocator<U>&) const
+	{
+		return true;
+	}
+
+private:
+	static std::align_val_t alignment_of(std::size_t bytes)
+	{
+		return std::align_val_t(bytes >= huge_page_size ? huge_page_size : simd_alignment);
+	}
+};
+
+// Directory holding the files of mapped_vector columns, the system temporary directory unless set
+// Columns allocated afterwards are placed in the directory currently set
+inline std::filesystem::path& mapped_storage_directory()
+{
+	static std::filesystem::path directory = std::filesystem::temp_directory_path();
+	return directory;
+}
+
+/*
+Backs each allocation by a file of its own, created in mapped_storage_directory() and unlinked right away, so the file
+is removed with the mapping. Pages are written back to the file instead of swap, which is what lets columns outgrow RAM.
+Platforms without mmap fall back to the heap.
+*/
+template <typename T>
+struct mapped_file_allocator
+{
+	using value_type = T;
+
+	mapped_file_allocator() = default;
+
+	template <typename U>
+	mapped_file_allocator(const mapped_file_allocator<U>&)
+	{}
+
+	T* allocate(std::size_t n)
+	{
+		const std::size_t bytes = n * sizeof(T);
+
+#ifdef __linux__
+		std::string path = (mapped_storage_directory() / "physicore-XXXXXX").string();
+
+		const int fd = mkstemp(path.data());
+		if (fd < 0)
+			throw std::bad_alloc();
+
+		unlink(path.c_str());
+
+		void* data = MAP_FAILED;
+		if (ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+			data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+		// the mapping keeps the file alive
+		close(fd);
+
+		if (data == MAP_FAILED)
+			throw std::bad_alloc();
+
+		return static_cast<T*>(data);
+#else
+		return static_cast<T*>(::operator new(bytes, std::align_val_t(alignof(T))));
+#endif
+	}
+
+	void deallocate(T* data, std::size_t n)
+	{
+#ifdef __linux__
+		munmap(data, n * sizeof(T));
+#else
+		(void)n;
+		::operator delete(data, std::align_val_t(alignof(T)));
+#endif
+	}
+
+	template <typename U>
+	bool operator==(const mapped_file_allocator<U>&) const
+	{
+		return true;
+	}
+};
+
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+template <typename T>
+using huge_page_vector = std::vector<T, huge_page_allocator<T>>;
+
+template <typename T>
+using arena_vector = std::pmr::vector<T>;
+
+template <typename T>
+using mapped_vector = std::vector<T, mapped_file_allocator<T>>;
+
+#if defined(PHYSICORE_AGENT_STORAGE_ALIGNED)
+template <typename T>
+using agent_column = aligned_vector<T>;
+#elif defined(PHYSICORE_AGENT_STORAGE_HUGE_PAGE)
+template <typename T>
+using agent_column = huge_page_vector<T>;
+#elif defined(PHYSICORE_AGENT_STORAGE_ARENA)
+template <typename T>
+using agent_column = arena_vector<T>;
+#elif defined(PHYSICORE_AGENT_STORAGE_MAPPED)
+template <typename T>
+using agent_column = mapped_vector<T>;
+#else
+template <typename T>
+using agent_column = std::vector<T>;
+#endif
+
+} // namespace physicore
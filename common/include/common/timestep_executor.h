@@ -1,17 +1,112 @@
 #pragma once
 
+#include <cassert>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+#include "data_access.h"
 #include "types.h"
+#include "worker_thread.h"
 
 namespace physicore {
 
+// Called after each finished step of a multi-step run with the index of the step within the run
+using step_callback = std::function<void(index_t step)>;
+
 class timestep_executor
 {
+	// started by the first asynchronous call and kept until stop_async
+	std::unique_ptr<worker_thread> worker_;
+
+protected:
+	// Runs the queued asynchronous tasks to completion and joins the worker thread
+	// Executors calling run_async must call it first thing in their destructor, while the overriders the queued tasks
+	// call are still alive, the base destructor runs only after the derived parts are gone
+	void stop_async() { worker_.reset(); }
+
 public:
 	virtual void run_single_timestep() = 0;
 
 	virtual void serialize_state(real_t current_time) = 0;
 
-	virtual ~timestep_executor() = default;
+	virtual real_t get_timestep() const = 0;
+
+	// Shared data arrays a timestep of this module reads and writes
+	virtual data_access get_timestep_access() const = 0;
+
+	// Shared data arrays serialization of this module reads
+	virtual data_access get_serialization_access() const = 0;
+
+	/*
+	Runs task on the executor's worker thread, a single persistent thread per executor, so parallel regions of the
+	module form its own thread team which is reused by all of its asynchronous calls. Tasks of one executor run in the
+	order they were submitted. Must be called from one controlling thread. Tasks still queued when the executor is
+	destroyed are run by its destructor, see stop_async.
+	*/
+	std::future<void> run_async(std::function<void()> task)
+	{
+		if (!worker_)
+			worker_ = std::make_unique<worker_thread>();
+
+		return worker_->submit(std::move(task));
+	}
+
+	// Launches a timestep on the worker thread
+	// The caller must make sure that concurrently running work does not conflict with get_timestep_access
+	std::future<void> run_single_timestep_async()
+	{
+		return run_async([this] { run_single_timestep(); });
+	}
+
+	std::future<void> serialize_state_async(real_t current_time)
+	{
+		return run_async([this, current_time] { serialize_state(current_time); });
+	}
+
+	// Runs the given number of timesteps, on_step (if set) is called by a single thread after each of them
+	// Executors may override it to keep their parallel resources alive across all the steps
+	virtual void run_steps(index_t steps, const step_callback& on_step = nullptr)
+	{
+		for (index_t step = 0; step < steps; step++)
+		{
+			run_single_timestep();
+
+			if (on_step)
+				on_step(step);
+		}
+	}
+
+	// Runs timesteps from current_time for as long as it is below end_time and returns the time reached
+	real_t run_until(real_t current_time, real_t end_time, const step_callback& on_step = nullptr)
+	{
+		const real_t timestep = get_timestep();
+
+		index_t steps = 0;
+		while (current_time < end_time - 1e-12)
+		{
+			current_time += timestep;
+			steps++;
+		}
+
+		run_steps(steps, on_step);
+
+		return current_time;
+	}
+
+	virtual ~timestep_executor() { assert(!worker_ && "executors using run_async must call stop_async in destructor"); }
 };
 
+// Runs timesteps of both modules concurrently, throws if their declared data accesses conflict
+inline void run_timesteps_concurrently(timestep_executor& a, timestep_executor& b)
+{
+	if (a.get_timestep_access().conflicts_with(b.get_timestep_access()))
+		throw std::runtime_error("Timesteps of the modules access the same data and cannot run concurrently");
+
+	auto step = a.run_single_timestep_async();
+	b.run_single_timestep();
+	step.get();
+}
+
 } // namespace physicore
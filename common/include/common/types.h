@@ -8,4 +8,11 @@ using real_t = double;
 using index_t = std::uint64_t;
 using sindex_t = std::int64_t;
 
+// Precision of stored agent parameters (rates, saturation densities, fractions), solvers widen them to real_t on load
+#ifdef PHYSICORE_FLOAT_AGENT_PARAMETERS
+using parameter_t = float;
+#else
+using parameter_t = real_t;
+#endif
+
 } // namespace physicore
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace physicore {
+
+/*
+A single long-lived thread running submitted tasks one after another in submission order.
+
+Parallel regions started by the tasks are forked from the same thread every time, so the OpenMP runtime keeps reusing
+one thread team (and its pinning) instead of creating a team for each new thread. Tasks queued when the worker is
+destroyed are still run before the thread is joined.
+*/
+class worker_thread
+{
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<std::packaged_task<void()>> tasks_;
+	bool stopping_ = false;
+
+	// started last, once the queue is initialized
+	std::thread thread_;
+
+	void loop()
+	{
+		while (true)
+		{
+			std::packaged_task<void()> task;
+
+			{
+				std::unique_lock lock(mutex_);
+				wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+
+				if (tasks_.empty())
+					return;
+
+				task = std::move(tasks_.front());
+				tasks_.pop_front();
+			}
+
+			// exceptions are stored in the task's future
+			task();
+		}
+	}
+
+public:
+	worker_thread() : thread_([this] { loop(); }) {}
+
+	worker_thread(const worker_thread&) = delete;
+	worker_thread& operator=(const worker_thread&) = delete;
+
+	// Queues task and returns a future that is ready (or holds the task's exception) once the task finished
+	std::future<void> submit(std::function<void()> task)
+	{
+		std::packaged_task<void()> packaged(std::move(task));
+		auto done = packaged.get_future();
+
+		{
+			std::lock_guard lock(mutex_);
+			tasks_.push_back(std::move(packaged));
+		}
+		wake_.notify_one();
+
+		return done;
+	}
+
+	~worker_thread()
+	{
+		{
+			std::lock_guard lock(mutex_);
+			stopping_ = true;
+		}
+		wake_.notify_one();
+
+		thread_.join();
+	}
+};
+
+} // namespace physicore
@@ -1,3 +1,6 @@
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "base_agent_container.h"
@@ -58,3 +61,214 @@ TEST_P(RemoveAgentTest, RemoveAgentsAndCheckPositions)
 }
 
 INSTANTIATE_TEST_SUITE_P(BaseAgentContainerTest, RemoveAgentTest, ::testing::Values(0, 1, 2));
+
+TEST(BaseAgentContainerTest, CreateN)
+{
+	base_agent_container container(std::make_unique<base_agent_data>());
+
+	auto first = container.create_n(3);
+	EXPECT_EQ(first.front(), 0);
+	EXPECT_EQ(first.size(), 3);
+
+	auto second = container.create_n(2);
+	EXPECT_EQ(second.front(), 3);
+	EXPECT_EQ(second.back(), 4);
+	EXPECT_EQ(container.size(), 5);
+	EXPECT_EQ(std::get<0>(container.agent_datas)->positions.size(), 5 * 3);
+
+	EXPECT_TRUE(container.create_n(0).empty());
+	EXPECT_EQ(container.size(), 5);
+}
+
+TEST(BaseAgentContainerTest, ReserveKeepsStorage)
+{
+	base_agent_container container(std::make_unique<base_agent_data>());
+	container.reserve(100);
+
+	const auto* positions = std::get<0>(container.agent_datas)->positions.data();
+
+	for (int i = 0; i < 100; ++i)
+		container.create();
+
+	EXPECT_EQ(std::get<0>(container.agent_datas)->positions.data(), positions);
+}
+
+class RemoveManyTest : public ::testing::TestWithParam<bool>
+{};
+
+TEST_P(RemoveManyTest, RemoveManyKeepsSurvivors)
+{
+	const bool preserve_order = GetParam();
+
+	base_agent_container container(std::make_unique<base_agent_data>());
+	container.create_n(8);
+
+	for (index_t i = 0; i < 8; ++i)
+		container.get_agent_at(i)->position()[0] = static_cast<real_t>(i);
+
+	const std::vector<index_t> removed = { 6, 1, 3, 1, 7 };
+	container.remove_many(removed, preserve_order);
+
+	ASSERT_EQ(container.size(), 4);
+	EXPECT_EQ(std::get<0>(container.agent_datas)->agents_count, 4);
+	EXPECT_EQ(std::get<0>(container.agent_datas)->positions.size(), 4 * 3);
+
+	std::vector<real_t> survivors;
+	for (index_t i = 0; i < container.size(); ++i)
+		survivors.push_back(container.get_agent_at(i)->position()[0]);
+
+	if (preserve_order)
+	{
+		EXPECT_EQ(survivors, (std::vector<real_t> { 0, 2, 4, 5 }));
+	}
+	else
+	{
+		std::ranges::sort(survivors);
+		EXPECT_EQ(survivors, (std::vector<real_t> { 0, 2, 4, 5 }));
+	}
+
+	// handles keep following their agents after further removals
+	auto* last = container.get_agent_at(3);
+	const real_t last_x = last->position()[0];
+	container.remove_at(0);
+	EXPECT_EQ(last->position()[0], last_x);
+	container.remove_agent(last);
+	EXPECT_EQ(container.size(), 2);
+}
+
+TEST_P(RemoveManyTest, CompactRemovesMarked)
+{
+	const bool preserve_order = GetParam();
+
+	base_agent_container container(std::make_unique<base_agent_data>());
+	container.create_n(5);
+
+	std::vector<base_agent*> agents;
+	for (index_t i = 0; i < 5; ++i)
+	{
+		agents.push_back(container.get_agent_at(i));
+		agents.back()->position()[1] = static_cast<real_t>(i);
+	}
+
+	container.mark_for_removal(0);
+	container.mark_for_removal(2);
+	container.mark_for_removal(0);
+
+	// marking defers removal
+	EXPECT_EQ(container.size(), 5);
+
+	container.compact(preserve_order);
+
+	ASSERT_EQ(container.size(), 3);
+	for (base_agent* agent : { agents[1], agents[3], agents[4] })
+	{
+		EXPECT_EQ(agent->position()[1], static_cast<real_t>(std::ranges::find(agents, agent) - agents.begin()));
+	}
+
+	if (preserve_order)
+	{
+		EXPECT_EQ(container.get_agent_at(0), agents[1]);
+		EXPECT_EQ(container.get_agent_at(1), agents[3]);
+		EXPECT_EQ(container.get_agent_at(2), agents[4]);
+	}
+
+	// nothing is marked anymore
+	container.compact(preserve_order);
+	EXPECT_EQ(container.size(), 3);
+}
+
+INSTANTIATE_TEST_SUITE_P(BaseAgentContainerTest, RemoveManyTest, ::testing::Values(false, true));
+
+TEST(BaseAgentContainerTest, HandlesAreCreatedOnDemand)
+{
+	base_agent_container container(std::make_unique<base_agent_data>());
+	container.create_n(1000);
+
+	EXPECT_EQ(container.size(), 1000);
+	EXPECT_EQ(container.handles_count(), 0);
+
+	for (index_t i : container.indices())
+		container.make_proxy(i).position()[0] = static_cast<real_t>(i);
+
+	EXPECT_EQ(container.handles_count(), 0);
+
+	auto* agent = container.get_agent_at(998);
+	EXPECT_EQ(container.handles_count(), 1);
+	EXPECT_EQ(container.get_agent_at(998), agent);
+	EXPECT_EQ(agent->position()[0], 998.0);
+
+	// the handle follows its agent, handle-free agents are moved by their data only
+	const std::vector<index_t> removed = { 0, 1, 2 };
+	container.remove_many(removed);
+
+	EXPECT_EQ(container.size(), 997);
+	EXPECT_EQ(container.handles_count(), 1);
+	EXPECT_EQ(agent->position()[0], 998.0);
+	EXPECT_EQ(container.make_proxy(0).position()[0], 997.0);
+
+	container.remove_agent(agent);
+	EXPECT_EQ(container.size(), 996);
+	EXPECT_EQ(container.handles_count(), 0);
+
+	container.remove_at(container.size() - 1);
+	EXPECT_EQ(container.size(), 995);
+}
+
+TEST(BaseAgentContainerTest, MaterializeHandles)
+{
+	base_agent_container container(std::make_unique<base_agent_data>());
+	container.create_n(100);
+
+	for (index_t i : container.indices())
+		container.make_proxy(i).position()[0] = static_cast<real_t>(i);
+
+	auto* existing = container.get_agent_at(42);
+
+	container.materialize_handles();
+	EXPECT_EQ(container.handles_count(), 100);
+	EXPECT_EQ(container.get_agent_at(42), existing);
+
+	// handles exist, so concurrent get_agent_at calls only read them
+	std::vector<base_agent*> handles(container.size());
+	std::vector<std::thread> readers;
+	for (index_t t = 0; t < 4; t++)
+		readers.emplace_back([&, t] {
+			for (index_t i = t; i < container.size(); i += 4)
+				handles[i] = container.get_agent_at(i);
+		});
+	for (auto& reader : readers)
+		reader.join();
+
+	for (index_t i : container.indices())
+	{
+		ASSERT_NE(handles[i], nullptr);
+		EXPECT_EQ(handles[i]->position()[0], static_cast<real_t>(i));
+	}
+
+	container.create_n(1);
+	EXPECT_EQ(container.handles_count(), 100);
+}
+
+TEST(BaseAgentContainerTest, Permute)
+{
+	base_agent_container container(std::make_unique<base_agent_data>());
+	container.create_n(4);
+
+	for (index_t i : container.indices())
+		container.make_proxy(i).position()[0] = static_cast<real_t>(i);
+
+	auto* agent = container.get_agent_at(3);
+
+	const std::vector<index_t> order = { 3, 0, 2, 1 };
+	container.permute(order);
+
+	for (index_t i : container.indices())
+		EXPECT_EQ(container.make_proxy(i).position()[0], static_cast<real_t>(order[i]));
+
+	EXPECT_EQ(container.get_agent_at(0), agent);
+	EXPECT_EQ(container.handles_count(), 1);
+
+	container.remove_agent(agent);
+	EXPECT_EQ(container.size(), 3);
+	EXPECT_EQ(container.make_proxy(0).position()[0], 1.0);
+}
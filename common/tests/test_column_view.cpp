@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base_agent_data.h"
+#include "column_view.h"
+
+using namespace physicore;
+
+TEST(ColumnViewTest, RowsAndValues)
+{
+	std::vector<real_t> values = { 0, 1, 2, 3, 4, 5 };
+	column_view view(values.data(), 3, 2);
+
+	static_assert(std::ranges::random_access_range<decltype(view)>);
+	static_assert(std::ranges::view<decltype(view)>);
+
+	ASSERT_EQ(view.size(), 3);
+	EXPECT_EQ(view.width(), 2);
+	EXPECT_EQ(view.values().size(), 6);
+	EXPECT_EQ(view[1][0], 2);
+	EXPECT_EQ(view[2][1], 5);
+
+	for (auto row : view)
+		row[0] = -row[1];
+
+	EXPECT_EQ(values, (std::vector<real_t> { -1, 1, -3, 3, -5, 5 }));
+
+	auto tail = view.subview(1, 2);
+	ASSERT_EQ(tail.size(), 2);
+	EXPECT_EQ(tail[0][1], 3);
+	EXPECT_EQ(tail.values().data(), values.data() + 2);
+}
+
+TEST(ColumnViewTest, ZipColumns)
+{
+	std::vector<real_t> pairs = { 0, 1, 2, 3, 4, 5 };
+	std::vector<real_t> scalars = { 10, 20, 30 };
+
+	auto zipped = zip_columns(column_view(pairs.data(), 3, 2), std::span(scalars));
+
+	static_assert(std::ranges::random_access_range<decltype(zipped)>);
+	ASSERT_EQ(std::ranges::size(zipped), 3);
+
+	for (auto [pair, scalar] : zipped)
+		scalar += pair[0] + pair[1];
+
+	EXPECT_EQ(scalars, (std::vector<real_t> { 11, 25, 39 }));
+}
+
+#ifndef NDEBUG
+TEST(ColumnViewTest, ZipColumnsOfDifferentLengths)
+{
+	std::vector<real_t> pairs = { 0, 1, 2, 3 };
+	std::vector<real_t> scalars = { 10, 20, 30 };
+
+	EXPECT_DEATH(zip_columns(column_view(pairs.data(), 2, 2), std::span(scalars)), "");
+}
+#endif
+
+TEST(ColumnViewTest, BaseAgentDataPositions)
+{
+	base_agent_data data(2);
+	data.add(3);
+
+	auto positions = data.column<base_columns::positions>();
+	ASSERT_EQ(positions.size(), 3);
+	EXPECT_EQ(positions.width(), 2);
+
+	std::ranges::fill(positions.values(), 1.0);
+	positions[2][1] = 7.0;
+
+	EXPECT_EQ(data.positions[5], 7.0);
+
+	const base_agent_data& const_data = data;
+	auto const_positions = const_data.column<base_columns::positions>();
+	static_assert(std::is_same_v<decltype(const_positions.values()), std::span<const real_t>>);
+	EXPECT_EQ(const_positions[0][0], 1.0);
+}
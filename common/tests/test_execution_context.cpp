@@ -0,0 +1,65 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "execution_context.h"
+
+using namespace physicore;
+
+TEST(ExecutionContextTest, ThreadsCount)
+{
+	EXPECT_EQ(execution_context().get_threads_count(), 0U);
+	EXPECT_EQ(execution_context(3).get_threads_count(), 3U);
+	EXPECT_EQ(execution_context(0, { 0, 1 }).get_threads_count(), 2U);
+	EXPECT_EQ(execution_context(4, { 0, 1 }).get_cpus().size(), 2U);
+}
+
+#ifdef __linux__
+TEST(ExecutionContextTest, PinCurrentThread)
+{
+	const execution_context context(1, { 0 });
+
+	std::thread worker([&] {
+		context.pin_current_thread(0);
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(set), &set), 0);
+		EXPECT_EQ(CPU_COUNT(&set), 1);
+		EXPECT_TRUE(CPU_ISSET(0, &set));
+	});
+	worker.join();
+}
+#endif
+
+#ifdef __linux__
+TEST(ExecutionContextTest, ScopedPinRestoresAffinity)
+{
+	const execution_context context(1, { 0 });
+
+	std::thread worker([&] {
+		cpu_set_t before;
+		CPU_ZERO(&before);
+		ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(before), &before), 0);
+
+		for (int repeat = 0; repeat < 2; repeat++)
+		{
+			{
+				const execution_context::scoped_pin pin(&context, 0, true);
+
+				cpu_set_t pinned;
+				CPU_ZERO(&pinned);
+				ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(pinned), &pinned), 0);
+				EXPECT_EQ(CPU_COUNT(&pinned), 1);
+				EXPECT_TRUE(CPU_ISSET(0, &pinned));
+			}
+
+			cpu_set_t after;
+			CPU_ZERO(&after);
+			ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(after), &after), 0);
+			EXPECT_TRUE(CPU_EQUAL(&before, &after));
+		}
+	});
+	worker.join();
+}
+#endif
@@ -0,0 +1,47 @@
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "execution_context.h"
+#include "memory_placement.h"
+
+using namespace physicore;
+
+TEST(MemoryPlacementTest, SmallArrayAlignment)
+{
+	auto array = make_huge_page_array<double>(100, 64);
+
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(array.get()) % 64, 0U);
+}
+
+TEST(MemoryPlacementTest, LargeArrayAlignedToHugePages)
+{
+	const std::size_t n = 2 * huge_page_size / sizeof(double);
+	auto array = make_huge_page_array<double>(n, 64);
+
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(array.get()) % huge_page_size, 0U);
+
+	for (std::size_t i = 0; i < n; i++)
+		array[i] = static_cast<double>(i);
+
+	EXPECT_EQ(array[n - 1], static_cast<double>(n - 1));
+}
+
+#ifdef __linux__
+TEST(MemoryPlacementTest, TouchedPageNode)
+{
+	// the thread must not migrate to another node between touching the page and asking for its node
+	const execution_context context(1, { static_cast<unsigned>(sched_getcpu()) });
+	const execution_context::scoped_pin pin(&context, 0, true);
+
+	// large enough to get fresh pages, a small array may reuse heap pages touched by another thread
+	auto array = make_huge_page_array<double>(huge_page_size / sizeof(double), 64);
+	array[0] = 1;
+
+	const int node = numa_node_of(array.get());
+	if (node < 0)
+		GTEST_SKIP() << "Page placement is not reported on this platform";
+
+	EXPECT_EQ(node, current_numa_node());
+}
+#endif
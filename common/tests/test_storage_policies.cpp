@@ -0,0 +1,125 @@
+#include <cstdint>
+#include <filesystem>
+#include <memory_resource>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base_agent_data_generic_storage.h"
+#include "storage_policies.h"
+
+using namespace physicore;
+
+TEST(StoragePoliciesTest, AlignedVectorAlignment)
+{
+	aligned_vector<double> column(3);
+	column.resize(1000);
+
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(column.data()) % simd_alignment, 0U);
+}
+
+TEST(StoragePoliciesTest, HugePageVectorAlignment)
+{
+	huge_page_vector<double> small(10);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(small.data()) % simd_alignment, 0U);
+
+	huge_page_vector<double> large(huge_page_size / sizeof(double));
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(large.data()) % huge_page_size, 0U);
+}
+
+TEST(StoragePoliciesTest, MappedVectorLeavesNoFiles)
+{
+	const auto directory = std::filesystem::temp_directory_path() / "physicore_mapped_storage_test";
+	std::filesystem::create_directories(directory);
+
+	const auto previous = mapped_storage_directory();
+	mapped_storage_directory() = directory;
+
+	{
+		mapped_vector<double> column;
+		for (index_t i = 0; i < 10000; i++)
+			column.push_back(static_cast<double>(i));
+
+		EXPECT_EQ(column[9999], 9999.0);
+		EXPECT_TRUE(std::filesystem::is_empty(directory));
+	}
+
+	mapped_storage_directory() = previous;
+	std::filesystem::remove_all(directory);
+}
+
+TEST(StoragePoliciesTest, ArenaColumnsStayInTheirResource)
+{
+	std::pmr::monotonic_buffer_resource arena;
+	auto* previous = std::pmr::set_default_resource(&arena);
+
+	base_agent_data_generic_storage<arena_vector> data(1);
+
+	std::pmr::set_default_resource(previous);
+
+	data.add(3);
+	for (index_t i = 0; i < 3; i++)
+		data.positions[i] = static_cast<real_t>(i);
+
+	const std::vector<index_t> order = { 2, 0, 1 };
+	data.permute(order);
+
+	EXPECT_EQ(data.positions.get_allocator().resource(), &arena);
+	EXPECT_EQ(data.positions[0], 2.0);
+	EXPECT_EQ(data.positions[1], 0.0);
+	EXPECT_EQ(data.positions[2], 1.0);
+}
+
+TEST(StoragePoliciesTest, ArenaColumnsUseGivenResource)
+{
+	std::pmr::monotonic_buffer_resource arena;
+
+	base_agent_data_generic_storage<arena_vector> data(1, &arena);
+	data.add(3);
+
+	EXPECT_EQ(data.positions.get_allocator().resource(), &arena);
+	EXPECT_NE(std::pmr::get_default_resource(), &arena);
+
+	// policies without a memory resource ignore it
+	base_agent_data_generic_storage<aligned_vector> aligned(1, &arena);
+	aligned.add(3);
+	EXPECT_EQ(aligned.positions.size(), 3);
+}
+
+template <typename T>
+class StoragePolicyDataTest : public ::testing::Test
+{};
+
+template <template <typename...> typename ContainerType>
+struct policy
+{
+	using data_type = base_agent_data_generic_storage<ContainerType>;
+};
+
+using policies = ::testing::Types<policy<aligned_vector>, policy<huge_page_vector>, policy<mapped_vector>,
+								  policy<arena_vector>>;
+TYPED_TEST_SUITE(StoragePolicyDataTest, policies);
+
+TYPED_TEST(StoragePolicyDataTest, AddPermuteRemove)
+{
+	typename TypeParam::data_type data(2);
+
+	data.add(3);
+	for (index_t i = 0; i < 6; i++)
+		data.positions[i] = static_cast<real_t>(i);
+
+	// solvers hold pointers to the columns across permutations
+	const auto* positions = data.positions.data();
+
+	const std::vector<index_t> order = { 1, 2, 0 };
+	data.permute(order);
+	EXPECT_EQ(data.positions.data(), positions);
+
+	data.remove_at(0);
+
+	ASSERT_EQ(data.agents_count, 2);
+	EXPECT_EQ(data.positions[0], 0.0);
+	EXPECT_EQ(data.positions[1], 1.0);
+	EXPECT_EQ(data.positions[2], 4.0);
+	EXPECT_EQ(data.positions[3], 5.0);
+}
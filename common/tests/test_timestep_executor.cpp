@@ -0,0 +1,180 @@
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "timestep_executor.h"
+
+using namespace physicore;
+
+namespace {
+class counting_executor : public timestep_executor
+{
+public:
+	index_t steps_run = 0;
+
+	~counting_executor() override { stop_async(); }
+
+	void run_single_timestep() override { steps_run++; }
+	void serialize_state(real_t /*current_time*/) override {}
+	real_t get_timestep() const override { return 0.1; }
+	data_access get_timestep_access() const override { return access; }
+	data_access get_serialization_access() const override { return { .reads = access.writes, .writes = {} }; }
+
+	data_access access;
+};
+} // namespace
+
+TEST(TimestepExecutorTest, RunSteps)
+{
+	counting_executor e;
+
+	std::vector<index_t> callbacks;
+	e.run_steps(4, [&](index_t step) {
+		EXPECT_EQ(e.steps_run, step + 1);
+		callbacks.push_back(step);
+	});
+
+	EXPECT_EQ(e.steps_run, 4U);
+	EXPECT_EQ(callbacks, (std::vector<index_t> { 0, 1, 2, 3 }));
+
+	e.run_steps(2);
+	EXPECT_EQ(e.steps_run, 6U);
+}
+
+TEST(TimestepExecutorTest, RunUntil)
+{
+	counting_executor e;
+
+	// 0.1 is not exactly representable, the end time must still be reached in 10 steps
+	const real_t reached = e.run_until(0, 1);
+
+	EXPECT_EQ(e.steps_run, 10U);
+	EXPECT_NEAR(reached, 1, 1e-9);
+
+	e.run_until(reached, reached);
+	EXPECT_EQ(e.steps_run, 10U);
+}
+
+TEST(TimestepExecutorTest, DataAccessConflicts)
+{
+	const data_access diffusion { .reads = { "positions", "volumes" }, .writes = { "densities" } };
+	const data_access mechanics { .reads = { "positions" }, .writes = { "positions" } };
+	const data_access phenotype { .reads = { "volumes" }, .writes = { "cycle" } };
+
+	EXPECT_TRUE(diffusion.conflicts_with(mechanics));
+	EXPECT_TRUE(mechanics.conflicts_with(diffusion));
+	EXPECT_FALSE(diffusion.conflicts_with(phenotype));
+	EXPECT_TRUE(phenotype.conflicts_with(phenotype));
+}
+
+TEST(TimestepExecutorTest, AsyncTimestep)
+{
+	counting_executor e;
+
+	auto step = e.run_single_timestep_async();
+	step.get();
+
+	EXPECT_EQ(e.steps_run, 1U);
+}
+
+TEST(TimestepExecutorTest, AsyncCallsShareOneWorkerThread)
+{
+	class thread_recording_executor : public counting_executor
+	{
+	public:
+		std::vector<std::thread::id> threads;
+
+		~thread_recording_executor() override { stop_async(); }
+
+		void run_single_timestep() override
+		{
+			threads.push_back(std::this_thread::get_id());
+			counting_executor::run_single_timestep();
+		}
+		void serialize_state(real_t /*current_time*/) override { threads.push_back(std::this_thread::get_id()); }
+	};
+
+	thread_recording_executor e;
+
+	std::vector<std::future<void>> done;
+	for (index_t i = 0; i < 3; i++)
+	{
+		done.push_back(e.run_single_timestep_async());
+		done.push_back(e.serialize_state_async(0));
+	}
+	for (auto& d : done)
+		d.get();
+
+	ASSERT_EQ(e.threads.size(), 6U);
+	EXPECT_EQ(e.steps_run, 3U);
+	for (const auto& id : e.threads)
+	{
+		EXPECT_EQ(id, e.threads.front());
+		EXPECT_NE(id, std::this_thread::get_id());
+	}
+}
+
+TEST(TimestepExecutorTest, AsyncExceptionIsForwarded)
+{
+	counting_executor e;
+
+	auto done = e.run_async([] { throw std::runtime_error("step failed"); });
+	EXPECT_THROW(done.get(), std::runtime_error);
+
+	// the worker survives a failed task
+	e.run_single_timestep_async().get();
+	EXPECT_EQ(e.steps_run, 1U);
+}
+
+TEST(TimestepExecutorTest, DestructorRunsQueuedTasks)
+{
+	// counts the steps outside of itself, they must all run on the complete object
+	class external_counting_executor : public counting_executor
+	{
+		index_t& steps_;
+
+	public:
+		explicit external_counting_executor(index_t& steps) : steps_(steps) {}
+
+		~external_counting_executor() override { stop_async(); }
+
+		void run_single_timestep() override { steps_++; }
+	};
+
+	index_t steps = 0;
+	std::promise<void> unblock;
+
+	{
+		external_counting_executor e(steps);
+
+		// the worker is held back until the executor is being destroyed with its steps still queued
+		auto blocked = e.run_async([released = unblock.get_future().share()] { released.wait(); });
+		for (index_t i = 0; i < 3; i++)
+			e.run_single_timestep_async();
+
+		unblock.set_value();
+	}
+
+	EXPECT_EQ(steps, 3U);
+}
+
+TEST(TimestepExecutorTest, RunTimestepsConcurrently)
+{
+	counting_executor a;
+	a.access = { .reads = { "positions" }, .writes = { "densities" } };
+	counting_executor b;
+	b.access = { .reads = { "positions" }, .writes = { "cycle" } };
+
+	run_timesteps_concurrently(a, b);
+
+	EXPECT_EQ(a.steps_run, 1U);
+	EXPECT_EQ(b.steps_run, 1U);
+
+	b.access.writes.insert("positions");
+
+	EXPECT_THROW(run_timesteps_concurrently(a, b), std::runtime_error);
+	EXPECT_EQ(a.steps_run, 1U);
+}
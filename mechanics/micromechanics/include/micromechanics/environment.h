@@ -12,9 +12,16 @@ class environment : public timestep_executor
 public:
 	explicit environment(real_t timestep) : timestep(timestep) {}
 
+	~environment() override { stop_async(); }
+
 	void run_single_timestep() override;
 
 	void serialize_state(real_t current_time) override;
+
+	real_t get_timestep() const override;
+
+	data_access get_timestep_access() const override;
+	data_access get_serialization_access() const override;
 };
 
 } // namespace physicore::mechanics::micromechanics
@@ -1,5 +1,6 @@
 #include "environment.h"
 
+using namespace physicore;
 using namespace physicore::mechanics::micromechanics;
 
 void environment::run_single_timestep()
@@ -10,3 +11,9 @@ void environment::run_single_timestep()
 }
 
 void environment::serialize_state(real_t current_time) { (void)current_time; }
+
+real_t environment::get_timestep() const { return timestep; }
+
+data_access environment::get_timestep_access() const { return { .reads = { "positions" }, .writes = { "positions" } }; }
+
+data_access environment::get_serialization_access() const { return { .reads = { "positions" }, .writes = {} }; }
@@ -1,11 +1,46 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include <biofvm/config_reader.h>
 #include <biofvm/microenvironment.h>
+#include <micromechanics/environment.h>
+
+#include "scheduler.h"
 
 using namespace physicore;
 
 int main(int argc, char** argv)
 {
-	(void)argv;
-	(void)argc;
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <settings.xml> [output_interval]" << std::endl;
+		return 1;
+	}
+
+	try
+	{
+		const auto config = parse_physicell_config(argv[1]);
+
+		auto microenvironment = biofvm::microenvironment::create_from_config(argv[1]);
+		mechanics::micromechanics::environment mechanics(config.overall.dt_mechanics);
+
+		phenotype::physicore::scheduler scheduler;
+		scheduler.add_module("diffusion", *microenvironment);
+		scheduler.add_module("mechanics", mechanics);
+
+		if (argc > 2)
+			scheduler.set_output_interval(std::stod(argv[2]));
+
+		scheduler.run(config.overall.max_time);
+
+		scheduler.print_report(std::cout);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
 
 	return 0;
 }
@@ -0,0 +1,192 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+
+using namespace physicore;
+using namespace physicore::phenotype::physicore;
+
+namespace {
+constexpr real_t time_epsilon = 1e-12;
+
+// Whether step finishing at time a of module i goes before step finishing at time b of module j
+bool goes_before(real_t a, index_t i, real_t b, index_t j)
+{
+	if (a < b - time_epsilon)
+		return true;
+	if (a > b + time_epsilon)
+		return false;
+	return i < j;
+}
+} // namespace
+
+void scheduler::add_module(std::string name, timestep_executor& executor)
+{
+	const real_t timestep = executor.get_timestep();
+
+	if (timestep <= 0)
+		throw std::runtime_error("Timestep of module " + name + " must be positive");
+
+	modules_.push_back({ .name = std::move(name), .executor = &executor, .timestep = timestep });
+}
+
+void scheduler::set_output_interval(real_t interval)
+{
+	if (interval < 0)
+		throw std::runtime_error("Output interval must not be negative");
+
+	output_interval_ = interval;
+}
+
+index_t scheduler::next_module(real_t end_time) const
+{
+	index_t next = modules_.size();
+
+	for (index_t i = 0; i < modules_.size(); i++)
+	{
+		const auto& m = modules_[i];
+
+		if (m.current_time >= end_time - time_epsilon)
+			continue;
+
+		if (next == modules_.size()
+			|| goes_before(m.current_time + m.timestep, i, modules_[next].current_time + modules_[next].timestep,
+						   next))
+			next = i;
+	}
+
+	return next;
+}
+
+index_t scheduler::batchable_steps(index_t m, real_t end_time) const
+{
+	const auto& module = modules_[m];
+
+	index_t steps = 1;
+	real_t time = module.current_time + module.timestep;
+
+	while (time < end_time - time_epsilon)
+	{
+		const real_t next_end = time + module.timestep;
+
+		// batches do not cross the output time, so the state is serialized as soon as all modules reach it
+		if (output_interval_ > 0 && time <= next_output_time_ + time_epsilon
+			&& next_end > next_output_time_ + time_epsilon)
+			break;
+
+		bool others_first = false;
+		for (index_t j = 0; j < modules_.size(); j++)
+		{
+			const auto& other = modules_[j];
+
+			if (j != m && other.current_time < end_time - time_epsilon
+				&& goes_before(other.current_time + other.timestep, j, next_end, m))
+				others_first = true;
+		}
+
+		if (others_first)
+			break;
+
+		time = next_end;
+		steps++;
+	}
+
+	return steps;
+}
+
+void scheduler::wait_for_conflicting(const data_access& access)
+{
+	std::erase_if(pending_, [&](pending_serialization& p) {
+		if (!p.access.conflicts_with(access))
+			return false;
+		p.done.get();
+		return true;
+	});
+}
+
+void scheduler::serialize_all(real_t current_time)
+{
+	// outputs of a module must not overlap each other
+	for (auto& p : pending_)
+		p.done.get();
+	pending_.clear();
+
+	for (auto& m : modules_)
+		pending_.push_back({ .access = m.executor->get_serialization_access(),
+							 .done = m.executor->run_async([&m, current_time] {
+								 const auto start = std::chrono::steady_clock::now();
+								 m.executor->serialize_state(current_time);
+								 m.serialization_time += std::chrono::steady_clock::now() - start;
+							 }) });
+}
+
+void scheduler::run(real_t end_time)
+{
+	next_output_time_ = modules_.empty() ? 0 : modules_.front().current_time;
+
+	if (output_interval_ > 0)
+	{
+		serialize_all(next_output_time_);
+		next_output_time_ += output_interval_;
+	}
+
+	for (index_t m = next_module(end_time); m < modules_.size(); m = next_module(end_time))
+	{
+		auto& module = modules_[m];
+
+		const index_t steps = batchable_steps(m, end_time);
+
+		wait_for_conflicting(module.executor->get_timestep_access());
+
+		const auto start = std::chrono::steady_clock::now();
+		module.executor->run_steps(steps);
+		module.compute_time += std::chrono::steady_clock::now() - start;
+
+		for (index_t i = 0; i < steps; i++)
+			module.current_time += module.timestep;
+		module.steps += steps;
+		module.calls++;
+
+		if (output_interval_ <= 0)
+			continue;
+
+		real_t reached = std::numeric_limits<real_t>::max();
+		for (const auto& other : modules_)
+			reached = std::min(reached, other.current_time);
+
+		if (reached + time_epsilon >= next_output_time_)
+		{
+			serialize_all(reached);
+
+			// a module with a longer timestep than the interval may have jumped over several output times
+			while (next_output_time_ <= reached + time_epsilon)
+				next_output_time_ += output_interval_;
+		}
+	}
+
+	for (auto& p : pending_)
+		p.done.get();
+	pending_.clear();
+}
+
+void scheduler::print_report(std::ostream& os) const
+{
+	std::chrono::duration<double> total { 0 };
+	for (const auto& m : modules_)
+		total += m.compute_time + m.serialization_time;
+
+	auto share = [&](std::chrono::duration<double> time) {
+		return total.count() > 0 ? 100 * time.count() / total.count() : 0.0;
+	};
+
+	os << "Module time shares (total " << total.count() << " s):" << std::endl;
+
+	for (const auto& m : modules_)
+		os << "  " << std::left << std::setw(16) << m.name << std::right << " dt " << m.timestep << ", " << m.steps
+		   << " steps in " << m.calls << " calls, compute " << std::fixed << std::setprecision(3)
+		   << m.compute_time.count() << " s (" << std::setprecision(1) << share(m.compute_time)
+		   << " %), serialization " << std::setprecision(3) << m.serialization_time.count() << " s ("
+		   << std::setprecision(1) << share(m.serialization_time) << " %)" << std::defaultfloat << std::endl;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <common/data_access.h>
+#include <common/timestep_executor.h>
+#include <common/types.h>
+
+/*
+Advances modules running at different timesteps to a common end time.
+
+Module i has reached time t_i and its next step finishes at t_i + dt_i. The module whose next step finishes first (the
+earlier added one on ties) is advanced, and it keeps stepping within a single run_steps call for as long as its steps
+finish before the next step of any other module and before the next output time. The finest module (diffusion) is
+thus advanced in batches between the steps of the coarser ones.
+
+State of all modules is serialized every output interval. Serialization runs asynchronously, a timestep of a module
+only waits for the serializations that read data the timestep writes.
+*/
+
+namespace physicore::phenotype::physicore {
+
+class scheduler
+{
+	struct module
+	{
+		std::string name;
+		timestep_executor* executor;
+		real_t timestep;
+		real_t current_time = 0;
+		index_t steps = 0;
+		index_t calls = 0;
+		std::chrono::duration<double> compute_time { 0 };
+		std::chrono::duration<double> serialization_time { 0 };
+	};
+
+	struct pending_serialization
+	{
+		data_access access;
+		std::future<void> done;
+	};
+
+	std::vector<module> modules_;
+	std::vector<pending_serialization> pending_;
+
+	// 0 disables the output
+	real_t output_interval_ = 0;
+	real_t next_output_time_ = 0;
+
+	index_t next_module(real_t end_time) const;
+	index_t batchable_steps(index_t m, real_t end_time) const;
+
+	void serialize_all(real_t current_time);
+	void wait_for_conflicting(const data_access& access);
+
+public:
+	// Modules run in their own timestep (executor.get_timestep()), the order of adding breaks ties
+	void add_module(std::string name, timestep_executor& executor);
+
+	void set_output_interval(real_t interval);
+
+	// Advances all modules until each of them reaches end_time
+	void run(real_t end_time);
+
+	// Steps, run_steps calls and share of the total compute and serialization time per module
+	void print_report(std::ostream& os) const;
+};
+
+} // namespace physicore::phenotype::physicore
@@ -0,0 +1,253 @@
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "scheduler.h"
+
+using namespace physicore;
+using namespace physicore::phenotype::physicore;
+
+namespace {
+struct event
+{
+	std::string module;
+	std::string kind;
+	index_t steps = 0;
+	real_t time = 0;
+
+	bool operator==(const event&) const = default;
+};
+
+std::ostream& operator<<(std::ostream& os, const event& e)
+{
+	return os << e.module << " " << e.kind << " " << e.steps << " " << e.time;
+}
+
+// Events of all modules in the order they happened, serializations are recorded from the worker threads
+class event_log
+{
+	std::mutex mutex_;
+	std::vector<event> events_;
+
+public:
+	void record(event e)
+	{
+		std::lock_guard lock(mutex_);
+		events_.push_back(std::move(e));
+	}
+
+	std::vector<event> events()
+	{
+		std::lock_guard lock(mutex_);
+		return events_;
+	}
+
+	std::vector<event> events_of_kind(const std::string& kind)
+	{
+		std::vector<event> selected;
+		for (const auto& e : events())
+			if (e.kind == kind)
+				selected.push_back(e);
+		return selected;
+	}
+};
+
+// Records the run_steps calls and serializations of a module declaring that it reads and writes array
+class recording_executor : public timestep_executor
+{
+	std::string name_;
+	real_t timestep_;
+	std::string array_;
+
+protected:
+	event_log& log_;
+
+public:
+	recording_executor(std::string name, real_t timestep, std::string array, event_log& log)
+		: name_(std::move(name)), timestep_(timestep), array_(std::move(array)), log_(log)
+	{}
+
+	~recording_executor() override { stop_async(); }
+
+	void run_single_timestep() override { log_.record({ .module = name_, .kind = "steps", .steps = 1 }); }
+
+	void run_steps(index_t steps, const step_callback& /*on_step*/) override
+	{
+		log_.record({ .module = name_, .kind = "steps", .steps = steps });
+	}
+
+	void serialize_state(real_t current_time) override
+	{
+		log_.record({ .module = name_, .kind = "serialize", .time = current_time });
+	}
+
+	real_t get_timestep() const override { return timestep_; }
+
+	data_access get_timestep_access() const override { return { .reads = { array_ }, .writes = { array_ } }; }
+
+	data_access get_serialization_access() const override { return { .reads = { array_ }, .writes = {} }; }
+};
+} // namespace
+
+TEST(SchedulerTest, FineModuleIsBatchedBetweenCoarseSteps)
+{
+	event_log log;
+	recording_executor diffusion("diffusion", 0.25, "densities", log);
+	recording_executor mechanics("mechanics", 1, "positions", log);
+
+	scheduler s;
+	s.add_module("diffusion", diffusion);
+	s.add_module("mechanics", mechanics);
+
+	s.run(2);
+
+	// on the tie at each full time unit the earlier added diffusion goes first
+	const std::vector<event> expected = { { "diffusion", "steps", 4, 0 },
+										  { "mechanics", "steps", 1, 0 },
+										  { "diffusion", "steps", 4, 0 },
+										  { "mechanics", "steps", 1, 0 } };
+	EXPECT_EQ(log.events(), expected);
+}
+
+TEST(SchedulerTest, AddingOrderBreaksTies)
+{
+	event_log log;
+	recording_executor mechanics("mechanics", 1, "positions", log);
+	recording_executor diffusion("diffusion", 0.5, "densities", log);
+
+	scheduler s;
+	s.add_module("mechanics", mechanics);
+	s.add_module("diffusion", diffusion);
+
+	s.run(2);
+
+	// diffusion's step finishing at 1 ties with mechanics' and goes after it
+	const std::vector<event> expected = { { "diffusion", "steps", 1, 0 },
+										  { "mechanics", "steps", 1, 0 },
+										  { "diffusion", "steps", 2, 0 },
+										  { "mechanics", "steps", 1, 0 },
+										  { "diffusion", "steps", 1, 0 } };
+	EXPECT_EQ(log.events(), expected);
+}
+
+TEST(SchedulerTest, BatchesStopAtOutputTimes)
+{
+	event_log log;
+	recording_executor diffusion("diffusion", 0.25, "densities", log);
+	recording_executor mechanics("mechanics", 1, "positions", log);
+
+	scheduler s;
+	s.add_module("diffusion", diffusion);
+	s.add_module("mechanics", mechanics);
+	s.set_output_interval(0.5);
+
+	s.run(2);
+
+	std::vector<index_t> diffusion_batches;
+	for (const auto& e : log.events_of_kind("steps"))
+		if (e.module == "diffusion")
+			diffusion_batches.push_back(e.steps);
+
+	EXPECT_EQ(diffusion_batches, (std::vector<index_t> { 2, 2, 2, 2 }));
+
+	// the state is serialized once all modules reach an output time, mechanics reaches 0.5 only at 1
+	std::vector<real_t> diffusion_outputs;
+	std::vector<real_t> mechanics_outputs;
+	for (const auto& e : log.events_of_kind("serialize"))
+		(e.module == "diffusion" ? diffusion_outputs : mechanics_outputs).push_back(e.time);
+
+	EXPECT_EQ(diffusion_outputs, (std::vector<real_t> { 0, 1, 2 }));
+	EXPECT_EQ(mechanics_outputs, (std::vector<real_t> { 0, 1, 2 }));
+}
+
+TEST(SchedulerTest, StepsWaitOnlyForConflictingSerializations)
+{
+	std::promise<void> mechanics_stepped;
+	auto mechanics_stepped_future = mechanics_stepped.get_future().share();
+
+	event_log log;
+
+	// serialization of diffusion completes only after the step of mechanics started, which must thus not wait for it
+	class blocking_executor : public recording_executor
+	{
+		std::shared_future<void> unblock_;
+
+	public:
+		blocking_executor(std::shared_future<void> unblock, event_log& log)
+			: recording_executor("diffusion", 1, "densities", log), unblock_(std::move(unblock))
+		{}
+
+		~blocking_executor() override { stop_async(); }
+
+		void serialize_state(real_t current_time) override
+		{
+			const bool overlapped = unblock_.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+			log_.record({ .module = "diffusion", .kind = overlapped ? "serialize" : "serialize blocked",
+						  .time = current_time });
+		}
+	};
+
+	class signalling_executor : public recording_executor
+	{
+		std::promise<void>& stepped_;
+
+	public:
+		signalling_executor(std::promise<void>& stepped, event_log& log)
+			: recording_executor("mechanics", 1, "positions", log), stepped_(stepped)
+		{}
+
+		void run_steps(index_t steps, const step_callback& on_step) override
+		{
+			recording_executor::run_steps(steps, on_step);
+			stepped_.set_value();
+		}
+	};
+
+	signalling_executor mechanics(mechanics_stepped, log);
+	blocking_executor diffusion(mechanics_stepped_future, log);
+
+	scheduler s;
+	s.add_module("mechanics", mechanics);
+	s.add_module("diffusion", diffusion);
+	s.set_output_interval(1);
+
+	s.run(1);
+
+	const auto events = log.events();
+
+	auto position = [&](const std::string& module, const std::string& kind, real_t time) {
+		for (index_t i = 0; i < events.size(); i++)
+			if (events[i].module == module && events[i].kind == kind && events[i].time == time)
+				return i;
+		return events.size();
+	};
+
+	const index_t mechanics_step = position("mechanics", "steps", 0);
+	const index_t diffusion_output = position("diffusion", "serialize", 0);
+	const index_t diffusion_step = position("diffusion", "steps", 0);
+
+	ASSERT_LT(mechanics_step, events.size());
+	ASSERT_LT(diffusion_output, events.size()) << "serialization of diffusion blocked the step of mechanics";
+	ASSERT_LT(diffusion_step, events.size());
+
+	// mechanics overlapped the serialization of diffusion, diffusion's own step waited for it
+	EXPECT_LT(mechanics_step, diffusion_output);
+	EXPECT_LT(diffusion_output, diffusion_step);
+
+	EXPECT_LT(position("diffusion", "serialize", 1), events.size());
+	EXPECT_LT(position("mechanics", "serialize", 1), events.size());
+}
+
+TEST(SchedulerTest, InvalidConfiguration)
+{
+	event_log log;
+	recording_executor frozen("frozen", 0, "positions", log);
+
+	scheduler s;
+	EXPECT_THROW(s.add_module("frozen", frozen), std::runtime_error);
+	EXPECT_THROW(s.set_output_interval(-1), std::runtime_error);
+}
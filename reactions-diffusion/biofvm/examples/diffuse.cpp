@@ -73,45 +73,46 @@ int main()
 												.volume = 2100.0,
 												.count = 26 } };
 
+	auto& agents = dynamic_cast<agent_container&>(*m->agents);
+	auto& base_data = *std::get<std::unique_ptr<base_agent_data>>(agents.agent_datas);
+	auto& data = *std::get<std::unique_ptr<agent_data>>(agents.agent_datas);
+
 	for (const auto& group : groups)
 	{
-		for (int i = 0; i < group.count; ++i)
+		const index_t first = agents.size();
+		const auto count = static_cast<index_t>(group.count);
+
+		// new agents start with zero rates and densities, views are taken after creating as it may reallocate columns
+		agents.create_n(count);
+
+		auto group_agents = zip_columns(base_data.column<columns::positions>().subview(first, count),
+										data.column<columns::saturation_densities>().subview(first, count),
+										data.column<columns::uptake_rates>().subview(first, count),
+										data.column<columns::secretion_rates>().subview(first, count),
+										data.column<columns::volumes>().subspan(first, count));
+
+		for (auto [position, saturation, uptake, secretion, volume] : group_agents)
 		{
-			auto* a = m->agents->create();
-			auto position = a->position();
 			for (std::size_t dim = 0; dim < position.size(); ++dim)
 			{
 				const real_t displacement = offset(rng) * group.radius;
 				position[dim] = group.center[dim] + displacement;
 			}
 
-			auto saturation = a->saturation_densities();
 			saturation[oxygen_idx] = group.saturation[0];
 			saturation[glucose_idx] = group.saturation[1];
 
-			auto uptake = a->uptake_rates();
 			uptake[oxygen_idx] = group.uptake[0];
 			uptake[glucose_idx] = group.uptake[1];
 
-			auto secretion = a->secretion_rates();
-			std::ranges::fill(secretion, 0.0);
 			secretion[oxygen_idx] = group.secretion[0];
 			secretion[glucose_idx] = group.secretion[1];
 
-			auto net_export = a->net_export_rates();
-			std::ranges::fill(net_export, 0.0);
-
-			auto internalized = a->internalized_substrates();
-			std::ranges::fill(internalized, 0.0);
-
-			auto release_fraction = a->fraction_released_at_death();
-			std::ranges::fill(release_fraction, 0.0);
-
-			auto transfer_fraction = a->fraction_transferred_when_ingested();
-			std::ranges::fill(transfer_fraction, 0.0);
-
-			a->volume() = group.volume;
+			volume = group.volume;
 		}
+
+		std::ranges::fill(data.column<columns::fraction_transferred_when_ingested>().subview(first, count).values(),
+						  0.0);
 	}
 
 	real_t current_time = 0.0;
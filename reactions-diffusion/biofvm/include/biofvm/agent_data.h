@@ -1,9 +1,11 @@
 #pragma once
 
+#include <common/storage_policies.h>
+
 #include "agent_data_generic_storage.h"
 
 namespace physicore::biofvm {
 
-using agent_data = agent_data_generic_storage<std::vector>;
+using agent_data = agent_data_generic_storage<agent_column>;
 
 }
@@ -1,5 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <common/base_agent_data.h>
@@ -7,22 +15,26 @@
 
 namespace physicore::biofvm {
 
+// Parameter columns are stored in parameter_t (see PHYSICORE_FLOAT_AGENT_PARAMETERS), state accumulated over time
+// (internalized substrates, volumes and positions) always in real_t
 template <template <typename...> typename ContainerType = std::vector>
 struct agent_data_generic_storage
 {
 public:
 	physicore::base_agent_data_generic_storage<ContainerType>& base_data;
 
-	// n * substrate_count
-	ContainerType<real_t> secretion_rates;
-	ContainerType<real_t> saturation_densities;
-	ContainerType<real_t> uptake_rates;
-	ContainerType<real_t> net_export_rates;
+	// parameter columns, n * substrate_count or parameters_count() * substrate_count with shared parameters
+	ContainerType<parameter_t> secretion_rates;
+	ContainerType<parameter_t> saturation_densities;
+	ContainerType<parameter_t> uptake_rates;
+	ContainerType<parameter_t> net_export_rates;
 
 	// n * substrate_count
 	ContainerType<real_t> internalized_substrates;
-	ContainerType<real_t> fraction_released_at_death;
-	ContainerType<real_t> fraction_transferred_when_ingested;
+
+	// parameter columns
+	ContainerType<parameter_t> fraction_released_at_death;
+	ContainerType<parameter_t> fraction_transferred_when_ingested;
 
 	// n
 	ContainerType<real_t> volumes;
@@ -30,38 +42,222 @@ public:
 	// n - boolean flag indicating if agent is active (1) or inactive (0)
 	ContainerType<uint8_t> is_active;
 
+	// ascending indices of the active agents, so agent loops skip inactive ones without branching on is_active
+	// is_active is written through references, the list is current only after refresh_active_indices
+	ContainerType<index_t> active_indices;
+
+	// set when agents are added, moved or removed and by every agent's is_active() accessor, solvers then refresh
+	// active_indices before their next agent kernels; code writing the is_active column directly has to set it too
+	std::atomic<bool> active_indices_dirty = true;
+
+	// n - row of the parameter columns holding the agent's parameters, used only with shared parameters
+	ContainerType<index_t> parameter_rows;
+
 	index_t agents_count = 0;
 	index_t substrate_count;
+	bool shared_parameters = false;
+	// rows of the parameter columns shared by agent types, the rows after them belong to overridden agents
+	index_t types_count = 0;
 
+	// Columns of allocator aware policies such as arena_vector allocate from resource, if given
 	explicit agent_data_generic_storage(physicore::base_agent_data_generic_storage<ContainerType>& base_data,
-										index_t substrate_count = 1);
+										index_t substrate_count = 1, std::pmr::memory_resource* resource = nullptr);
 
 	void add();
+	// Appends count agents, growing every column once
+	void add(index_t count);
+	// Allocates the columns for capacity agents without adding any
+	void reserve(index_t capacity);
 	void remove_at(index_t position);
+	// Moves agents by (destination, source) pairs and truncates the columns to count agents
+	void compact(std::span<const std::pair<index_t, index_t>> moves, index_t count);
+	// Reorders agents so that the agent at order[i] moves to position i, order is a permutation of all agents
+	void permute(std::span<const index_t> order);
+	// Rebuilds active_indices from is_active and clears active_indices_dirty
+	void refresh_active_indices();
+
+	/*
+	Switches the parameter columns from one row per agent to types_count rows shared by the agents of each type.
+
+	An agent's type is the row it references in parameter_rows, agents start with type 0 and set_type changes it.
+	Writes to an agent's parameters change its whole type unless the agent was given its own row by
+	override_parameters. Must be called before any agent is added.
+	*/
+	void use_shared_parameters(index_t types_count);
+	// Points the agent to the shared row of type, dropping parameters of its own given by override_parameters
+	void set_type(index_t agent, index_t type);
+	// Appends a copy of the agent's parameter row and points the agent to it, returns the new row
+	index_t override_parameters(index_t agent);
+	/*
+	Removes the rows of overridden agents that no agent references anymore and renumbers the remaining ones.
+
+	Rows of overridden agents stay allocated when the agents are removed or their type is set again, so populations
+	overriding many short-lived agents call this from time to time. Rows of types are always kept.
+	*/
+	void compact_parameters();
+	// Row of the parameter columns holding the parameters of the agent
+	index_t parameters_row(index_t agent) const { return shared_parameters ? parameter_rows[agent] : agent; }
+	// Number of rows of the parameter columns
+	index_t parameters_count() const;
+
+	// Typed view of a column without virtual dispatch, e.g. column<columns::secretion_rates>() is an
+	// agents x substrates column_view and column<columns::volumes>() a span of one value per agent
+	template <typename Column>
+	auto column()
+	{
+		return view_column<Column>(*this);
+	}
+
+	template <typename Column>
+	auto column() const
+	{
+		return view_column<Column>(*this);
+	}
+};
+
+namespace columns {
+
+using physicore::base_columns::positions;
+
+struct secretion_rates
+{
+	static auto& of(auto& data) { return data.secretion_rates; }
+	static index_t width(const auto& data) { return data.substrate_count; }
+	static index_t rows(const auto& data) { return data.parameters_count(); }
+};
+
+struct saturation_densities
+{
+	static auto& of(auto& data) { return data.saturation_densities; }
+	static index_t width(const auto& data) { return data.substrate_count; }
+	static index_t rows(const auto& data) { return data.parameters_count(); }
+};
+
+struct uptake_rates
+{
+	static auto& of(auto& data) { return data.uptake_rates; }
+	static index_t width(const auto& data) { return data.substrate_count; }
+	static index_t rows(const auto& data) { return data.parameters_count(); }
+};
+
+struct net_export_rates
+{
+	static auto& of(auto& data) { return data.net_export_rates; }
+	static index_t width(const auto& data) { return data.substrate_count; }
+	static index_t rows(const auto& data) { return data.parameters_count(); }
+};
+
+struct internalized_substrates
+{
+	static auto& of(auto& data) { return data.internalized_substrates; }
+	static index_t width(const auto& data) { return data.substrate_count; }
+};
+
+struct fraction_released_at_death
+{
+	static auto& of(auto& data) { return data.fraction_released_at_death; }
+	static index_t width(const auto& data) { return data.substrate_count; }
+	static index_t rows(const auto& data) { return data.parameters_count(); }
+};
+
+struct fraction_transferred_when_ingested
+{
+	static auto& of(auto& data) { return data.fraction_transferred_when_ingested; }
+	static index_t width(const auto& data) { return data.substrate_count; }
+	static index_t rows(const auto& data) { return data.parameters_count(); }
+};
+
+struct volumes
+{
+	static auto& of(auto& data) { return data.volumes; }
+};
+
+struct is_active
+{
+	static auto& of(auto& data) { return data.is_active; }
 };
 
+} // namespace columns
+
 template <template <typename...> typename ContainerType>
 agent_data_generic_storage<ContainerType>::agent_data_generic_storage(
-	physicore::base_agent_data_generic_storage<ContainerType>& base_data, index_t substrate_count)
-	: base_data(base_data), substrate_count(substrate_count)
+	physicore::base_agent_data_generic_storage<ContainerType>& base_data, index_t substrate_count,
+	std::pmr::memory_resource* resource)
+	: base_data(base_data),
+	  secretion_rates(base_data.template make_column<ContainerType<parameter_t>>(resource)),
+	  saturation_densities(base_data.template make_column<ContainerType<parameter_t>>(resource)),
+	  uptake_rates(base_data.template make_column<ContainerType<parameter_t>>(resource)),
+	  net_export_rates(base_data.template make_column<ContainerType<parameter_t>>(resource)),
+	  internalized_substrates(base_data.template make_column<ContainerType<real_t>>(resource)),
+	  fraction_released_at_death(base_data.template make_column<ContainerType<parameter_t>>(resource)),
+	  fraction_transferred_when_ingested(base_data.template make_column<ContainerType<parameter_t>>(resource)),
+	  volumes(base_data.template make_column<ContainerType<real_t>>(resource)),
+	  is_active(base_data.template make_column<ContainerType<uint8_t>>(resource)),
+	  active_indices(base_data.template make_column<ContainerType<index_t>>(resource)),
+	  parameter_rows(base_data.template make_column<ContainerType<index_t>>(resource)),
+	  substrate_count(substrate_count)
 {}
 
 template <template <typename...> typename ContainerType>
 void agent_data_generic_storage<ContainerType>::add()
 {
-	++agents_count;
+	add(1);
+}
 
-	secretion_rates.resize(agents_count * substrate_count);
-	saturation_densities.resize(agents_count * substrate_count);
-	uptake_rates.resize(agents_count * substrate_count);
-	net_export_rates.resize(agents_count * substrate_count);
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::add(index_t count)
+{
+	using base_data_t = physicore::base_agent_data_generic_storage<ContainerType>;
 
-	internalized_substrates.resize(agents_count * substrate_count);
-	fraction_released_at_death.resize(agents_count * substrate_count);
-	fraction_transferred_when_ingested.resize(agents_count * substrate_count, 1);
+	agents_count += count;
 
-	volumes.resize(agents_count);
-	is_active.resize(agents_count, 1);
+	if (shared_parameters)
+	{
+		base_data_t::grow(parameter_rows, agents_count);
+	}
+	else
+	{
+		base_data_t::grow(secretion_rates, agents_count * substrate_count);
+		base_data_t::grow(saturation_densities, agents_count * substrate_count);
+		base_data_t::grow(uptake_rates, agents_count * substrate_count);
+		base_data_t::grow(net_export_rates, agents_count * substrate_count);
+
+		base_data_t::grow(fraction_released_at_death, agents_count * substrate_count);
+		base_data_t::grow(fraction_transferred_when_ingested, agents_count * substrate_count, 1);
+	}
+
+	base_data_t::grow(internalized_substrates, agents_count * substrate_count);
+
+	base_data_t::grow(volumes, agents_count);
+	base_data_t::grow(is_active, agents_count, 1);
+
+	active_indices_dirty.store(true, std::memory_order_relaxed);
+}
+
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::reserve(index_t capacity)
+{
+	using base_data_t = physicore::base_agent_data_generic_storage<ContainerType>;
+
+	if (shared_parameters)
+	{
+		base_data_t::reserve_column(parameter_rows, capacity);
+	}
+	else
+	{
+		base_data_t::reserve_column(secretion_rates, capacity * substrate_count);
+		base_data_t::reserve_column(saturation_densities, capacity * substrate_count);
+		base_data_t::reserve_column(uptake_rates, capacity * substrate_count);
+		base_data_t::reserve_column(net_export_rates, capacity * substrate_count);
+
+		base_data_t::reserve_column(fraction_released_at_death, capacity * substrate_count);
+		base_data_t::reserve_column(fraction_transferred_when_ingested, capacity * substrate_count);
+	}
+
+	base_data_t::reserve_column(internalized_substrates, capacity * substrate_count);
+
+	base_data_t::reserve_column(volumes, capacity);
+	base_data_t::reserve_column(is_active, capacity);
 }
 
 template <template <typename...> typename ContainerType>
@@ -75,38 +271,288 @@ void agent_data_generic_storage<ContainerType>::remove_at(index_t position)
 
 	if (position < agents_count)
 	{
-		base_agent_data::move_vector(&secretion_rates[position * substrate_count],
-									 &secretion_rates[agents_count * substrate_count], substrate_count);
-		base_agent_data::move_vector(&saturation_densities[position * substrate_count],
-									 &saturation_densities[agents_count * substrate_count], substrate_count);
-		base_agent_data::move_vector(&uptake_rates[position * substrate_count],
-									 &uptake_rates[agents_count * substrate_count], substrate_count);
-		base_agent_data::move_vector(&net_export_rates[position * substrate_count],
-									 &net_export_rates[agents_count * substrate_count], substrate_count);
+		if (shared_parameters)
+		{
+			base_agent_data::move_scalar(&parameter_rows[position], &parameter_rows[agents_count]);
+		}
+		else
+		{
+			base_agent_data::move_vector(&secretion_rates[position * substrate_count],
+										 &secretion_rates[agents_count * substrate_count], substrate_count);
+			base_agent_data::move_vector(&saturation_densities[position * substrate_count],
+										 &saturation_densities[agents_count * substrate_count], substrate_count);
+			base_agent_data::move_vector(&uptake_rates[position * substrate_count],
+										 &uptake_rates[agents_count * substrate_count], substrate_count);
+			base_agent_data::move_vector(&net_export_rates[position * substrate_count],
+										 &net_export_rates[agents_count * substrate_count], substrate_count);
+
+			base_agent_data::move_vector(&fraction_released_at_death[position * substrate_count],
+										 &fraction_released_at_death[agents_count * substrate_count], substrate_count);
+			base_agent_data::move_vector(&fraction_transferred_when_ingested[position * substrate_count],
+										 &fraction_transferred_when_ingested[agents_count * substrate_count],
+										 substrate_count);
+		}
 
 		base_agent_data::move_vector(&internalized_substrates[position * substrate_count],
 									 &internalized_substrates[agents_count * substrate_count], substrate_count);
-		base_agent_data::move_vector(&fraction_released_at_death[position * substrate_count],
-									 &fraction_released_at_death[agents_count * substrate_count], substrate_count);
-		base_agent_data::move_vector(&fraction_transferred_when_ingested[position * substrate_count],
-									 &fraction_transferred_when_ingested[agents_count * substrate_count],
-									 substrate_count);
 
 		base_agent_data::move_scalar(&volumes[position], &volumes[agents_count]);
 		base_agent_data::move_scalar(&is_active[position], &is_active[agents_count]);
 	}
 
-	secretion_rates.resize(agents_count * substrate_count);
-	saturation_densities.resize(agents_count * substrate_count);
-	uptake_rates.resize(agents_count * substrate_count);
-	net_export_rates.resize(agents_count * substrate_count);
+	if (shared_parameters)
+	{
+		parameter_rows.resize(agents_count);
+	}
+	else
+	{
+		secretion_rates.resize(agents_count * substrate_count);
+		saturation_densities.resize(agents_count * substrate_count);
+		uptake_rates.resize(agents_count * substrate_count);
+		net_export_rates.resize(agents_count * substrate_count);
+
+		fraction_released_at_death.resize(agents_count * substrate_count);
+		fraction_transferred_when_ingested.resize(agents_count * substrate_count);
+	}
+
+	internalized_substrates.resize(agents_count * substrate_count);
+
+	volumes.resize(agents_count);
+	is_active.resize(agents_count);
+
+	active_indices_dirty.store(true, std::memory_order_relaxed);
+}
+
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::compact(
+	std::span<const std::pair<index_t, index_t>> moves, index_t count)
+{
+	assert(count <= agents_count);
+
+	for (const auto& [destination, source] : moves)
+	{
+		const index_t dst = destination * substrate_count;
+		const index_t src = source * substrate_count;
+
+		if (shared_parameters)
+		{
+			base_agent_data::move_scalar(&parameter_rows[destination], &parameter_rows[source]);
+		}
+		else
+		{
+			base_agent_data::move_vector(&secretion_rates[dst], &secretion_rates[src], substrate_count);
+			base_agent_data::move_vector(&saturation_densities[dst], &saturation_densities[src], substrate_count);
+			base_agent_data::move_vector(&uptake_rates[dst], &uptake_rates[src], substrate_count);
+			base_agent_data::move_vector(&net_export_rates[dst], &net_export_rates[src], substrate_count);
+
+			base_agent_data::move_vector(&fraction_released_at_death[dst], &fraction_released_at_death[src],
+										 substrate_count);
+			base_agent_data::move_vector(&fraction_transferred_when_ingested[dst],
+										 &fraction_transferred_when_ingested[src], substrate_count);
+		}
+
+		base_agent_data::move_vector(&internalized_substrates[dst], &internalized_substrates[src], substrate_count);
+
+		base_agent_data::move_scalar(&volumes[destination], &volumes[source]);
+		base_agent_data::move_scalar(&is_active[destination], &is_active[source]);
+	}
+
+	agents_count = count;
+
+	if (shared_parameters)
+	{
+		parameter_rows.resize(agents_count);
+	}
+	else
+	{
+		secretion_rates.resize(agents_count * substrate_count);
+		saturation_densities.resize(agents_count * substrate_count);
+		uptake_rates.resize(agents_count * substrate_count);
+		net_export_rates.resize(agents_count * substrate_count);
+
+		fraction_released_at_death.resize(agents_count * substrate_count);
+		fraction_transferred_when_ingested.resize(agents_count * substrate_count);
+	}
 
 	internalized_substrates.resize(agents_count * substrate_count);
-	fraction_released_at_death.resize(agents_count * substrate_count);
-	fraction_transferred_when_ingested.resize(agents_count * substrate_count);
 
 	volumes.resize(agents_count);
 	is_active.resize(agents_count);
+
+	active_indices_dirty.store(true, std::memory_order_relaxed);
+}
+
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::permute(std::span<const index_t> order)
+{
+	using base_data_t = physicore::base_agent_data_generic_storage<ContainerType>;
+
+	assert(order.size() == agents_count);
+
+	if (shared_parameters)
+	{
+		base_data_t::gather(parameter_rows, order, 1);
+	}
+	else
+	{
+		base_data_t::gather(secretion_rates, order, substrate_count);
+		base_data_t::gather(saturation_densities, order, substrate_count);
+		base_data_t::gather(uptake_rates, order, substrate_count);
+		base_data_t::gather(net_export_rates, order, substrate_count);
+
+		base_data_t::gather(fraction_released_at_death, order, substrate_count);
+		base_data_t::gather(fraction_transferred_when_ingested, order, substrate_count);
+	}
+
+	base_data_t::gather(internalized_substrates, order, substrate_count);
+
+	base_data_t::gather(volumes, order, 1);
+	base_data_t::gather(is_active, order, 1);
+
+	active_indices_dirty.store(true, std::memory_order_relaxed);
+}
+
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::refresh_active_indices()
+{
+	active_indices.resize(agents_count);
+
+	index_t active_count = 0;
+	for (index_t i = 0; i < agents_count; i++)
+	{
+		active_indices[active_count] = i;
+		active_count += is_active[i] != 0;
+	}
+
+	active_indices.resize(active_count);
+
+	active_indices_dirty.store(false, std::memory_order_relaxed);
+}
+
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::use_shared_parameters(index_t types_count)
+{
+	if (agents_count != 0)
+		throw std::runtime_error("Shared parameters must be enabled before agents are added");
+
+	shared_parameters = true;
+	this->types_count = types_count;
+
+	auto reset_rows = [&](auto& column, parameter_t value) {
+		column.resize(0);
+		column.resize(types_count * substrate_count, value);
+	};
+
+	reset_rows(secretion_rates, 0);
+	reset_rows(saturation_densities, 0);
+	reset_rows(uptake_rates, 0);
+	reset_rows(net_export_rates, 0);
+
+	reset_rows(fraction_released_at_death, 0);
+	reset_rows(fraction_transferred_when_ingested, 1);
+}
+
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::set_type(index_t agent, index_t type)
+{
+	assert(agent < agents_count);
+
+	if (!shared_parameters)
+		throw std::runtime_error("Agent types require shared parameters");
+
+	if (type >= types_count)
+		throw std::runtime_error("Agent type " + std::to_string(type) + " is not below the types count "
+								 + std::to_string(types_count));
+
+	parameter_rows[agent] = type;
+}
+
+template <template <typename...> typename ContainerType>
+index_t agent_data_generic_storage<ContainerType>::override_parameters(index_t agent)
+{
+	assert(shared_parameters && agent < agents_count);
+
+	using base_data_t = physicore::base_agent_data_generic_storage<ContainerType>;
+
+	const index_t source = parameter_rows[agent] * substrate_count;
+	const index_t row = parameters_count();
+
+	auto append_row = [&](auto& column) {
+		base_data_t::grow(column, (row + 1) * substrate_count);
+		std::copy_n(&column[source], substrate_count, &column[row * substrate_count]);
+	};
+
+	append_row(secretion_rates);
+	append_row(saturation_densities);
+	append_row(uptake_rates);
+	append_row(net_export_rates);
+
+	append_row(fraction_released_at_death);
+	append_row(fraction_transferred_when_ingested);
+
+	parameter_rows[agent] = row;
+
+	return row;
+}
+
+template <template <typename...> typename ContainerType>
+void agent_data_generic_storage<ContainerType>::compact_parameters()
+{
+	if (!shared_parameters)
+		return;
+
+	const index_t rows_count = parameters_count();
+
+	std::vector<index_t> new_rows(rows_count, 0);
+	std::vector<uint8_t> referenced(rows_count, 0);
+
+	for (index_t i = 0; i < agents_count; i++)
+		referenced[parameter_rows[i]] = 1;
+
+	// rows move only towards the front, in ascending order no row is overwritten before it is moved
+	index_t kept = types_count;
+	for (index_t row = types_count; row < rows_count; row++)
+	{
+		if (!referenced[row])
+			continue;
+
+		new_rows[row] = kept;
+
+		auto move_row = [&](auto& column) {
+			std::copy_n(&column[row * substrate_count], substrate_count, &column[kept * substrate_count]);
+		};
+
+		if (row != kept)
+		{
+			move_row(secretion_rates);
+			move_row(saturation_densities);
+			move_row(uptake_rates);
+			move_row(net_export_rates);
+
+			move_row(fraction_released_at_death);
+			move_row(fraction_transferred_when_ingested);
+		}
+
+		kept++;
+	}
+
+	for (index_t i = 0; i < agents_count; i++)
+		if (parameter_rows[i] >= types_count)
+			parameter_rows[i] = new_rows[parameter_rows[i]];
+
+	secretion_rates.resize(kept * substrate_count);
+	saturation_densities.resize(kept * substrate_count);
+	uptake_rates.resize(kept * substrate_count);
+	net_export_rates.resize(kept * substrate_count);
+
+	fraction_released_at_death.resize(kept * substrate_count);
+	fraction_transferred_when_ingested.resize(kept * substrate_count);
+}
+
+template <template <typename...> typename ContainerType>
+index_t agent_data_generic_storage<ContainerType>::parameters_count() const
+{
+	return shared_parameters ? secretion_rates.size() / substrate_count : agents_count;
 }
 
 } // namespace physicore::biofvm
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include <common/base_agent_generic_storage.h>
 #include <common/types.h>
 
@@ -34,24 +36,28 @@ public:
 		: agent_generic_storage(index, *std::get<std::unique_ptr<AgentDataType>>(datas))
 	{}
 
-	std::span<real_t> secretion_rates() override
+	std::span<parameter_t> secretion_rates() override
 	{
-		return std::span<real_t>(&data.secretion_rates[index * data.substrate_count], data.substrate_count);
+		return std::span<parameter_t>(&data.secretion_rates[data.parameters_row(index) * data.substrate_count],
+									  data.substrate_count);
 	}
 
-	std::span<real_t> saturation_densities() override
+	std::span<parameter_t> saturation_densities() override
 	{
-		return std::span<real_t>(&data.saturation_densities[index * data.substrate_count], data.substrate_count);
+		return std::span<parameter_t>(&data.saturation_densities[data.parameters_row(index) * data.substrate_count],
+									  data.substrate_count);
 	}
 
-	std::span<real_t> uptake_rates() override
+	std::span<parameter_t> uptake_rates() override
 	{
-		return std::span<real_t>(&data.uptake_rates[index * data.substrate_count], data.substrate_count);
+		return std::span<parameter_t>(&data.uptake_rates[data.parameters_row(index) * data.substrate_count],
+									  data.substrate_count);
 	}
 
-	std::span<real_t> net_export_rates() override
+	std::span<parameter_t> net_export_rates() override
 	{
-		return std::span<real_t>(&data.net_export_rates[index * data.substrate_count], data.substrate_count);
+		return std::span<parameter_t>(&data.net_export_rates[data.parameters_row(index) * data.substrate_count],
+									  data.substrate_count);
 	}
 
 	std::span<real_t> internalized_substrates() override
@@ -59,20 +65,29 @@ public:
 		return std::span<real_t>(&data.internalized_substrates[index * data.substrate_count], data.substrate_count);
 	}
 
-	std::span<real_t> fraction_released_at_death() override
+	std::span<parameter_t> fraction_released_at_death() override
 	{
-		return std::span<real_t>(&data.fraction_released_at_death[index * data.substrate_count], data.substrate_count);
+		return std::span<parameter_t>(
+			&data.fraction_released_at_death[data.parameters_row(index) * data.substrate_count], data.substrate_count);
 	}
 
-	std::span<real_t> fraction_transferred_when_ingested() override
+	std::span<parameter_t> fraction_transferred_when_ingested() override
 	{
-		return std::span<real_t>(&data.fraction_transferred_when_ingested[index * data.substrate_count],
-								 data.substrate_count);
+		return std::span<parameter_t>(
+			&data.fraction_transferred_when_ingested[data.parameters_row(index) * data.substrate_count],
+			data.substrate_count);
 	}
 
 	real_t& volume() override { return data.volumes[index]; }
 
-	uint8_t& is_active() override { return data.is_active[index]; }
+	// the reference may be written, so the active agents list has to be rebuilt
+	uint8_t& is_active() override
+	{
+		data.active_indices_dirty.store(true, std::memory_order_relaxed);
+		return data.is_active[index];
+	}
+
+	void set_type(index_t type) override { data.set_type(index, type); }
 };
 
 #ifdef _MSC_VER
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include <biofvm/biofvm_export.h>
 #include <common/types.h>
 
 namespace physicore {
@@ -29,7 +30,7 @@ struct overall_config
 	std::string time_units;
 	std::string space_units;
 	real_t dt_diffusion;
-	real_t dt_mechanics; // Stored for future use by mechanics module
+	real_t dt_mechanics;
 	real_t dt_phenotype; // Stored for future use by phenotype module
 };
 
@@ -87,6 +88,6 @@ struct physicell_config
  * @return Parsed configuration structures
  * @throws std::runtime_error if file cannot be read or XML is malformed/incomplete
  */
-physicell_config parse_physicell_config(const std::filesystem::path& config_file);
+BIOFVM_EXPORT physicell_config parse_physicell_config(const std::filesystem::path& config_file);
 
 } // namespace physicore
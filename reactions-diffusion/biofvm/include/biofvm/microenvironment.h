@@ -1,11 +1,18 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <filesystem>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
+#include <version>
 
 #include <biofvm/biofvm_export.h>
+#include <common/execution_context.h>
 #include <common/timestep_executor.h>
 #include <common/types.h>
 
@@ -17,10 +24,31 @@
 
 namespace physicore::biofvm {
 
+// Immutable copy of all substrate densities published after a timestep, substrates varying fastest, then x, y and z
+struct substrate_snapshot
+{
+	index_t epoch = 0;
+	std::array<index_t, 4> extents = { 0, 0, 0, 0 }; // substrates, x, y, z
+	std::vector<real_t> densities;
+
+	substrate_field_view view() const
+	{
+		const index_t x_stride = extents[0];
+		const index_t y_stride = x_stride * extents[1];
+		return { densities.data(), extents, { 1, x_stride, y_stride, y_stride * extents[2] } };
+	}
+};
+
 class BIOFVM_EXPORT microenvironment : public timestep_executor
 {
 public:
-	microenvironment(const cartesian_mesh& mesh, index_t substrates_count, real_t timestep);
+	// Agent columns of an allocator aware storage policy (PHYSICORE_AGENT_STORAGE=arena) allocate from agents_resource
+	// if given, from the default memory resource otherwise
+	microenvironment(const cartesian_mesh& mesh, index_t substrates_count, real_t timestep,
+					 std::pmr::memory_resource* agents_resource = nullptr);
+
+	// Runs the asynchronous tasks still queued before the members they use are destroyed
+	~microenvironment() override;
 
 	microenvironment(microenvironment&&) = delete;
 	microenvironment(const microenvironment&) = delete;
@@ -31,11 +59,66 @@ public:
 
 	void run_single_timestep() override;
 	void serialize_state(real_t current_time) override;
+	real_t get_timestep() const override;
+
+	data_access get_timestep_access() const override;
+	data_access get_serialization_access() const override;
+
+	// Runs all the steps within a single solver call, see solver::solve_steps
+	void run_steps(index_t steps, const step_callback& on_step = nullptr) override;
 
 	real_t get_substrate_density(index_t s, index_t x, index_t y, index_t z) const;
 
+	// Zero-copy view of all substrate densities for iterating the field directly
+	substrate_field_view get_substrate_field_view() const;
+
+	// Latest published snapshot of the densities, null before the first one
+	// Readers may hold it without locking while the following timesteps run
+	std::shared_ptr<const substrate_snapshot> get_substrate_snapshot() const;
+
+	// Copies the current densities into a new snapshot and publishes it
+	// Called after every timestep when publish_snapshots is set
+	void publish_substrate_snapshot();
+
+	// Sample densities of all substrates at the given positions (mesh.dims coordinates per point)
+	// into output, a row-major points x substrates array
+	void sample_substrate_densities(std::span<const real_t> positions, std::span<real_t> output,
+									interpolation mode = interpolation::nearest) const;
+
+	// Sample densities of all substrates at the positions of the given agents
+	// into output, a row-major agents x substrates array
+	void sample_agent_substrate_densities(std::span<const index_t> agent_indices, std::span<real_t> output,
+										  interpolation mode = interpolation::nearest) const;
+
+	// Substrate gradients at agent positions computed at the end of the last solve (if compute_gradients is set)
+	// Row-major agents x substrates x mesh.dims array, empty if not computed
+	std::span<const real_t> get_agent_gradients() const;
+
+	// Gradient of substrate s along dimension dim over the whole mesh, one value per voxel with x varying fastest
+	// Computed on the first request after the densities changed and cached, so only requested fields take memory
+	std::span<const real_t> get_gradient_field(index_t s, index_t dim);
+
+	// Frees the memory of a cached gradient field
+	void release_gradient_field(index_t s, index_t dim);
+
+	// Marks all cached gradient fields stale, needed after densities were modified outside of run_single_timestep
+	void invalidate_gradient_fields();
+
 	void print_info(std::ostream& os) const;
 
+	// Moves internalized substrates of each prey, scaled by its fraction_transferred_when_ingested, to its predator and
+	// removes all prey afterwards. Pairs are (predator, prey) agent indices; a prey may appear only once and must not
+	// be a predator in the same batch (asserted in debug builds). Predators with multiple prey are resolved without
+	// races.
+	void ingest_agents(std::span<const std::pair<index_t, index_t>> predator_prey_pairs);
+
+	// Reorders agents along a Morton curve of their voxels, so agents of the same and neighbouring voxels are close in
+	// memory and the solver's scatter into the densities becomes local. Agent indices change, handles follow.
+	void sort_agents_spatially();
+
+	// Fraction of consecutive agents whose voxels are out of Morton order, 0 right after sorting
+	real_t measure_agents_disorder() const;
+
 	// Dirichlet condition modification methods
 	void update_dirichlet_interior_voxel(std::array<index_t, 3> voxel, index_t substrate_idx, real_t value,
 										 bool condition);
@@ -48,6 +131,10 @@ public:
 	serializer_ptr serializer;
 	serializer_ptr agents_serializer;
 
+	// worker threads of the solver and the microenvironment's own parallel loops, read by the solver at initialize
+	// null runs on the threading runtime defaults
+	std::shared_ptr<const execution_context> context;
+
 	// environment configuration parameters
 	std::string name, time_units, space_units;
 	real_t diffusion_timestep;
@@ -56,6 +143,8 @@ public:
 
 	// diffusion-decay configuration parameters
 	index_t substrates_count;
+	// read by the solver at initialize, not every solver supports every layout
+	substrate_layout densities_layout = substrate_layout::interleaved;
 	std::vector<std::string> substrates_names;
 	std::vector<std::string> substrates_units;
 	std::unique_ptr<real_t[]> initial_conditions;
@@ -79,6 +168,48 @@ public:
 
 	// cell saturation-uptake configuration parameters
 	bool compute_internalized_substrates = false;
+	bool compute_gradients = false;
+	// agents interact with few of the substrates, solvers supporting it skip the substrates an agent has zero rates of
+	bool sparse_agent_interactions = false;
+
+	// snapshot mode for readers running concurrently with the solver
+	bool publish_snapshots = false;
+
+	// run_single_timestep and run_steps sort agents spatially every agents_sort_interval timesteps (0 never) and
+	// whenever their disorder exceeds agents_sort_disorder_threshold (0 never, measuring costs a pass over positions)
+	index_t agents_sort_interval = 0;
+	real_t agents_sort_disorder_threshold = 0;
+
+private:
+	// sorts agents if one of the triggers is due after a timestep
+	void sort_agents_if_due();
+
+	// bumped whenever densities may have changed
+	index_t densities_version_ = 1;
+
+	index_t timesteps_since_agents_sort_ = 0;
+
+	// per substrate and dimension: densities version the field was computed for (0 if never) and its values
+	std::vector<std::pair<index_t, std::vector<real_t>>> gradient_fields_;
+
+	// A snapshot and whether a published pointer to it is still held. The published pointers share one reference,
+	// whose deleter clears leased with release semantics once the last reader dropped it
+	struct snapshot_buffer
+	{
+		substrate_snapshot snapshot;
+		std::atomic<bool> leased = false;
+	};
+
+	// double buffer of the two most recent snapshots, the older one is reused once no reader holds it
+	std::array<std::shared_ptr<snapshot_buffer>, 2> snapshot_buffers_;
+	index_t snapshot_epoch_ = 0;
+
+#ifdef __cpp_lib_atomic_shared_ptr
+	std::atomic<std::shared_ptr<const substrate_snapshot>> snapshot_;
+#else
+	// accessed only through std::atomic_load and std::atomic_store
+	std::shared_ptr<const substrate_snapshot> snapshot_;
+#endif
 };
 
 } // namespace physicore::biofvm
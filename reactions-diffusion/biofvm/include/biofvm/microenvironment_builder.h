@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory_resource>
 #include <optional>
 
 #include <biofvm/biofvm_export.h>
@@ -40,6 +41,10 @@ class BIOFVM_EXPORT microenvironment_builder
 	std::string solver_name = "openmp_solver";
 
 	bool compute_internalized_substrates = false;
+	bool compute_gradients = false;
+	bool sparse_agent_interactions = false;
+
+	std::pmr::memory_resource* agents_resource = nullptr;
 
 	void fill_dirichlet_vectors(microenvironment& m);
 
@@ -72,6 +77,13 @@ public:
 
 	void do_compute_internalized_substrates();
 
+	void do_compute_gradients();
+
+	void do_use_sparse_agent_interactions();
+
+	// Memory resource of the agent columns with the arena storage policy, must outlive the microenvironment
+	void set_agents_memory_resource(std::pmr::memory_resource* resource);
+
 	void select_solver(const std::string& solver_name);
 
 	std::unique_ptr<microenvironment> build();
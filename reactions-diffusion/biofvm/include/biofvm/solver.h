@@ -1,14 +1,46 @@
 #pragma once
 
+#include <array>
 #include <memory>
+#include <span>
 
 #include <biofvm/biofvm_export.h>
+#include <common/timestep_executor.h>
 #include <common/types.h>
 
 namespace physicore::biofvm {
 
 class microenvironment;
 
+// Interpolation used when sampling substrate densities at arbitrary positions
+enum class interpolation
+{
+	nearest,  // densities of the voxel containing the position
+	trilinear // linear interpolation between the centers of the neighbouring voxels in each dimension
+};
+
+// Arrangement of the substrate densities in memory
+enum class substrate_layout
+{
+	interleaved, // densities of all substrates of a voxel are contiguous, favours agent secretion and uptake
+	planar       // one contiguous grid per substrate, favours diffusion sweeps and export of many substrates
+};
+
+// Read-only view of the substrate densities in the native layout of a solver
+// Density of substrate s in voxel (x, y, z) is data[s * strides[0] + x * strides[1] + y * strides[2] + z * strides[3]],
+// strides are in elements and include any padding of the layout
+struct substrate_field_view
+{
+	const real_t* data = nullptr;
+	std::array<index_t, 4> extents = { 0, 0, 0, 0 }; // substrates, x, y, z
+	std::array<index_t, 4> strides = { 0, 0, 0, 0 };
+
+	const real_t& operator()(index_t s, index_t x, index_t y, index_t z) const
+	{
+		return data[s * strides[0] + x * strides[1] + y * strides[2] + z * strides[3]];
+	}
+};
+
 class BIOFVM_EXPORT solver
 {
 public:
@@ -18,10 +50,40 @@ public:
 	// Solve the diffusion-decay equations for a given number of iterations
 	virtual void solve(microenvironment& m, index_t iterations) = 0;
 
+	// Solve for a given number of iterations, on_step is called by a single thread after each of them while the rest
+	// of the solver waits, so it may inspect or modify the microenvironment
+	// Solvers may override it to keep their parallel resources alive across all the iterations
+	virtual void solve_steps(microenvironment& m, index_t iterations, const step_callback& on_step)
+	{
+		for (index_t it = 0; it < iterations; it++)
+		{
+			solve(m, 1);
+			on_step(it);
+		}
+	}
+
 	// Get the substrate density at a given voxel
 	virtual real_t get_substrate_density(index_t s, index_t x, index_t y, index_t z) const = 0;
 	virtual real_t& get_substrate_density(index_t s, index_t x, index_t y, index_t z) = 0;
 
+	// View of all substrate densities in host memory, valid until the solver is reinitialized
+	// (device solvers expose the host copy, see transfer_to_host)
+	virtual substrate_field_view get_substrate_field_view() const = 0;
+
+	// Sample densities of all substrates at the given positions (mesh dims coordinates per point)
+	// The output is a row-major points x substrates array
+	virtual void sample_substrate_densities(const microenvironment& m, std::span<const real_t> positions,
+											std::span<real_t> output, interpolation mode) = 0;
+
+	// Substrate gradients at agent positions (agents x substrates x dims) computed by the last solve call,
+	// empty if the solver does not compute them or microenvironment::compute_gradients is not set
+	virtual std::span<const real_t> get_agent_gradients() const { return {}; }
+
+	// Compute the gradient of substrate s along dimension dim in all voxels, one value per voxel with x varying fastest
+	// Central differences are used inside the domain and one-sided ones at its boundary
+	virtual void compute_gradient_field(const microenvironment& m, index_t s, index_t dim,
+										std::span<real_t> output) = 0;
+
 	// Transfer data to/from device (if applicable)
 	virtual void transfer_to_device([[maybe_unused]] microenvironment& m) { /* Default host solver */ }
 	virtual void transfer_to_host([[maybe_unused]] microenvironment& m) { /* Default host solver */ }
@@ -29,6 +91,10 @@ public:
 	// Reinitialize Dirichlet conditions (e.g., after modifying boundary or interior conditions)
 	virtual void reinitialize_dirichlet(microenvironment& m) = 0;
 
+	// Called before the microenvironment reorders the agent data on the host (see sort_agents_spatially), solvers
+	// keeping their own copy of the agent data bring the host one up to date; recompute_positional_data follows
+	virtual void prepare_agents_reorder([[maybe_unused]] microenvironment& m) { /* Default host solver */ }
+
 	// Recompute any agent-specific positional data
 	// (should be called after agent movement was triggered by another module)
 	virtual void recompute_positional_data(microenvironment& m) = 0;
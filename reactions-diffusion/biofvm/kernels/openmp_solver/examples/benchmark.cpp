@@ -1,13 +1,21 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <numeric>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include <biofvm/bulk_functor.h>
 #include <biofvm/microenvironment.h>
+#include <common/execution_context.h>
+#include <common/memory_placement.h>
 
 #include "bulk_solver.h"
 #include "cell_solver.h"
 #include "diffusion_solver.h"
 #include "dirichlet_solver.h"
+#include "omp_helper.h"
 
 using namespace physicore;
 using namespace physicore::biofvm;
@@ -20,12 +28,16 @@ void make_agents(microenvironment& m, index_t count, bool conflict)
 	sindex_t y = 0;
 	sindex_t z = 0;
 
-	for (index_t i = 0; i < count; i++)
+	// agents are populated through proxies, so no per-agent handles are allocated
+	auto& agents = dynamic_cast<agent_container&>(*m.agents);
+	agents.reserve(count + (conflict ? 1 : 0));
+
+	for (index_t i : agents.create_n(count))
 	{
-		auto* a = m.agents->create();
-		a->position()[0] = static_cast<real_t>(x);
-		a->position()[1] = static_cast<real_t>(y);
-		a->position()[2] = static_cast<real_t>(z);
+		auto a = agents.make_proxy(i);
+		a.position()[0] = static_cast<real_t>(x);
+		a.position()[1] = static_cast<real_t>(y);
+		a.position()[2] = static_cast<real_t>(z);
 
 		x += 20;
 		if (x >= m.mesh.bounding_box_maxs[0])
@@ -42,12 +54,50 @@ void make_agents(microenvironment& m, index_t count, bool conflict)
 
 	if (conflict)
 	{
-		auto* a = m.agents->create();
-		a->position()[0] = 0;
-		a->position()[1] = 0;
-		a->position()[2] = 0;
+		auto a = agents.make_proxy(agents.create_n(1).front());
+		a.position()[0] = 0;
+		a.position()[1] = 0;
+		a.position()[2] = 0;
 	}
 }
+
+// Counts the yz rows of densities each thread sweeps in the x sweep by whether they reside on the NUMA node of the
+// thread's cpu; remote rows are the ones whose sweeps read and write across the interconnect
+// The rows are visited by the team of the microenvironment's context, pinned like the team that touched them first
+void report_numa_placement(const microenvironment& m, const diffusion_solver& d_solver)
+{
+	const index_t rows = m.mesh.grid_shape[1] * m.mesh.grid_shape[2];
+	const index_t row_stride = d_solver.get_substrates_strides()[2];
+	const real_t* substrates = d_solver.get_substrates_pointer();
+
+	index_t local = 0;
+	index_t remote = 0;
+	index_t unknown = 0;
+
+	const execution_context* context = m.context.get();
+
+#pragma omp parallel num_threads(get_team_size(context)) reduction(+ : local, remote, unknown)
+	{
+		const auto pin = pin_to_context(context);
+
+#pragma omp for schedule(static)
+		for (index_t row = 0; row < rows; row++)
+		{
+			const int row_node = numa_node_of(substrates + row * row_stride);
+			const int thread_node = current_numa_node();
+
+			if (row_node < 0 || thread_node < 0)
+				unknown++;
+			else if (row_node == thread_node)
+				local++;
+			else
+				remote++;
+		}
+	}
+
+	std::cout << "NUMA placement of swept rows: " << local << " local, " << remote << " remote, " << unknown
+			  << " unknown" << std::endl;
+}
 } // namespace
 
 /**
@@ -66,13 +116,22 @@ void make_agents(microenvironment& m, index_t count, bool conflict)
  *   - Bulk solver
  *   - Dirichlet boundary condition solver
  *
+ * For the secretion and uptake solver, the minimum and maximum per-thread busy time
+ * and the load imbalance (maximum over mean busy time) are reported as well.
+ *
  * Timing is performed using std::chrono, and parallel execution is managed with OpenMP.
  *
+ * With --numa, the threads are pinned one per cpu through an execution context, both when the densities are first
+ * touched and when they are swept, and the NUMA node placement of the densities relative to the threads sweeping them
+ * is reported once the solvers are initialized.
+ *
  * This benchmark is intended to evaluate the performance of the solvers under
  * realistic simulation conditions.
  */
-int main()
+int main(int argc, char** argv)
 {
+	const bool numa_report = argc > 1 && std::string_view(argv[1]) == "--numa";
+
 	const cartesian_mesh mesh(3, { 0, 0, 0 }, { 5000, 5000, 5000 }, { 20, 20, 20 });
 
 	const real_t diffusion_timestep = 0.01;
@@ -81,6 +140,13 @@ int main()
 	microenvironment m(mesh, substrates_count, diffusion_timestep);
 	m.compute_internalized_substrates = true;
 
+	if (numa_report)
+	{
+		std::vector<unsigned> cpus(std::max(1U, std::thread::hardware_concurrency()));
+		std::iota(cpus.begin(), cpus.end(), 0U);
+		m.context = std::make_shared<execution_context>(0, std::move(cpus));
+	}
+
 	// --- diffusion parameters -------------------------------
 	m.initial_conditions = std::make_unique<real_t[]>(substrates_count);
 	m.diffusion_coefficients = std::make_unique<real_t[]>(substrates_count);
@@ -143,6 +209,9 @@ int main()
 	d_solver.prepare(m, 1);
 	d_solver.initialize();
 
+	if (numa_report)
+		report_numa_placement(m, d_solver);
+
 
 	for (index_t i = 0; i < 100; ++i)
 	{
@@ -151,8 +220,11 @@ int main()
 		std::size_t bulk_duration = 0;
 		std::size_t dirichlet_duration = 0;
 
-#pragma omp parallel private(diffusion_duration, secretion_duration, bulk_duration, dirichlet_duration)
+#pragma omp parallel num_threads(get_team_size(m.context.get()))                                                      \
+	private(diffusion_duration, secretion_duration, bulk_duration, dirichlet_duration)
 		{
+			const auto pin = pin_to_context(m.context.get());
+
 			{
 				auto start = std::chrono::steady_clock::now();
 
@@ -196,9 +268,18 @@ int main()
 			}
 
 #pragma omp master
-			std::cout << "Diffusion time: " << diffusion_duration << " ms,\t Secretion time: " << secretion_duration
-					  << " ms,\t Bulk time: " << bulk_duration << " ms,\t Dirichlet time: " << dirichlet_duration
-					  << " ms" << std::endl;
+			{
+				// per-thread busy time of the secretion stage, imbalance is the slowest thread relative to the mean
+				auto busy_times = c_solver.get_thread_busy_times();
+				auto [min_busy, max_busy] = std::minmax_element(busy_times.begin(), busy_times.end());
+				double mean_busy = std::accumulate(busy_times.begin(), busy_times.end(), 0.0) / busy_times.size();
+
+				std::cout << "Diffusion time: " << diffusion_duration << " ms,\t Secretion time: " << secretion_duration
+						  << " ms (thread busy min: " << *min_busy * 1000 << " ms, max: " << *max_busy * 1000
+						  << " ms, imbalance: " << (mean_busy > 0 ? *max_busy / mean_busy : 1.0)
+						  << "),\t Bulk time: " << bulk_duration << " ms,\t Dirichlet time: " << dirichlet_duration
+						  << " ms" << std::endl;
+			}
 		}
 	}
 }
@@ -1,17 +1,38 @@
 #include "cell_solver.h"
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
 #include <limits>
+#include <stdexcept>
 
+#include <common/memory_placement.h>
+#include <hwy/highway.h>
 #include <noarr/structures_extended.hpp>
 
+#include "omp_helper.h"
+
 using namespace physicore;
 using namespace physicore::biofvm;
 using namespace physicore::biofvm::kernels::openmp_solver;
 
+namespace hn = hwy::HWY_NAMESPACE;
 
 namespace {
 constexpr index_t no_ballot = std::numeric_limits<index_t>::max();
 
+template <typename... vectors_t>
+void advise_huge_pages(const vectors_t&... vectors)
+{
+	(physicore::advise_huge_pages(vectors.data(), vectors.size() * sizeof(typename vectors_t::value_type)), ...);
+}
+
+// Agents are created in spatial clusters and compacted by swap-with-last, so inactive and conflicting agents are
+// spread unevenly over the index range; agent loops are therefore scheduled dynamically in chunks of this size
+constexpr index_t agents_chunk_size = 1024;
+
+using simd_t = hn::ScalableTag<real_t>;
+
 template <index_t dims>
 auto fix_dims(const real_t* cell_position, const cartesian_mesh& m)
 {
@@ -19,261 +40,429 @@ auto fix_dims(const real_t* cell_position, const cartesian_mesh& m)
 	return noarr::fix<'x'>(voxel_index[0]) ^ noarr::fix<'y'>(voxel_index[1]) ^ noarr::fix<'z'>(voxel_index[2]);
 }
 
+// Substrates of a single agent (and of a single voxel) are contiguous, so each per-agent kernel walks them in full
+// vector blocks followed by one partial block that must not touch memory past the last substrate
+template <typename F>
+HWY_INLINE void for_each_substrate_block(index_t substrates_count, F&& f)
+{
+	const index_t lanes = hn::Lanes(simd_t());
+
+	index_t s = 0;
+	for (; s + lanes <= substrates_count; s += lanes)
+		f(s, lanes);
+
+	if (s < substrates_count)
+		f(s, substrates_count - s);
+}
+
+// Visits the substrates of a sparse interaction mask in ascending order
+template <typename F>
+HWY_INLINE void for_each_masked_substrate(std::uint64_t mask, F&& f)
+{
+	for (; mask != 0; mask &= mask - 1)
+		f(static_cast<index_t>(std::countr_zero(mask)));
+}
+
+// Agent loops are work-shared without the implied barrier, so the returned time is what the calling thread spent
+// working on its chunks, excluding the time it waits for the others
+template <typename F>
+double timed(F&& f)
+{
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+HWY_INLINE auto load_block(const real_t* HWY_RESTRICT p, index_t count)
+{
+	const simd_t d;
+	return count == hn::Lanes(d) ? hn::LoadU(d, p) : hn::LoadN(d, p, count);
+}
+
+// Agent parameters stored in reduced precision are widened to real_t lanes on load
+HWY_INLINE auto load_block(const float* HWY_RESTRICT p, index_t count)
+{
+	const simd_t d;
+	const hn::Rebind<float, simd_t> df;
+	return hn::PromoteTo(d, count == hn::Lanes(d) ? hn::LoadU(df, p) : hn::LoadN(df, p, count));
+}
+
+template <typename V>
+HWY_INLINE void store_block(V v, real_t* HWY_RESTRICT p, index_t count)
+{
+	const simd_t d;
+	if (count == hn::Lanes(d))
+		hn::StoreU(v, d, p);
+	else
+		hn::StoreN(v, d, p, count);
+}
+
+// Caches the ballot index and the offset of the first substrate density of each agent's voxel, so the remaining
+// stages (and subsequent non-recomputing steps) do not have to map positions to voxels again
 template <index_t dims>
-void clear_ballots(const auto ballot_l, const real_t* HWY_RESTRICT cell_positions,
-				   const uint8_t* HWY_RESTRICT is_active, std::atomic<index_t>* HWY_RESTRICT ballots,
-				   std::atomic<real_t>* HWY_RESTRICT reduced_numerators,
-				   std::atomic<real_t>* HWY_RESTRICT reduced_denominators,
-				   std::atomic<real_t>* HWY_RESTRICT reduced_factors, index_t n, const cartesian_mesh& m,
-				   index_t substrate_densities)
+void clear_ballots(const auto dens_l, const auto ballot_l, const real_t* HWY_RESTRICT cell_positions,
+				   const index_t* HWY_RESTRICT active_indices, std::atomic<index_t>* HWY_RESTRICT ballots,
+				   const real_t* HWY_RESTRICT substrates, index_t* HWY_RESTRICT voxel_indices,
+				   index_t* HWY_RESTRICT density_offsets, real_t* HWY_RESTRICT reduced_numerators,
+				   real_t* HWY_RESTRICT reduced_denominators, real_t* HWY_RESTRICT reduced_factors,
+				   std::uint64_t* HWY_RESTRICT reduced_masks, index_t n, const cartesian_mesh& m,
+				   index_t substrates_count)
 {
-#pragma omp for
-	for (index_t i = 0; i < n; i++)
+#pragma omp for schedule(dynamic, agents_chunk_size) nowait
+	for (index_t k = 0; k < n; k++)
 	{
-		if (!is_active[i])
-			continue;
+		const index_t i = active_indices[k];
+
+		auto fixed_dims = fix_dims<dims>(cell_positions + dims * i, m);
 
-		auto b_l = ballot_l ^ fix_dims<dims>(cell_positions + dims * i, m);
+		auto& b = (ballot_l ^ fixed_dims) | noarr::get_at(ballots);
+		auto& density = (dens_l ^ fixed_dims) | noarr::get_at<'s'>(substrates, 0);
 
-		auto& b = b_l | noarr::get_at(ballots);
+		voxel_indices[i] = &b - ballots;
+		density_offsets[i] = &density - substrates;
 
 		b.store(no_ballot, std::memory_order_relaxed);
 
-		for (index_t s = 0; s < substrate_densities; s++)
-		{
-			reduced_numerators[i * substrate_densities + s].store(0, std::memory_order_relaxed);
-			reduced_denominators[i * substrate_densities + s].store(0, std::memory_order_relaxed);
-			reduced_factors[i * substrate_densities + s].store(0, std::memory_order_relaxed);
-		}
+		// agents sum only their masked substrates, so with sparse interactions the implicit 1 of the denominator is
+		// set here for all of them
+		std::fill_n(reduced_numerators + i * substrates_count, substrates_count, 0);
+		std::fill_n(reduced_denominators + i * substrates_count, substrates_count, reduced_masks ? 1 : 0);
+		std::fill_n(reduced_factors + i * substrates_count, substrates_count, 0);
+
+		if (reduced_masks)
+			reduced_masks[i] = 0;
 	}
 }
 
 void compute_intermediates(real_t* HWY_RESTRICT numerators, real_t* HWY_RESTRICT denominators,
-						   real_t* HWY_RESTRICT factors, const real_t* HWY_RESTRICT secretion_rates,
-						   const real_t* HWY_RESTRICT uptake_rates, const real_t* HWY_RESTRICT saturation_densities,
-						   const real_t* HWY_RESTRICT net_export_rates, const real_t* HWY_RESTRICT cell_volumes,
-						   const uint8_t* HWY_RESTRICT is_active, real_t voxel_volume, real_t time_step, index_t n,
-						   index_t substrates_count)
+						   real_t* HWY_RESTRICT factors, const parameter_t* HWY_RESTRICT secretion_rates,
+						   const parameter_t* HWY_RESTRICT uptake_rates,
+						   const parameter_t* HWY_RESTRICT saturation_densities,
+						   const parameter_t* HWY_RESTRICT net_export_rates, const real_t* HWY_RESTRICT cell_volumes,
+						   const index_t* HWY_RESTRICT parameter_rows, const index_t* HWY_RESTRICT active_indices,
+						   std::uint64_t* HWY_RESTRICT interaction_masks, real_t voxel_volume, real_t time_step,
+						   index_t n, index_t substrates_count)
 {
-#pragma omp for
-	for (index_t i = 0; i < n; i++)
-	{
-		if (!is_active[i])
-			continue;
+	const simd_t d;
+	const auto export_factor = hn::Set(d, time_step / voxel_volume);
 
-		for (index_t s = 0; s < substrates_count; s++)
+#pragma omp for schedule(dynamic, agents_chunk_size) nowait
+	for (index_t k = 0; k < n; k++)
+	{
+		const index_t i = active_indices[k];
+
+		const auto volume_factor = hn::Set(d, time_step * cell_volumes[i] / voxel_volume);
+		const index_t offset = i * substrates_count;
+		// parameters shared by agent types are read from the type's row, which stays in cache across its agents
+		const index_t parameters_offset = (parameter_rows ? parameter_rows[i] : i) * substrates_count;
+
+		for_each_substrate_block(substrates_count, [&](index_t s, index_t count) {
+			const auto S = load_block(secretion_rates + parameters_offset + s, count);
+			const auto U = load_block(uptake_rates + parameters_offset + s, count);
+			const auto T = load_block(saturation_densities + parameters_offset + s, count);
+			const auto N = load_block(net_export_rates + parameters_offset + s, count);
+
+			store_block(hn::Mul(hn::Mul(S, T), volume_factor), numerators + offset + s, count);
+			store_block(hn::Mul(hn::Add(U, S), volume_factor), denominators + offset + s, count);
+			store_block(hn::Mul(N, export_factor), factors + offset + s, count);
+		});
+
+		// substrates the agent neither adds to nor scales are left out of its mask
+		if (interaction_masks)
 		{
-			numerators[i * substrates_count + s] = secretion_rates[i * substrates_count + s]
-												   * saturation_densities[i * substrates_count + s] * time_step
-												   * cell_volumes[i] / voxel_volume;
-
-			denominators[i * substrates_count + s] =
-				(uptake_rates[i * substrates_count + s] + secretion_rates[i * substrates_count + s]) * time_step
-				* cell_volumes[i] / voxel_volume;
+			std::uint64_t mask = 0;
+			for (index_t s = 0; s < substrates_count; s++)
+				if (numerators[offset + s] != 0 || denominators[offset + s] != 0 || factors[offset + s] != 0)
+					mask |= std::uint64_t(1) << s;
 
-			factors[i * substrates_count + s] = net_export_rates[i * substrates_count + s] * time_step / voxel_volume;
+			interaction_masks[i] = mask;
 		}
 	}
 }
 
-template <index_t dims>
-void ballot_and_sum(const auto ballot_l, std::atomic<real_t>* HWY_RESTRICT reduced_numerators,
-					std::atomic<real_t>* HWY_RESTRICT reduced_denominators,
-					std::atomic<real_t>* HWY_RESTRICT reduced_factors, const real_t* HWY_RESTRICT numerators,
+void ballot_and_sum(real_t* HWY_RESTRICT reduced_numerators, real_t* HWY_RESTRICT reduced_denominators,
+					real_t* HWY_RESTRICT reduced_factors, const real_t* HWY_RESTRICT numerators,
 					const real_t* HWY_RESTRICT denominators, const real_t* HWY_RESTRICT factors,
-					const real_t* HWY_RESTRICT cell_positions, const uint8_t* HWY_RESTRICT is_active,
+					const index_t* HWY_RESTRICT active_indices, const index_t* HWY_RESTRICT voxel_indices,
+					const std::uint64_t* HWY_RESTRICT interaction_masks, std::uint64_t* HWY_RESTRICT reduced_masks,
 					std::atomic<index_t>* HWY_RESTRICT ballots, index_t n, index_t substrates_count,
-					const cartesian_mesh& m, std::atomic<bool>* HWY_RESTRICT is_conflict)
+					std::atomic<bool>* HWY_RESTRICT is_conflict)
 {
-#pragma omp for
-	for (index_t i = 0; i < n; i++)
+#pragma omp for schedule(dynamic, agents_chunk_size) nowait
+	for (index_t k = 0; k < n; k++)
 	{
-		if (!is_active[i])
-			continue;
-
-		auto b_l = ballot_l ^ fix_dims<dims>(cell_positions + dims * i, m);
+		const index_t i = active_indices[k];
 
-		auto& b = b_l | noarr::get_at(ballots);
+		auto& b = ballots[voxel_indices[i]];
 
 		auto expected = no_ballot;
 		const bool success =
 			b.compare_exchange_strong(expected, i, std::memory_order_acq_rel, std::memory_order_acquire);
 
-		if (success)
+		const index_t owner = success ? i : expected;
+
+		if (!success)
+			is_conflict[0].store(true, std::memory_order_relaxed);
+
+		if (interaction_masks)
 		{
-			for (index_t s = 0; s < substrates_count; s++)
-			{
-				reduced_numerators[i * substrates_count + s].fetch_add(numerators[i * substrates_count + s],
-																	   std::memory_order_relaxed);
-				reduced_denominators[i * substrates_count + s].fetch_add(denominators[i * substrates_count + s] + 1,
-																		 std::memory_order_relaxed);
-				reduced_factors[i * substrates_count + s].fetch_add(factors[i * substrates_count + s],
-																	std::memory_order_relaxed);
-			}
+			std::atomic_ref<std::uint64_t>(reduced_masks[owner])
+				.fetch_or(interaction_masks[i], std::memory_order_relaxed);
+
+			for_each_masked_substrate(interaction_masks[i], [&](index_t s) {
+				std::atomic_ref<real_t>(reduced_numerators[owner * substrates_count + s])
+					.fetch_add(numerators[i * substrates_count + s], std::memory_order_relaxed);
+				std::atomic_ref<real_t>(reduced_denominators[owner * substrates_count + s])
+					.fetch_add(denominators[i * substrates_count + s], std::memory_order_relaxed);
+				std::atomic_ref<real_t>(reduced_factors[owner * substrates_count + s])
+					.fetch_add(factors[i * substrates_count + s], std::memory_order_relaxed);
+			});
+
+			continue;
 		}
-		else
-		{
-			is_conflict[0].store(true, std::memory_order_relaxed);
 
-			for (index_t s = 0; s < substrates_count; s++)
-			{
-				reduced_numerators[expected * substrates_count + s].fetch_add(numerators[i * substrates_count + s],
-																			  std::memory_order_relaxed);
-				reduced_denominators[expected * substrates_count + s].fetch_add(denominators[i * substrates_count + s],
-																				std::memory_order_relaxed);
-				reduced_factors[expected * substrates_count + s].fetch_add(factors[i * substrates_count + s],
-																		   std::memory_order_relaxed);
-			}
+		// the owner adds the implicit 1 of the denominator exactly once
+		const real_t denominator_base = success ? 1 : 0;
+
+		for (index_t s = 0; s < substrates_count; s++)
+		{
+			std::atomic_ref<real_t>(reduced_numerators[owner * substrates_count + s])
+				.fetch_add(numerators[i * substrates_count + s], std::memory_order_relaxed);
+			std::atomic_ref<real_t>(reduced_denominators[owner * substrates_count + s])
+				.fetch_add(denominators[i * substrates_count + s] + denominator_base, std::memory_order_relaxed);
+			std::atomic_ref<real_t>(reduced_factors[owner * substrates_count + s])
+				.fetch_add(factors[i * substrates_count + s], std::memory_order_relaxed);
 		}
 	}
 }
 
-template <typename density_layout_t>
+// I -= v * (num - D * den + fac)
 void compute_internalized(real_t* HWY_RESTRICT internalized_substrates, const real_t* HWY_RESTRICT substrate_densities,
 						  const real_t* HWY_RESTRICT numerator, const real_t* HWY_RESTRICT denominator,
-						  const real_t* HWY_RESTRICT factor, real_t voxel_volume, density_layout_t dens_l)
+						  const real_t* HWY_RESTRICT factor, real_t voxel_volume, index_t substrates_count)
 {
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const auto v = hn::Set(simd_t(), voxel_volume);
 
-	for (index_t s = 0; s < substrates_count; s++)
-	{
-		internalized_substrates[s] -=
-			voxel_volume
-			* (numerator[s] - (dens_l | noarr::get_at<'s'>(substrate_densities, s)) * denominator[s] + factor[s]);
-	}
+	for_each_substrate_block(substrates_count, [&](index_t s, index_t count) {
+		const auto D = load_block(substrate_densities + s, count);
+		const auto I = load_block(internalized_substrates + s, count);
+
+		const auto N = load_block(numerator + s, count);
+
+		const auto delta =
+			hn::Add(hn::NegMulAdd(D, load_block(denominator + s, count), N), load_block(factor + s, count));
+
+		store_block(hn::NegMulAdd(v, delta, I), internalized_substrates + s, count);
+	});
 }
 
-template <typename density_layout_t>
-void compute_densities(real_t* HWY_RESTRICT substrate_densities, const std::atomic<real_t>* HWY_RESTRICT numerator,
-					   const std::atomic<real_t>* HWY_RESTRICT denominator,
-					   const std::atomic<real_t>* HWY_RESTRICT factor, bool has_ballot, density_layout_t dens_l)
+// D = (D + num) / den + fac
+void compute_densities(real_t* HWY_RESTRICT substrate_densities, const real_t* HWY_RESTRICT numerator,
+					   const real_t* HWY_RESTRICT denominator, const real_t* HWY_RESTRICT factor,
+					   index_t substrates_count)
 {
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	for_each_substrate_block(substrates_count, [&](index_t s, index_t count) {
+		const auto D = load_block(substrate_densities + s, count);
 
-	if (has_ballot)
-	{
-		for (index_t s = 0; s < substrates_count; s++)
-		{
-			(dens_l | noarr::get_at<'s'>(substrate_densities, s)) =
-				((dens_l | noarr::get_at<'s'>(substrate_densities, s)) + numerator[s].load(std::memory_order_relaxed))
-					/ denominator[s].load(std::memory_order_relaxed)
-				+ factor[s].load(std::memory_order_relaxed);
-		}
-	}
+		const auto N = load_block(numerator + s, count);
+
+		const auto result =
+			hn::Add(hn::Div(hn::Add(D, N), load_block(denominator + s, count)), load_block(factor + s, count));
+
+		store_block(result, substrate_densities + s, count);
+	});
 }
 
-template <typename density_layout_t>
+// D' = (D + num) / den + fac; I += v * (D - D')
 void compute_fused(real_t* HWY_RESTRICT substrate_densities, real_t* HWY_RESTRICT internalized_substrates,
-				   const std::atomic<real_t>* HWY_RESTRICT numerator,
-				   const std::atomic<real_t>* HWY_RESTRICT denominator, const std::atomic<real_t>* HWY_RESTRICT factor,
-				   real_t voxel_volume, density_layout_t dens_l)
+				   const real_t* HWY_RESTRICT numerator, const real_t* HWY_RESTRICT denominator,
+				   const real_t* HWY_RESTRICT factor, real_t voxel_volume, index_t substrates_count)
 {
-	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const auto v = hn::Set(simd_t(), voxel_volume);
 
-	for (index_t s = 0; s < substrates_count; s++)
-	{
-		auto previous_densities = (dens_l | noarr::get_at<'s'>(substrate_densities, s));
+	for_each_substrate_block(substrates_count, [&](index_t s, index_t count) {
+		const auto D = load_block(substrate_densities + s, count);
+		const auto I = load_block(internalized_substrates + s, count);
 
-		(dens_l | noarr::get_at<'s'>(substrate_densities, s)) =
-			((dens_l | noarr::get_at<'s'>(substrate_densities, s)) + numerator[s].load(std::memory_order_relaxed))
-				/ denominator[s].load(std::memory_order_relaxed)
-			+ factor[s].load(std::memory_order_relaxed);
+		const auto N = load_block(numerator + s, count);
 
-		internalized_substrates[s] +=
-			voxel_volume * (previous_densities - (dens_l | noarr::get_at<'s'>(substrate_densities, s)));
-	}
+		const auto result =
+			hn::Add(hn::Div(hn::Add(D, N), load_block(denominator + s, count)), load_block(factor + s, count));
+
+		store_block(result, substrate_densities + s, count);
+		store_block(hn::MulAdd(v, hn::Sub(D, result), I), internalized_substrates + s, count);
+	});
 }
 
-template <index_t dims>
-void compute_result(const auto dens_l, const auto ballot_l, agent_data& data, const cartesian_mesh& mesh,
-					real_t* substrates, const std::atomic<real_t>* reduced_numerators,
-					const std::atomic<real_t>* reduced_denominators, const std::atomic<real_t>* reduced_factors,
-					const real_t* numerators, const real_t* denominators, const real_t* factors,
-					const std::atomic<index_t>* ballots, bool with_internalized, bool is_conflict)
-{
-	auto voxel_volume = (real_t)mesh.voxel_volume(); // expecting that voxel volume is the same for all voxels
+// Sparse variants of the kernels above, substrates out of mask are left unchanged
 
-	if (with_internalized && !is_conflict)
-	{
-#pragma omp for
-		for (index_t i = 0; i < data.base_data.agents_count; i++)
-		{
-			if (!data.is_active[i])
-				continue;
+void compute_internalized_sparse(real_t* HWY_RESTRICT internalized_substrates,
+								 const real_t* HWY_RESTRICT substrate_densities, const real_t* HWY_RESTRICT numerator,
+								 const real_t* HWY_RESTRICT denominator, const real_t* HWY_RESTRICT factor,
+								 real_t voxel_volume, std::uint64_t mask)
+{
+	for_each_masked_substrate(mask, [&](index_t s) {
+		internalized_substrates[s] -=
+			voxel_volume * (numerator[s] - substrate_densities[s] * denominator[s] + factor[s]);
+	});
+}
 
-			auto fixed_dims = fix_dims<dims>(data.base_data.positions.data() + i * dims, mesh);
+void compute_densities_sparse(real_t* HWY_RESTRICT substrate_densities, const real_t* HWY_RESTRICT numerator,
+							  const real_t* HWY_RESTRICT denominator, const real_t* HWY_RESTRICT factor,
+							  std::uint64_t mask)
+{
+	for_each_masked_substrate(mask, [&](index_t s) {
+		substrate_densities[s] = (substrate_densities[s] + numerator[s]) / denominator[s] + factor[s];
+	});
+}
 
-			compute_fused(substrates, data.internalized_substrates.data() + i * data.substrate_count,
-						  reduced_numerators + i * data.substrate_count,
-						  reduced_denominators + i * data.substrate_count, reduced_factors + i * data.substrate_count,
-						  voxel_volume, dens_l ^ fixed_dims);
-		}
+void compute_fused_sparse(real_t* HWY_RESTRICT substrate_densities, real_t* HWY_RESTRICT internalized_substrates,
+						  const real_t* HWY_RESTRICT numerator, const real_t* HWY_RESTRICT denominator,
+						  const real_t* HWY_RESTRICT factor, real_t voxel_volume, std::uint64_t mask)
+{
+	for_each_masked_substrate(mask, [&](index_t s) {
+		const real_t previous = substrate_densities[s];
 
-		return;
-	}
+		substrate_densities[s] = (previous + numerator[s]) / denominator[s] + factor[s];
+		internalized_substrates[s] += voxel_volume * (previous - substrate_densities[s]);
+	});
+}
 
-#pragma omp for
-	for (index_t i = 0; i < data.base_data.agents_count; i++)
-	{
-		if (!data.is_active[i])
-			continue;
+double compute_result(agent_data& data, const cartesian_mesh& mesh, real_t* substrates,
+					  const real_t* reduced_numerators, const real_t* reduced_denominators,
+					  const real_t* reduced_factors, const real_t* numerators, const real_t* denominators,
+					  const real_t* factors, const std::atomic<index_t>* ballots, const index_t* voxel_indices,
+					  const index_t* density_offsets, const std::uint64_t* interaction_masks,
+					  const std::uint64_t* reduced_masks, bool with_internalized, bool is_conflict)
+{
+	auto voxel_volume = (real_t)mesh.voxel_volume(); // expecting that voxel volume is the same for all voxels
 
-		auto fixed_dims = fix_dims<dims>(data.base_data.positions.data() + i * dims, mesh);
+	const index_t substrates_count = data.substrate_count;
+	const index_t* active_indices = data.active_indices.data();
+	const index_t active_count = data.active_indices.size();
 
-		auto ballot = ((ballot_l ^ fixed_dims) | noarr::get_at(ballots)).load(std::memory_order_relaxed);
-		compute_densities(substrates, reduced_numerators + i * data.substrate_count,
-						  reduced_denominators + i * data.substrate_count, reduced_factors + i * data.substrate_count,
-						  ballot == i, dens_l ^ fixed_dims);
+	if (with_internalized && !is_conflict)
+	{
+		return timed([&] {
+#pragma omp for schedule(dynamic, agents_chunk_size) nowait
+			for (index_t k = 0; k < active_count; k++)
+			{
+				const index_t i = active_indices[k];
+
+				if (reduced_masks)
+					compute_fused_sparse(substrates + density_offsets[i],
+										 data.internalized_substrates.data() + i * substrates_count,
+										 reduced_numerators + i * substrates_count,
+										 reduced_denominators + i * substrates_count,
+										 reduced_factors + i * substrates_count, voxel_volume, reduced_masks[i]);
+				else
+					compute_fused(substrates + density_offsets[i],
+								  data.internalized_substrates.data() + i * substrates_count,
+								  reduced_numerators + i * substrates_count,
+								  reduced_denominators + i * substrates_count, reduced_factors + i * substrates_count,
+								  voxel_volume, substrates_count);
+			}
+		});
 	}
 
-	if (with_internalized)
-	{
-#pragma omp for
-		for (index_t i = 0; i < data.base_data.agents_count; i++)
+	double busy_time = timed([&] {
+#pragma omp for schedule(dynamic, agents_chunk_size) nowait
+		for (index_t k = 0; k < active_count; k++)
 		{
-			if (!data.is_active[i])
-				continue;
+			const index_t i = active_indices[k];
 
-			auto fixed_dims = fix_dims<dims>(data.base_data.positions.data() + i * dims, mesh);
+			if (ballots[voxel_indices[i]].load(std::memory_order_relaxed) != i)
+				continue;
 
-			compute_internalized(data.internalized_substrates.data() + i * data.substrate_count, substrates,
-								 numerators + i * data.substrate_count, denominators + i * data.substrate_count,
-								 factors + i * data.substrate_count, voxel_volume, dens_l ^ fixed_dims);
+			if (reduced_masks)
+				compute_densities_sparse(substrates + density_offsets[i], reduced_numerators + i * substrates_count,
+										 reduced_denominators + i * substrates_count,
+										 reduced_factors + i * substrates_count, reduced_masks[i]);
+			else
+				compute_densities(substrates + density_offsets[i], reduced_numerators + i * substrates_count,
+								  reduced_denominators + i * substrates_count, reduced_factors + i * substrates_count,
+								  substrates_count);
 		}
+	});
+
+	if (with_internalized)
+	{
+#pragma omp barrier
+
+		busy_time += timed([&] {
+#pragma omp for schedule(dynamic, agents_chunk_size) nowait
+			for (index_t k = 0; k < active_count; k++)
+			{
+				const index_t i = active_indices[k];
+
+				if (interaction_masks)
+					compute_internalized_sparse(data.internalized_substrates.data() + i * substrates_count,
+												substrates + density_offsets[i], numerators + i * substrates_count,
+												denominators + i * substrates_count, factors + i * substrates_count,
+												voxel_volume, interaction_masks[i]);
+				else
+					compute_internalized(data.internalized_substrates.data() + i * substrates_count,
+										 substrates + density_offsets[i], numerators + i * substrates_count,
+										 denominators + i * substrates_count, factors + i * substrates_count,
+										 voxel_volume, substrates_count);
+			}
+		});
 	}
+
+	return busy_time;
 }
 
 template <index_t dims>
 void simulate(const auto dens_l, const auto ballot_l, agent_data& data, microenvironment& m, real_t* substrates,
-			  std::atomic<real_t>* reduced_numerators, std::atomic<real_t>* reduced_denominators,
-			  std::atomic<real_t>* reduced_factors, real_t* numerators, real_t* denominators, real_t* factors,
-			  std::atomic<index_t>* ballots, bool recompute, bool with_internalized,
-			  std::atomic<bool>* HWY_RESTRICT is_conflict)
+			  real_t* reduced_numerators, real_t* reduced_denominators, real_t* reduced_factors, real_t* numerators,
+			  real_t* denominators, real_t* factors, std::atomic<index_t>* ballots, index_t* voxel_indices,
+			  index_t* density_offsets, std::uint64_t* interaction_masks, std::uint64_t* reduced_masks, bool recompute,
+			  bool with_internalized, std::atomic<bool>* HWY_RESTRICT is_conflict,
+			  double* HWY_RESTRICT thread_busy_times)
 {
+	double busy_time = 0;
+
 	if (recompute)
 	{
-		compute_intermediates(numerators, denominators, factors, data.secretion_rates.data(), data.uptake_rates.data(),
-							  data.saturation_densities.data(), data.net_export_rates.data(), data.volumes.data(),
-							  data.is_active.data(), (real_t)m.mesh.voxel_volume(), m.diffusion_timestep,
-							  data.base_data.agents_count, data.substrate_count);
-
-		clear_ballots<dims>(ballot_l, data.base_data.positions.data(), data.is_active.data(), ballots,
-							reduced_numerators, reduced_denominators, reduced_factors, data.base_data.agents_count,
-							m.mesh, data.substrate_count);
-
-		ballot_and_sum<dims>(ballot_l, reduced_numerators, reduced_denominators, reduced_factors, numerators,
-							 denominators, factors, data.base_data.positions.data(), data.is_active.data(), ballots,
-							 data.base_data.agents_count, data.substrate_count, m.mesh, is_conflict);
+		// intermediates and ballots touch disjoint data, no barrier is needed in between
+		busy_time += timed([&] {
+			compute_intermediates(numerators, denominators, factors, data.secretion_rates.data(),
+								  data.uptake_rates.data(), data.saturation_densities.data(),
+								  data.net_export_rates.data(), data.volumes.data(),
+								  data.shared_parameters ? data.parameter_rows.data() : nullptr,
+								  data.active_indices.data(), interaction_masks, (real_t)m.mesh.voxel_volume(),
+								  m.diffusion_timestep, data.active_indices.size(), data.substrate_count);
+
+			clear_ballots<dims>(dens_l, ballot_l, data.base_data.positions.data(), data.active_indices.data(),
+								ballots, substrates, voxel_indices, density_offsets, reduced_numerators,
+								reduced_denominators, reduced_factors, reduced_masks, data.active_indices.size(),
+								m.mesh, data.substrate_count);
+		});
+
+#pragma omp barrier
+
+		busy_time += timed([&] {
+			ballot_and_sum(reduced_numerators, reduced_denominators, reduced_factors, numerators, denominators,
+						   factors, data.active_indices.data(), voxel_indices, interaction_masks, reduced_masks,
+						   ballots, data.active_indices.size(), data.substrate_count, is_conflict);
+		});
+
+#pragma omp barrier
 	}
 
-	compute_result<dims>(dens_l, ballot_l, data, m.mesh, substrates, reduced_numerators, reduced_denominators,
-						 reduced_factors, numerators, denominators, factors, ballots, with_internalized,
-						 is_conflict[0].load(std::memory_order_relaxed));
+	busy_time += compute_result(data, m.mesh, substrates, reduced_numerators, reduced_denominators, reduced_factors,
+								numerators, denominators, factors, ballots, voxel_indices, density_offsets,
+								interaction_masks, reduced_masks, with_internalized,
+								is_conflict[0].load(std::memory_order_relaxed));
+
+	thread_busy_times[get_thread_num()] = busy_time;
+
+#pragma omp barrier
 }
 
 template <typename density_layout_t>
 void release_internal(real_t* HWY_RESTRICT substrate_densities, real_t* HWY_RESTRICT internalized_substrates,
-					  const real_t* HWY_RESTRICT fraction_released_at_death, real_t voxel_volume,
+					  const parameter_t* HWY_RESTRICT fraction_released_at_death, real_t voxel_volume,
 					  density_layout_t dens_l)
 {
 	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
@@ -294,9 +483,71 @@ void release_dim(const auto dens_l, agent_data& data, const cartesian_mesh& mesh
 	auto voxel_volume = (real_t)mesh.voxel_volume(); // expecting that voxel volume is the same for all voxels
 
 	release_internal(substrates, data.internalized_substrates.data() + index * data.substrate_count,
-					 data.fraction_released_at_death.data() + index * data.substrate_count, voxel_volume,
+					 data.fraction_released_at_death.data() + data.parameters_row(index) * data.substrate_count,
+					 voxel_volume,
 					 dens_l ^ fix_dims<dims>(data.base_data.positions.data() + index * dims, mesh));
 }
+
+// Agents releasing into the same voxel are made adjacent by sorting on the voxel's density offset, so every voxel is
+// reduced by a single thread and no atomics are needed
+template <index_t dims>
+void release_batch(const auto dens_l, agent_data& data, const cartesian_mesh& mesh, real_t* substrates,
+				   std::span<const index_t> indices, std::vector<std::pair<index_t, index_t>>& entries,
+				   std::vector<index_t>& segments)
+{
+	const auto voxel_volume = (real_t)mesh.voxel_volume(); // expecting that voxel volume is the same for all voxels
+	const index_t substrates_count = data.substrate_count;
+
+#pragma omp single
+	entries.resize(indices.size());
+
+#pragma omp for
+	for (index_t k = 0; k < indices.size(); k++)
+	{
+		const index_t i = indices[k];
+
+		auto& density = (dens_l ^ fix_dims<dims>(data.base_data.positions.data() + i * dims, mesh))
+						| noarr::get_at<'s'>(substrates, 0);
+
+		entries[k] = { static_cast<index_t>(&density - substrates), i };
+	}
+
+#pragma omp single
+	{
+		std::sort(entries.begin(), entries.end());
+
+		// a duplicate index would release the agent's substrates twice, duplicates are adjacent once sorted
+		assert(std::adjacent_find(entries.begin(), entries.end()) == entries.end()
+			   && "Agents released in a batch must be unique");
+
+		segments.clear();
+		for (index_t k = 0; k < entries.size(); k++)
+			if (k == 0 || entries[k].first != entries[k - 1].first)
+				segments.push_back(k);
+		segments.push_back(entries.size());
+	}
+
+#pragma omp for
+	for (index_t segment = 0; segment < segments.size() - 1; segment++)
+	{
+		real_t* HWY_RESTRICT densities = substrates + entries[segments[segment]].first;
+
+		for (index_t k = segments[segment]; k < segments[segment + 1]; k++)
+		{
+			const index_t i = entries[k].second;
+
+			real_t* HWY_RESTRICT internalized = data.internalized_substrates.data() + i * substrates_count;
+			const parameter_t* HWY_RESTRICT fraction =
+				data.fraction_released_at_death.data() + data.parameters_row(i) * substrates_count;
+
+			for (index_t s = 0; s < substrates_count; s++)
+			{
+				densities[s] += internalized[s] * fraction[s] / voxel_volume;
+				internalized[s] = 0;
+			}
+		}
+	}
+}
 } // namespace
 
 void cell_solver::simulate_secretion_and_uptake(microenvironment& m, diffusion_solver& d_solver, bool recompute)
@@ -304,21 +555,38 @@ void cell_solver::simulate_secretion_and_uptake(microenvironment& m, diffusion_s
 	real_t* substrates = d_solver.get_substrates_pointer();
 
 #pragma omp single
-	if (recompute)
 	{
-		resize(m);
-		is_conflict_.store(false, std::memory_order_relaxed);
+		// agents activated or deactivated since the last recompute change the voxel sums as well
+		auto& data = retrieve_agent_data(*m.agents);
+		recomputing_ = recompute || data.active_indices_dirty.load(std::memory_order_relaxed);
+
+		if (recomputing_)
+		{
+			resize(m);
+			data.refresh_active_indices();
+			is_conflict_.store(false, std::memory_order_relaxed);
+		}
+
+		thread_busy_times_.assign(get_num_threads(), 0);
 	}
 
+	// read before the first barrier of the kernels, so the next call can not overwrite it yet
+	recompute = recomputing_;
+
+	std::uint64_t* interaction_masks = sparse_interactions_ ? interaction_masks_.data() : nullptr;
+	std::uint64_t* reduced_masks = sparse_interactions_ ? reduced_masks_.data() : nullptr;
+
 	switch (m.mesh.dims)
 	{
 		case 1: {
 			const auto dens_l = d_solver.get_substrates_layout<1>();
 			const auto ballot_l = noarr::scalar<std::atomic<index_t>>() ^ noarr::vectors<'x'>(m.mesh.grid_shape[0]);
 
-			simulate<1>(dens_l, ballot_l, retrieve_agent_data(*m.agents), m, substrates, reduced_numerators_.get(),
-						reduced_denominators_.get(), reduced_factors_.get(), numerators_.data(), denominators_.data(),
-						factors_.data(), ballots_.get(), recompute, compute_internalized_substrates_, &is_conflict_);
+			simulate<1>(dens_l, ballot_l, retrieve_agent_data(*m.agents), m, substrates, reduced_numerators_.data(),
+						reduced_denominators_.data(), reduced_factors_.data(), numerators_.data(), denominators_.data(),
+						factors_.data(), ballots_.get(), voxel_indices_.data(), density_offsets_.data(),
+						interaction_masks, reduced_masks, recompute, compute_internalized_substrates_, &is_conflict_,
+						thread_busy_times_.data());
 			return;
 		}
 		case 2: {
@@ -326,9 +594,11 @@ void cell_solver::simulate_secretion_and_uptake(microenvironment& m, diffusion_s
 			const auto ballot_l = noarr::scalar<std::atomic<index_t>>()
 								  ^ noarr::vectors<'x', 'y'>(m.mesh.grid_shape[0], m.mesh.grid_shape[1]);
 
-			simulate<2>(dens_l, ballot_l, retrieve_agent_data(*m.agents), m, substrates, reduced_numerators_.get(),
-						reduced_denominators_.get(), reduced_factors_.get(), numerators_.data(), denominators_.data(),
-						factors_.data(), ballots_.get(), recompute, compute_internalized_substrates_, &is_conflict_);
+			simulate<2>(dens_l, ballot_l, retrieve_agent_data(*m.agents), m, substrates, reduced_numerators_.data(),
+						reduced_denominators_.data(), reduced_factors_.data(), numerators_.data(), denominators_.data(),
+						factors_.data(), ballots_.get(), voxel_indices_.data(), density_offsets_.data(),
+						interaction_masks, reduced_masks, recompute, compute_internalized_substrates_, &is_conflict_,
+						thread_busy_times_.data());
 			return;
 		}
 		case 3: {
@@ -337,9 +607,11 @@ void cell_solver::simulate_secretion_and_uptake(microenvironment& m, diffusion_s
 				noarr::scalar<std::atomic<index_t>>()
 				^ noarr::vectors<'x', 'y', 'z'>(m.mesh.grid_shape[0], m.mesh.grid_shape[1], m.mesh.grid_shape[2]);
 
-			simulate<3>(dens_l, ballot_l, retrieve_agent_data(*m.agents), m, substrates, reduced_numerators_.get(),
-						reduced_denominators_.get(), reduced_factors_.get(), numerators_.data(), denominators_.data(),
-						factors_.data(), ballots_.get(), recompute, compute_internalized_substrates_, &is_conflict_);
+			simulate<3>(dens_l, ballot_l, retrieve_agent_data(*m.agents), m, substrates, reduced_numerators_.data(),
+						reduced_denominators_.data(), reduced_factors_.data(), numerators_.data(), denominators_.data(),
+						factors_.data(), ballots_.get(), voxel_indices_.data(), density_offsets_.data(),
+						interaction_masks, reduced_masks, recompute, compute_internalized_substrates_, &is_conflict_,
+						thread_busy_times_.data());
 			return;
 		}
 		default:
@@ -373,27 +645,80 @@ void cell_solver::release_internalized_substrates(const microenvironment& m, dif
 	}
 }
 
+void cell_solver::release_internalized_substrates(microenvironment& m, diffusion_solver& d_solver,
+												  std::span<const index_t> indices, bool remove_agents)
+{
+	if (compute_internalized_substrates_)
+	{
+		auto& data = retrieve_agent_data(*m.agents);
+
+		switch (m.mesh.dims)
+		{
+			case 1:
+				release_batch<1>(d_solver.get_substrates_layout<1>(), data, m.mesh, d_solver.get_substrates_pointer(),
+								 indices, release_entries_, release_segments_);
+				break;
+			case 2:
+				release_batch<2>(d_solver.get_substrates_layout<2>(), data, m.mesh, d_solver.get_substrates_pointer(),
+								 indices, release_entries_, release_segments_);
+				break;
+			case 3:
+				release_batch<3>(d_solver.get_substrates_layout<3>(), data, m.mesh, d_solver.get_substrates_pointer(),
+								 indices, release_entries_, release_segments_);
+				break;
+			default:
+				assert(false);
+				break;
+		}
+	}
+
+	if (remove_agents)
+	{
+#pragma omp single
+		m.agents->remove_many(indices);
+	}
+}
+
+std::span<const double> cell_solver::get_thread_busy_times() const { return thread_busy_times_; }
+
 void cell_solver::resize(const microenvironment& m)
 {
-	auto prev_capacity = numerators_.capacity();
+	const index_t agents_count = m.agents->size();
+
+	numerators_.resize(m.substrates_count * agents_count);
+	denominators_.resize(m.substrates_count * agents_count);
+	factors_.resize(m.substrates_count * agents_count);
 
-	numerators_.resize(m.substrates_count * m.agents->size());
-	denominators_.resize(m.substrates_count * m.agents->size());
-	factors_.resize(m.substrates_count * m.agents->size());
+	reduced_numerators_.resize(m.substrates_count * agents_count);
+	reduced_denominators_.resize(m.substrates_count * agents_count);
+	reduced_factors_.resize(m.substrates_count * agents_count);
 
-	auto new_capacity = numerators_.capacity();
+	voxel_indices_.resize(agents_count);
+	density_offsets_.resize(agents_count);
 
-	if (new_capacity != prev_capacity)
+	if (sparse_interactions_)
 	{
-		reduced_numerators_ = std::make_unique<std::atomic<real_t>[]>(new_capacity);
-		reduced_denominators_ = std::make_unique<std::atomic<real_t>[]>(new_capacity);
-		reduced_factors_ = std::make_unique<std::atomic<real_t>[]>(new_capacity);
+		interaction_masks_.resize(agents_count);
+		reduced_masks_.resize(agents_count);
 	}
+
+	// agent loops are scheduled dynamically, so no thread owns a fixed range of agents that first touch could place on
+	// its node; large per-agent arrays (reallocated as agents are added) are re-advised to use huge pages instead
+	auto& data = retrieve_agent_data(*m.agents);
+
+	advise_huge_pages(data.base_data.positions, data.secretion_rates, data.saturation_densities, data.uptake_rates,
+					  data.net_export_rates, data.internalized_substrates, data.fraction_released_at_death,
+					  data.volumes);
+	advise_huge_pages(numerators_, denominators_, factors_, voxel_indices_, density_offsets_);
 }
 
 void cell_solver::initialize(const microenvironment& m)
 {
 	compute_internalized_substrates_ = m.compute_internalized_substrates;
+	sparse_interactions_ = m.sparse_agent_interactions;
+
+	if (sparse_interactions_ && m.substrates_count > std::numeric_limits<std::uint64_t>::digits)
+		throw std::runtime_error("Sparse agent interactions support at most 64 substrates");
 
 	resize(m);
 
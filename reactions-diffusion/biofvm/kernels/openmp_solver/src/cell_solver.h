@@ -1,7 +1,10 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include <biofvm/microenvironment.h>
@@ -36,6 +39,16 @@ Also handles release of internalized substrates:
 F = fraction released at death
 
 D = D + I*F/v
+
+A batch of dying agents is released by sorting them by voxel and reducing each voxel's contributions by one thread.
+
+Optimizations:
+- Per-agent kernels are vectorized over substrates using Highway, substrates of an agent are contiguous in agent_data
+and so are the substrates of a voxel in the diffusion solver layout
+- Agent loops are scheduled dynamically in chunks to balance spatially clustered populations
+- Voxel of each agent is resolved once per recompute and cached as an offset into ballots and substrate densities
+- With sparse agent interactions, substrates an agent has zero rates of are masked out on recompute, and the voxel
+reductions and updates of each step visit only the masked substrates of the agents in the voxel
 */
 
 namespace physicore::biofvm::kernels::openmp_solver {
@@ -43,17 +56,37 @@ namespace physicore::biofvm::kernels::openmp_solver {
 class cell_solver : private generic_agent_solver<agent>
 {
 	bool compute_internalized_substrates_;
+	bool sparse_interactions_;
 
 	std::vector<real_t> numerators_;
 	std::vector<real_t> denominators_;
 	std::vector<real_t> factors_;
 
-	std::unique_ptr<std::atomic<real_t>[]> reduced_numerators_;
-	std::unique_ptr<std::atomic<real_t>[]> reduced_denominators_;
-	std::unique_ptr<std::atomic<real_t>[]> reduced_factors_;
+	// accessed through std::atomic_ref while ballots are being resolved
+	std::vector<real_t> reduced_numerators_;
+	std::vector<real_t> reduced_denominators_;
+	std::vector<real_t> reduced_factors_;
+
+	// per-agent voxel index into ballots_ and offset of the voxel's densities, cached on recompute
+	std::vector<index_t> voxel_indices_;
+	std::vector<index_t> density_offsets_;
+
+	// per-agent bit masks of the substrates the agent changes and of those changed by the agents of its voxel (when it
+	// owns the ballot), cached on recompute with sparse interactions
+	std::vector<std::uint64_t> interaction_masks_;
+	std::vector<std::uint64_t> reduced_masks_;
 
 	std::atomic<bool> is_conflict_;
 
+	// whether the running simulate_secretion_and_uptake call recomputes, decided by one thread for the whole team
+	bool recomputing_ = false;
+
+	std::vector<double> thread_busy_times_;
+
+	// (voxel density offset, agent index) pairs and voxel segment starts of a batched release
+	std::vector<std::pair<index_t, index_t>> release_entries_;
+	std::vector<index_t> release_segments_;
+
 	std::unique_ptr<std::atomic<index_t>[]> ballots_;
 
 	void resize(const microenvironment& m);
@@ -63,9 +96,21 @@ class cell_solver : private generic_agent_solver<agent>
 public:
 	void initialize(const microenvironment& m);
 
+	// Recomputes also when the active agents changed since the last call (agent_data::active_indices_dirty)
 	void simulate_secretion_and_uptake(microenvironment& m, diffusion_solver& d_solver, bool recompute);
 
 	void release_internalized_substrates(const microenvironment& m, diffusion_solver& d_solver, index_t index);
+
+	// Releases internalized substrates of all agents in indices in parallel and optionally removes them from the agent
+	// container in the same pass. Must be called by the whole team of a parallel region. Indices must be unique, which
+	// is asserted in debug builds.
+	// Removal moves agents around, so the next simulate_secretion_and_uptake call has to recompute.
+	void release_internalized_substrates(microenvironment& m, diffusion_solver& d_solver,
+										 std::span<const index_t> indices, bool remove_agents);
+
+	// Time in seconds each thread of the team spent working in the agent loops of the last
+	// simulate_secretion_and_uptake call, excluding the time spent waiting on barriers
+	std::span<const double> get_thread_busy_times() const;
 };
 
 } // namespace physicore::biofvm::kernels::openmp_solver
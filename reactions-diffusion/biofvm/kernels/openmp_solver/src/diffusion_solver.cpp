@@ -1,11 +1,13 @@
 #include "diffusion_solver.h"
 
+#include <algorithm>
+
 #include <common/types.h>
 #include <hwy/aligned_allocator.h>
 #include <hwy/base.h>
 #include <noarr/structures/interop/bag.hpp>
 
-#include "solver_utils.h"
+#include "omp_helper.h"
 
 using namespace physicore;
 using namespace physicore::biofvm::kernels::openmp_solver;
@@ -26,6 +28,18 @@ real_t* diffusion_solver::get_substrates_pointer() { return substrates_.get(); }
 
 const real_t* diffusion_solver::get_substrates_pointer() const { return substrates_.get(); }
 
+std::size_t diffusion_solver::padded_xs_size() const
+{
+	const std::size_t xs_size = problem.nx * problem.substrates_count * sizeof(real_t);
+	return (xs_size + alignment_size_ - 1) / alignment_size_ * alignment_size_ / sizeof(real_t);
+}
+
+std::array<index_t, 4> diffusion_solver::get_substrates_strides() const
+{
+	const index_t xs_size_padded = padded_xs_size();
+	return { 1, problem.substrates_count, xs_size_padded, xs_size_padded * problem.ny };
+}
+
 void diffusion_solver::precompute_values(std::unique_ptr<real_t[]>& b, std::unique_ptr<real_t[]>& c,
 										 std::unique_ptr<real_t[]>& e, index_t shape, index_t dims, index_t n,
 										 index_t copies)
@@ -92,11 +106,35 @@ void diffusion_solver::prepare(const microenvironment& m, index_t iterations)
 
 	auto substrates_layout = get_substrates_layout<3>();
 
-	this->substrates_ = hwy::MakeUniqueAlignedArray<real_t>((substrates_layout | noarr::get_size()) / sizeof(real_t));
+	this->substrates_ =
+		make_huge_page_array<real_t>((substrates_layout | noarr::get_size()) / sizeof(real_t), alignment_size_);
 
 	// Initialize substrates
-	solver_utils::initialize_substrate_constant(substrates_layout, this->substrates_.get(),
-												problem.initial_conditions.data());
+	// pages are placed by first touch, so the yz rows are split among the solving team exactly as the x sweep does (and
+	// into the same contiguous z plane ranges as the y sweep)
+	const index_t rows = problem.ny * problem.nz;
+	const index_t row_size = padded_xs_size();
+	const index_t substrates_count = problem.substrates_count;
+	const real_t* initial_conditions = problem.initial_conditions.data();
+	real_t* substrates = this->substrates_.get();
+	const execution_context* context = m.context.get();
+
+#pragma omp parallel num_threads(get_team_size(context))
+	{
+		const auto pin = pin_to_context(context);
+
+#pragma omp for schedule(static)
+		for (index_t row = 0; row < rows; row++)
+		{
+			real_t* HWY_RESTRICT row_densities = substrates + row * row_size;
+
+			for (index_t x = 0; x < problem.nx; x++)
+				for (index_t s = 0; s < substrates_count; s++)
+					row_densities[x * substrates_count + s] = initial_conditions[s];
+
+			std::fill(row_densities + problem.nx * substrates_count, row_densities + row_size, 0);
+		}
+	}
 }
 
 
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <memory>
 
+#include <common/memory_placement.h>
 #include <common/types.h>
 #include <hwy/aligned_allocator.h>
 #include <noarr/structures_extended.hpp>
@@ -37,6 +39,8 @@ Optimizations:
 - Aligned memory for x dimension (tunable by 'alignment_size')
 - Better temporal locality of memory accesses - sx plane is divided into smaller tiles (tunable by 'xs_tile_size') and
 y/z dimensions are solved alongside tiled xs dimension
+- Densities are backed by transparent huge pages and first touched with the static yz-row partitioning of the x and y
+sweeps, so on NUMA systems each thread sweeps mostly node-local memory
 */
 
 namespace physicore::biofvm::kernels::openmp_solver {
@@ -55,18 +59,19 @@ private:
 
 	std::size_t substrate_copies_;
 
-	hwy::AlignedUniquePtr<real_t[]> substrates_;
+	huge_page_array<real_t> substrates_;
 
 	void precompute_values(std::unique_ptr<real_t[]>& b, std::unique_ptr<real_t[]>& c, std::unique_ptr<real_t[]>& e,
 						   index_t shape, index_t dims, index_t n, index_t copies);
 
+	// Length of an sx plane row in elements, padded to 'alignment_size'
+	std::size_t padded_xs_size() const;
+
 public:
 	template <std::size_t dims = 3>
 	auto get_substrates_layout() const
 	{
-		std::size_t xs_size = problem.nx * problem.substrates_count * sizeof(real_t);
-		std::size_t xs_size_padded = (xs_size + alignment_size_ - 1) / alignment_size_ * alignment_size_;
-		xs_size_padded /= sizeof(real_t);
+		const std::size_t xs_size_padded = padded_xs_size();
 
 		if constexpr (dims == 1)
 			return noarr::scalar<real_t>() ^ noarr::vectors<'x'>(xs_size_padded)
@@ -85,6 +90,9 @@ public:
 	real_t* get_substrates_pointer();
 	const real_t* get_substrates_pointer() const;
 
+	// Element strides of s, x, y and z in the substrates layout
+	std::array<index_t, 4> get_substrates_strides() const;
+
 	void prepare(const microenvironment& m, index_t iterations);
 
 	void initialize();
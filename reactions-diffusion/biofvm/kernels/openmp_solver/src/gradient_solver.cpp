@@ -0,0 +1,186 @@
+#include "gradient_solver.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+#include <noarr/structures_extended.hpp>
+
+#include "omp_helper.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+using namespace physicore::biofvm::kernels::openmp_solver;
+
+namespace {
+const real_t* voxel_densities(const auto dens_l, const real_t* substrates, const std::array<index_t, 3>& voxel)
+{
+	return &((dens_l ^ noarr::fix<'x'>(voxel[0]) ^ noarr::fix<'y'>(voxel[1]) ^ noarr::fix<'z'>(voxel[2]))
+			 | noarr::get_at<'s'>(substrates, 0));
+}
+
+template <index_t dims>
+void compute_dim(const auto dens_l, const real_t* substrates, const agent_data& data,
+				 const cartesian_mesh& mesh, real_t* gradients)
+{
+	const index_t substrates_count = data.substrate_count;
+
+#pragma omp for
+	for (index_t i = 0; i < data.base_data.agents_count; i++)
+	{
+		real_t* agent_gradients = gradients + i * substrates_count * dims;
+
+		if (!data.is_active[i])
+		{
+			std::fill_n(agent_gradients, substrates_count * dims, 0);
+			continue;
+		}
+
+		std::array<index_t, 3> voxel =
+			mesh.voxel_position(std::span<const real_t, dims>(data.base_data.positions.data() + i * dims, dims));
+
+		// agents lying exactly on the upper domain boundary belong to the last voxel
+		for (index_t d = 0; d < dims; d++)
+			voxel[d] = std::min(voxel[d], mesh.grid_shape[d] - 1);
+
+		for (index_t d = 0; d < dims; d++)
+		{
+			std::array<index_t, 3> lower = voxel;
+			std::array<index_t, 3> upper = voxel;
+
+			if (voxel[d] > 0)
+				lower[d]--;
+			if (voxel[d] + 1 < mesh.grid_shape[d])
+				upper[d]++;
+
+			if (lower[d] == upper[d])
+			{
+				for (index_t s = 0; s < substrates_count; s++)
+					agent_gradients[s * dims + d] = 0;
+				continue;
+			}
+
+			const real_t inv_distance = 1 / (real_t)((upper[d] - lower[d]) * mesh.voxel_shape[d]);
+
+			const real_t* lower_densities = voxel_densities(dens_l, substrates, lower);
+			const real_t* upper_densities = voxel_densities(dens_l, substrates, upper);
+
+			for (index_t s = 0; s < substrates_count; s++)
+				agent_gradients[s * dims + d] = (upper_densities[s] - lower_densities[s]) * inv_distance;
+		}
+	}
+}
+
+template <index_t dims>
+void compute_field_dim(const auto dens_l, const real_t* substrates, const cartesian_mesh& mesh, index_t s,
+					   index_t dim, real_t* output, int team_size)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+	const index_t nx = mesh.grid_shape[0];
+	const index_t ny = mesh.grid_shape[1];
+	const index_t nz = mesh.grid_shape[2];
+	const index_t n = mesh.grid_shape[dim];
+	const auto dx = (real_t)mesh.voxel_shape[dim];
+
+#pragma omp parallel for collapse(2) num_threads(team_size)
+	for (index_t z = 0; z < nz; z++)
+		for (index_t y = 0; y < ny; y++)
+		{
+			real_t* out = output + (z * ny + y) * nx;
+
+			if (n == 1)
+			{
+				std::fill_n(out, nx, 0);
+				continue;
+			}
+
+			// substrate s of voxel (x, y, z) is at line[x * substrates_count]
+			if (dim == 0)
+			{
+				const real_t* line = voxel_densities(dens_l, substrates, { 0, y, z }) + s;
+				const real_t inv_distance = 1 / (2 * dx);
+
+				out[0] = (line[substrates_count] - line[0]) / dx;
+				out[nx - 1] = (line[(nx - 1) * substrates_count] - line[(nx - 2) * substrates_count]) / dx;
+
+#pragma omp simd
+				for (index_t x = 1; x < nx - 1; x++)
+					out[x] = (line[(x + 1) * substrates_count] - line[(x - 1) * substrates_count]) * inv_distance;
+
+				continue;
+			}
+
+			std::array<index_t, 3> lower = { 0, y, z };
+			std::array<index_t, 3> upper = { 0, y, z };
+
+			if (lower[dim] > 0)
+				lower[dim]--;
+			if (upper[dim] + 1 < n)
+				upper[dim]++;
+
+			const real_t inv_distance = 1 / ((real_t)(upper[dim] - lower[dim]) * dx);
+			const real_t* lower_line = voxel_densities(dens_l, substrates, lower) + s;
+			const real_t* upper_line = voxel_densities(dens_l, substrates, upper) + s;
+
+#pragma omp simd
+			for (index_t x = 0; x < nx; x++)
+				out[x] = (upper_line[x * substrates_count] - lower_line[x * substrates_count]) * inv_distance;
+		}
+}
+} // namespace
+
+void gradient_solver::compute_agent_gradients(microenvironment& m, const diffusion_solver& d_solver)
+{
+	const auto& data = retrieve_agent_data(*m.agents);
+
+#pragma omp single
+	gradients_.resize(data.base_data.agents_count * data.substrate_count * m.mesh.dims);
+
+	switch (m.mesh.dims)
+	{
+		case 1:
+			compute_dim<1>(d_solver.get_substrates_layout<1>(), d_solver.get_substrates_pointer(), data, m.mesh,
+						   gradients_.data());
+			return;
+		case 2:
+			compute_dim<2>(d_solver.get_substrates_layout<2>(), d_solver.get_substrates_pointer(), data, m.mesh,
+						   gradients_.data());
+			return;
+		case 3:
+			compute_dim<3>(d_solver.get_substrates_layout<3>(), d_solver.get_substrates_pointer(), data, m.mesh,
+						   gradients_.data());
+			return;
+		default:
+			assert(false);
+			return;
+	}
+}
+
+std::span<const real_t> gradient_solver::get_agent_gradients() const { return gradients_; }
+
+void gradient_solver::compute_gradient_field(const microenvironment& m, const diffusion_solver& d_solver, index_t s,
+											 index_t dim, std::span<real_t> output)
+{
+	assert(output.size() == m.mesh.voxel_count());
+
+	const int team_size = get_team_size(m.context.get());
+
+	switch (m.mesh.dims)
+	{
+		case 1:
+			compute_field_dim<1>(d_solver.get_substrates_layout<1>(), d_solver.get_substrates_pointer(), m.mesh, s,
+								 dim, output.data(), team_size);
+			return;
+		case 2:
+			compute_field_dim<2>(d_solver.get_substrates_layout<2>(), d_solver.get_substrates_pointer(), m.mesh, s,
+								 dim, output.data(), team_size);
+			return;
+		case 3:
+			compute_field_dim<3>(d_solver.get_substrates_layout<3>(), d_solver.get_substrates_pointer(), m.mesh, s,
+								 dim, output.data(), team_size);
+			return;
+		default:
+			assert(false);
+			return;
+	}
+}
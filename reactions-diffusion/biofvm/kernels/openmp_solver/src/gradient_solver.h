@@ -0,0 +1,44 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <biofvm/microenvironment.h>
+#include <common/generic_agent_solver.h>
+
+#include "diffusion_solver.h"
+
+/*
+Computes substrate gradients at positions of agents, e.g. for chemotaxis.
+
+For each active agent in voxel v and each dimension d, the gradient is the central difference of the neighbouring
+voxels:
+G_d = (D[v + e_d] - D[v - e_d]) / (2*dx_d)
+At the domain boundary, the one-sided difference with the voxel itself is used instead:
+G_d = (D[v + e_d] - D[v]) / dx_d  or  G_d = (D[v] - D[v - e_d]) / dx_d
+Gradients of inactive agents and along dimensions with a single voxel are zero.
+
+The result is a row-major agents x substrates x dims array.
+
+The same differences give full-field gradients of a single substrate along a single dimension, computed line by line
+along x with the x loop vectorized over the strided voxels of the solver layout.
+*/
+
+namespace physicore::biofvm::kernels::openmp_solver {
+
+class gradient_solver : private generic_agent_solver<agent>
+{
+	std::vector<real_t> gradients_;
+
+public:
+	// Must be called by the whole team of a parallel region
+	void compute_agent_gradients(microenvironment& m, const diffusion_solver& d_solver);
+
+	std::span<const real_t> get_agent_gradients() const;
+
+	// Gradient of substrate s along dimension dim in all voxels (x varying fastest), opens its own parallel region
+	static void compute_gradient_field(const microenvironment& m, const diffusion_solver& d_solver, index_t s,
+									   index_t dim, std::span<real_t> output);
+};
+
+} // namespace physicore::biofvm::kernels::openmp_solver
@@ -3,28 +3,13 @@
 #include <algorithm>
 #include <utility>
 
+#include <common/execution_context.h>
 #include <noarr/structures/interop/traverser_iter.hpp>
 
 #ifdef _OPENMP
 	#include <omp.h>
 #endif
 
-template <typename T, typename F>
-inline void omp_trav_for_each(const T& trav, const F& f)
-{
-#pragma omp parallel for
-	for (auto trav_inner : trav)
-		trav_inner.for_each(f);
-}
-
-template <typename T, typename F>
-inline void omp_trav_for_each_no_parallel(const T& trav, const F& f)
-{
-#pragma omp for
-	for (auto trav_inner : trav)
-		trav_inner.for_each(f);
-}
-
 inline auto get_thread_num()
 {
 #ifdef _OPENMP
@@ -52,6 +37,29 @@ inline auto get_max_threads()
 #endif
 }
 
+// Pins the threads of a parallel region to their cpus of the execution context while the returned guard lives
+// The thread that opened the region gets its previous affinity back, the pooled workers stay pinned for later regions
+inline physicore::execution_context::scoped_pin pin_to_context(const physicore::execution_context* context)
+{
+	return { context, static_cast<physicore::index_t>(get_thread_num()), get_thread_num() == 0 };
+}
+
+template <typename T, typename F>
+inline void omp_trav_for_each(const T& trav, const F& f, int team_size = get_max_threads())
+{
+#pragma omp parallel for num_threads(team_size)
+	for (auto trav_inner : trav)
+		trav_inner.for_each(f);
+}
+
+template <typename T, typename F>
+inline void omp_trav_for_each_no_parallel(const T& trav, const F& f)
+{
+#pragma omp for
+	for (auto trav_inner : trav)
+		trav_inner.for_each(f);
+}
+
 template <typename numeric_t>
 std::pair<numeric_t, numeric_t> evened_work_distribution(numeric_t n, numeric_t workers, numeric_t work_id)
 {
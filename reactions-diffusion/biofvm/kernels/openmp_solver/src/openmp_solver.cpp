@@ -1,6 +1,10 @@
 #include "openmp_solver.h"
 
+#include <stdexcept>
+
 #include "dirichlet_solver.h"
+#include "omp_helper.h"
+#include "sampling_solver.h"
 
 using namespace physicore;
 using namespace physicore::biofvm::kernels::openmp_solver;
@@ -10,6 +14,10 @@ void openmp_solver::initialize(biofvm::microenvironment& m)
 	if (initialized)
 		return;
 
+	// the sweeps are tiled over the interleaved substrate-x rows
+	if (m.densities_layout != substrate_layout::interleaved)
+		throw std::runtime_error("The openmp solver supports only the interleaved substrate layout");
+
 	d_solver.prepare(m, 1);
 	d_solver.initialize();
 
@@ -24,21 +32,64 @@ void openmp_solver::solve(biofvm::microenvironment& m, index_t iterations)
 {
 	initialize(m);
 
-#pragma omp parallel
-	for (index_t it = 0; it < iterations; it++)
+	const execution_context* context = m.context.get();
+
+#pragma omp parallel num_threads(get_team_size(context))
 	{
-		d_solver.solve();
+		const auto pin = pin_to_context(context);
+
+		for (index_t it = 0; it < iterations; it++)
+			solve_iteration(m);
 
-		dirichlet_solver::solve(m, d_solver);
+		// only the gradients of the final densities are of interest
+		if (m.compute_gradients)
+			g_solver.compute_agent_gradients(m, d_solver);
+	}
 
-		b_solver.solve(m, d_solver);
+	recompute_cells = false;
+}
 
-		c_solver.simulate_secretion_and_uptake(m, d_solver, recompute_cells);
+void openmp_solver::solve_steps(biofvm::microenvironment& m, index_t iterations, const step_callback& on_step)
+{
+	initialize(m);
+
+	const execution_context* context = m.context.get();
+
+	// one team for all the steps; parallel regions opened by the callback run on the single calling thread
+#pragma omp parallel num_threads(get_team_size(context))
+	{
+		const auto pin = pin_to_context(context);
+
+		for (index_t it = 0; it < iterations; it++)
+		{
+			solve_iteration(m);
+
+			if (m.compute_gradients)
+				g_solver.compute_agent_gradients(m, d_solver);
+
+#pragma omp single
+			{
+				// the callback may move agents and request a recompute through recompute_positional_data
+				recompute_cells = false;
+				on_step(it);
+			}
+		}
 	}
 
 	recompute_cells = false;
 }
 
+void openmp_solver::solve_iteration(biofvm::microenvironment& m)
+{
+	d_solver.solve();
+
+	dirichlet_solver::solve(m, d_solver);
+
+	b_solver.solve(m, d_solver);
+
+	c_solver.simulate_secretion_and_uptake(m, d_solver, recompute_cells);
+}
+
 real_t openmp_solver::get_substrate_density(index_t s, index_t x, index_t y, index_t z) const
 {
 	auto dens_l = d_solver.get_substrates_layout<3>();
@@ -55,6 +106,33 @@ real_t& openmp_solver::get_substrate_density(index_t s, index_t x, index_t y, in
 	return dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(densities, s, x, y, z);
 }
 
+substrate_field_view openmp_solver::get_substrate_field_view() const
+{
+	const auto dens_l = d_solver.get_substrates_layout<3>();
+
+	const index_t ns = dens_l | noarr::get_length<'s'>();
+	const index_t nx = dens_l | noarr::get_length<'x'>();
+	const index_t ny = dens_l | noarr::get_length<'y'>();
+	const index_t nz = dens_l | noarr::get_length<'z'>();
+
+	// x rows are padded for alignment, so the y and z strides come from the diffusion solver
+	return { d_solver.get_substrates_pointer(), { ns, nx, ny, nz }, d_solver.get_substrates_strides() };
+}
+
+void openmp_solver::sample_substrate_densities(const microenvironment& m, std::span<const real_t> positions,
+											   std::span<real_t> output, interpolation mode)
+{
+	sampling_solver::sample(m, d_solver, positions, output, mode);
+}
+
+std::span<const real_t> openmp_solver::get_agent_gradients() const { return g_solver.get_agent_gradients(); }
+
+void openmp_solver::compute_gradient_field(const microenvironment& m, index_t s, index_t dim,
+										   std::span<real_t> output)
+{
+	gradient_solver::compute_gradient_field(m, d_solver, s, dim, output);
+}
+
 void openmp_solver::reinitialize_dirichlet([[maybe_unused]] microenvironment& m)
 {
 	// OpenMP solver doesn't need to reinitialize Dirichlet conditions
@@ -5,6 +5,7 @@
 #include "bulk_solver.h"
 #include "cell_solver.h"
 #include "diffusion_solver.h"
+#include "gradient_solver.h"
 
 namespace physicore::biofvm::kernels::openmp_solver {
 
@@ -16,12 +17,23 @@ class openmp_solver : public solver
 	bulk_solver b_solver;
 	cell_solver c_solver;
 	diffusion_solver d_solver;
+	gradient_solver g_solver;
+
+	// Must be called by the whole team of a parallel region
+	void solve_iteration(microenvironment& m);
 
 public:
 	void initialize(microenvironment& m) override;
 	void solve(microenvironment& m, index_t iterations) override;
+	void solve_steps(microenvironment& m, index_t iterations, const step_callback& on_step) override;
 	real_t get_substrate_density(index_t s, index_t x, index_t y, index_t z) const override;
 	real_t& get_substrate_density(index_t s, index_t x, index_t y, index_t z) override;
+	substrate_field_view get_substrate_field_view() const override;
+	void sample_substrate_densities(const microenvironment& m, std::span<const real_t> positions,
+									std::span<real_t> output, interpolation mode) override;
+	std::span<const real_t> get_agent_gradients() const override;
+	void compute_gradient_field(const microenvironment& m, index_t s, index_t dim,
+								std::span<real_t> output) override;
 	void reinitialize_dirichlet(microenvironment& m) override;
 	void recompute_positional_data(microenvironment& m) override;
 };
@@ -0,0 +1,118 @@
+#include "sampling_solver.h"
+
+#include <algorithm>
+#include <array>
+
+#include <noarr/structures_extended.hpp>
+
+#include "omp_helper.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+using namespace physicore::biofvm::kernels::openmp_solver;
+
+namespace {
+struct axis_sample
+{
+	index_t lower;
+	index_t upper;
+	real_t weight; // weight of the upper voxel
+};
+
+axis_sample sample_axis(real_t position, sindex_t mesh_min, index_t voxel_size, index_t grid_size,
+						interpolation mode)
+{
+	const real_t t = (position - (real_t)mesh_min) / (real_t)voxel_size;
+
+	if (mode == interpolation::nearest)
+	{
+		const index_t voxel = t <= 0 ? 0 : std::min((index_t)t, grid_size - 1);
+		return { voxel, voxel, 0 };
+	}
+
+	const real_t c = t - (real_t)0.5;
+
+	if (c <= 0)
+		return { 0, 0, 0 };
+
+	const auto lower = (index_t)c;
+
+	if (lower >= grid_size - 1)
+		return { grid_size - 1, grid_size - 1, 0 };
+
+	return { lower, lower + 1, c - (real_t)lower };
+}
+
+template <index_t dims>
+void sample_dim(const auto dens_l, const real_t* HWY_RESTRICT substrates, const cartesian_mesh& mesh,
+				const real_t* HWY_RESTRICT positions, real_t* HWY_RESTRICT output, index_t n, interpolation mode,
+				int team_size)
+{
+	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+
+#pragma omp parallel for num_threads(team_size)
+	for (index_t i = 0; i < n; i++)
+	{
+		std::array<axis_sample, 3> axes = { axis_sample { 0, 0, 0 }, axis_sample { 0, 0, 0 },
+											axis_sample { 0, 0, 0 } };
+
+		for (index_t d = 0; d < dims; d++)
+			axes[d] = sample_axis(positions[i * dims + d], mesh.bounding_box_mins[d], mesh.voxel_shape[d],
+								  mesh.grid_shape[d], mode);
+
+		real_t* HWY_RESTRICT out = output + i * substrates_count;
+
+		std::fill_n(out, substrates_count, 0);
+
+		for (index_t corner = 0; corner < (index_t(1) << dims); corner++)
+		{
+			std::array<index_t, 3> voxel = { 0, 0, 0 };
+			real_t weight = 1;
+
+			for (index_t d = 0; d < dims; d++)
+			{
+				const bool upper = (corner >> d) & 1;
+				voxel[d] = upper ? axes[d].upper : axes[d].lower;
+				weight *= upper ? axes[d].weight : 1 - axes[d].weight;
+			}
+
+			// nearest sampling and clamped dimensions give zero weight to all upper corners
+			if (weight == 0)
+				continue;
+
+			const real_t* HWY_RESTRICT densities =
+				&((dens_l ^ noarr::fix<'x'>(voxel[0]) ^ noarr::fix<'y'>(voxel[1]) ^ noarr::fix<'z'>(voxel[2]))
+				  | noarr::get_at<'s'>(substrates, 0));
+
+			for (index_t s = 0; s < substrates_count; s++)
+				out[s] += weight * densities[s];
+		}
+	}
+}
+} // namespace
+
+void sampling_solver::sample(const microenvironment& m, const diffusion_solver& d_solver,
+							 std::span<const real_t> positions, std::span<real_t> output, interpolation mode)
+{
+	const index_t n = positions.size() / m.mesh.dims;
+	const int team_size = get_team_size(m.context.get());
+
+	switch (m.mesh.dims)
+	{
+		case 1:
+			sample_dim<1>(d_solver.get_substrates_layout<1>(), d_solver.get_substrates_pointer(), m.mesh,
+						  positions.data(), output.data(), n, mode, team_size);
+			return;
+		case 2:
+			sample_dim<2>(d_solver.get_substrates_layout<2>(), d_solver.get_substrates_pointer(), m.mesh,
+						  positions.data(), output.data(), n, mode, team_size);
+			return;
+		case 3:
+			sample_dim<3>(d_solver.get_substrates_layout<3>(), d_solver.get_substrates_pointer(), m.mesh,
+						  positions.data(), output.data(), n, mode, team_size);
+			return;
+		default:
+			assert(false);
+			return;
+	}
+}
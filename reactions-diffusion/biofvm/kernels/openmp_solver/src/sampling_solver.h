@@ -0,0 +1,33 @@
+#pragma once
+
+#include <span>
+
+#include <biofvm/microenvironment.h>
+
+#include "diffusion_solver.h"
+
+/*
+Samples substrate densities at arbitrary positions.
+
+For each position p and each dimension d, the position is converted to voxel coordinates:
+t_d = (p_d - min_d) / dx_d
+
+Nearest: D(p) = D[floor(t)] (clamped to the grid)
+
+Trilinear: the voxel centers are at t = i + 0.5, so with c_d = t_d - 0.5, l_d = floor(c_d) and w_d = c_d - l_d:
+D(p) = sum_{corners} prod_d (w_d if upper corner in d else 1 - w_d) * D[corner]
+Positions closer to the domain boundary than half a voxel are clamped to the boundary voxel centers.
+
+The voxel substrates are contiguous in the diffusion layout, so all substrates of a point are accumulated at once.
+*/
+
+namespace physicore::biofvm::kernels::openmp_solver {
+
+class sampling_solver
+{
+public:
+	static void sample(const microenvironment& m, const diffusion_solver& d_solver, std::span<const real_t> positions,
+					   std::span<real_t> output, interpolation mode);
+};
+
+} // namespace physicore::biofvm::kernels::openmp_solver
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
 #include <biofvm/agent_data.h>
 #include <biofvm/microenvironment.h>
 #include <common/generic_agent_solver.h>
@@ -6,6 +10,7 @@
 
 #include "cell_solver.h"
 #include "diffusion_solver.h"
+#include "omp_helper.h"
 
 using namespace physicore;
 using namespace physicore::biofvm;
@@ -761,3 +766,233 @@ TEST(CellSolverTest, InactiveAgentReactivation)
 	EXPECT_NEAR((densities.at<'x', 's'>(0, 0)), 47.636364, 1e-4);
 	EXPECT_NEAR((densities.at<'x', 's'>(0, 1)), 1.001, 1e-6);
 }
+
+TEST(CellSolverTest, InactiveAgentWithoutRecompute)
+{
+	// Writing is_active alone has to rebuild the active agents list on the next step
+	const bool compute_internalized = true;
+
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 40, 20, 20 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh, compute_internalized);
+
+	auto* agent = m->agents->create();
+	set_default_agent_values(agent, 0, 1000, { 10, 0, 0 }, 1);
+
+	diffusion_solver d_s;
+	cell_solver s;
+
+	d_s.prepare(*m, 1);
+	d_s.initialize();
+	s.initialize(*m);
+
+	auto dens_l = d_s.get_substrates_layout<1>();
+	auto densities = noarr::make_bag(dens_l, d_s.get_substrates_pointer());
+
+	agent->is_active() = 1;
+
+#pragma omp parallel
+	s.simulate_secretion_and_uptake(*m, d_s, true);
+
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 0)), 28, 1e-6);
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 1)), 1.0005, 1e-6);
+
+	agent->is_active() = 0;
+
+#pragma omp parallel
+	s.simulate_secretion_and_uptake(*m, d_s, false);
+
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 0)), 28, 1e-6);
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 1)), 1.0005, 1e-6);
+
+	agent->is_active() = 1;
+
+#pragma omp parallel
+	s.simulate_secretion_and_uptake(*m, d_s, false);
+
+	EXPECT_NEAR((densities.at<'x', 's'>(0, 0)), 47.636364, 1e-4);
+	EXPECT_NEAR((densities.at<'x', 's'>(0, 1)), 1.001, 1e-6);
+}
+
+namespace {
+// Busy times of one recomputing step of agents_count agents spread over the voxels, and the wall time of the step
+std::vector<double> measure_busy_times(index_t agents_count, double& wall_time)
+{
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 60, 20, 20 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh, true);
+
+	m->agents->create_n(agents_count);
+	for (index_t i = 0; i < agents_count; i++)
+		set_default_agent_values(m->agents->get_agent_at(i), 0, 1000, { static_cast<real_t>(i % 60), 0, 0 }, 1);
+
+	diffusion_solver d_s;
+	cell_solver s;
+
+	d_s.prepare(*m, 1);
+	d_s.initialize();
+	s.initialize(*m);
+
+	const auto start = std::chrono::steady_clock::now();
+
+#pragma omp parallel
+	s.simulate_secretion_and_uptake(*m, d_s, true);
+
+	wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	auto busy_times = s.get_thread_busy_times();
+	return std::vector<double>(busy_times.begin(), busy_times.end());
+}
+} // namespace
+
+TEST(CellSolverTest, ThreadBusyTimesReported)
+{
+	std::size_t team_size = 0;
+
+#pragma omp parallel
+#pragma omp single
+	team_size = get_num_threads();
+
+	double small_wall_time = 0;
+	double large_wall_time = 0;
+	const auto small = measure_busy_times(1000, small_wall_time);
+	const auto large = measure_busy_times(200000, large_wall_time);
+
+	ASSERT_EQ(small.size(), team_size);
+	ASSERT_EQ(large.size(), team_size);
+
+	// a thread is busy only within the step and at least one of them processed the agents
+	for (auto busy_time : large)
+	{
+		EXPECT_GE(busy_time, 0);
+		EXPECT_LE(busy_time, large_wall_time);
+	}
+	EXPECT_GT(*std::max_element(large.begin(), large.end()), 0);
+
+	// the total busy time tracks the amount of work, not the number of threads
+	const double small_total = std::accumulate(small.begin(), small.end(), 0.0);
+	const double large_total = std::accumulate(large.begin(), large.end(), 0.0);
+	EXPECT_GT(large_total, small_total);
+}
+
+TEST(CellSolverTest, BatchedReleaseAndRemove)
+{
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 60, 20, 20 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh, true);
+
+	// agents 0 and 1 share voxel 0, agent 2 is in voxel 1 and agent 3 in voxel 2
+	const std::array<real_t, 4> positions = { 5, 15, 30, 50 };
+	std::vector<agent_interface*> agents;
+
+	for (index_t i = 0; i < positions.size(); i++)
+	{
+		auto* a = m->agents->create();
+		set_default_agent_values(a, 0, 1000, { positions[i], 0, 0 }, 1);
+
+		a->internalized_substrates()[0] = static_cast<real_t>(1000 * (i + 1));
+		a->internalized_substrates()[1] = static_cast<real_t>(2000 * (i + 1));
+		a->fraction_released_at_death()[0] = 0.5;
+
+		agents.push_back(a);
+	}
+
+	diffusion_solver d_s;
+	cell_solver s;
+
+	d_s.prepare(*m, 1);
+	d_s.initialize();
+	s.initialize(*m);
+
+	auto dens_l = d_s.get_substrates_layout<1>();
+	auto densities = noarr::make_bag(dens_l, d_s.get_substrates_pointer());
+
+	const real_t voxel_volume = (real_t)mesh.voxel_volume();
+
+	const std::array<index_t, 3> dying = { 3, 0, 1 };
+
+#pragma omp parallel
+	s.release_internalized_substrates(*m, d_s, dying, true);
+
+	EXPECT_DOUBLE_EQ((densities.at<'x', 's'>(0, 0)), 1 + (1000 + 2000) * 0.5 / voxel_volume);
+	EXPECT_DOUBLE_EQ((densities.at<'x', 's'>(0, 1)), 1 + (2000 + 4000) / voxel_volume);
+
+	EXPECT_DOUBLE_EQ((densities.at<'x', 's'>(1, 0)), 1);
+	EXPECT_DOUBLE_EQ((densities.at<'x', 's'>(1, 1)), 1);
+
+	EXPECT_DOUBLE_EQ((densities.at<'x', 's'>(2, 0)), 1 + 4000 * 0.5 / voxel_volume);
+	EXPECT_DOUBLE_EQ((densities.at<'x', 's'>(2, 1)), 1 + 8000 / voxel_volume);
+
+	ASSERT_EQ(m->agents->size(), 1U);
+
+	auto* survivor = m->agents->get_agent_at(0);
+	EXPECT_EQ(survivor, agents[2]);
+	EXPECT_DOUBLE_EQ(survivor->internalized_substrates()[0], 3000);
+	EXPECT_DOUBLE_EQ(survivor->internalized_substrates()[1], 6000);
+}
+
+TEST_P(RecomputeTest, SparseInteractions)
+{
+	const bool compute_internalized = std::get<0>(GetParam());
+	const bool recompute = std::get<1>(GetParam());
+
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 60, 20, 20 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh, compute_internalized);
+	m->sparse_agent_interactions = true;
+
+	std::vector<agent_interface*> agents;
+
+	agents.reserve(4);
+	for (int i = 0; i < 4; i++)
+		agents.push_back(m->agents->create());
+
+	set_default_agent_values(agents[0], 0, 500, { 10, 0, 0 }, 1);
+	set_default_agent_values(agents[1], 600, 1000, { 30, 0, 0 }, 1);
+	set_default_agent_values(agents[2], 1100, 1500, { 30, 0, 0 }, 1);
+	set_default_agent_values(agents[3], 1600, 2000, { 50, 0, 0 }, 1);
+
+	// agent 0 does not touch substrate 1 at all, agent 2 only substrate 1 while sharing its voxel with agent 1
+	agents[0]->net_export_rates()[1] = 0;
+	agents[2]->secretion_rates()[0] = 0;
+	agents[2]->uptake_rates()[0] = 0;
+
+	diffusion_solver d_s;
+	cell_solver s;
+
+	d_s.prepare(*m, 1);
+	d_s.initialize();
+	s.initialize(*m);
+
+	auto dens_l = d_s.get_substrates_layout<1>();
+	auto densities = noarr::make_bag(dens_l, d_s.get_substrates_pointer());
+
+	auto& agent_data = agent_retriever().retrieve_agent_data(*m->agents);
+
+	std::vector<real_t> expected_internalized(agent_data.base_data.agents_count * m->substrates_count, 0);
+
+	for (bool recompute_step : { true, recompute })
+	{
+		auto expected_densities = compute_expected_agent_densities_1d(densities, *m, agent_data);
+
+#pragma omp parallel
+		s.simulate_secretion_and_uptake(*m, d_s, recompute_step);
+
+		compute_expected_agent_internalized_1d(densities, *m, agent_data, expected_internalized);
+
+		if (compute_internalized)
+		{
+			for (std::size_t i = 0; i < agents.size(); i++)
+			{
+				EXPECT_NEAR(agents[i]->internalized_substrates()[0], expected_internalized[2 * i], 1e-6);
+				EXPECT_NEAR(agents[i]->internalized_substrates()[1], expected_internalized[2 * i + 1], 1e-6);
+			}
+		}
+
+		for (index_t x = 0; x < m->mesh.grid_shape[0]; x++)
+		{
+			EXPECT_NEAR((densities.at<'x', 's'>(x, 0)), expected_densities[2 * x], 1e-6);
+			EXPECT_NEAR((densities.at<'x', 's'>(x, 1)), expected_densities[2 * x + 1], 1e-6);
+		}
+	}
+}
@@ -263,3 +263,32 @@ TEST(DiffusionSolverTest, Random3D)
 								1e-6);
 				}
 }
+
+TEST(DiffusionSolverTest, SubstratesStrides)
+{
+	// 2 substrates x 5 voxels do not fill whole aligned rows, so x rows are padded
+	const cartesian_mesh mesh(3, { 0, 0, 0 }, { 100, 40, 60 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+
+	diffusion_solver solver;
+
+	solver.prepare(*m, 1);
+	solver.initialize();
+
+	auto dens_l = solver.get_substrates_layout<3>();
+	real_t* densities = solver.get_substrates_pointer();
+	const auto strides = solver.get_substrates_strides();
+
+	for (index_t z = 0; z < 3; z++)
+		for (index_t y = 0; y < 2; y++)
+			for (index_t x = 0; x < 5; x++)
+				for (index_t s = 0; s < 2; s++)
+				{
+					const real_t* expected = &(dens_l | noarr::get_at<'x', 'y', 'z', 's'>(densities, x, y, z, s));
+					EXPECT_EQ(densities + s * strides[0] + x * strides[1] + y * strides[2] + z * strides[3],
+							  expected);
+				}
+
+	EXPECT_GE(strides[2], 5 * strides[1]);
+}
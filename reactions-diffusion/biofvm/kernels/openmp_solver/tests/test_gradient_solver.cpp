@@ -0,0 +1,159 @@
+#include <biofvm/microenvironment.h>
+#include <gtest/gtest.h>
+#include <noarr/structures/interop/bag.hpp>
+
+#include "diffusion_solver.h"
+#include "gradient_solver.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+using namespace physicore::biofvm::kernels::openmp_solver;
+
+namespace {
+std::unique_ptr<microenvironment> default_microenv(cartesian_mesh mesh)
+{
+	const real_t timestep = 0.01;
+	const index_t substrates_count = 2;
+
+	auto diff_coefs = std::make_unique<real_t[]>(2);
+	diff_coefs[0] = 4;
+	diff_coefs[1] = 2;
+	auto decay_rates = std::make_unique<real_t[]>(2);
+	decay_rates[0] = 5;
+	decay_rates[1] = 3;
+
+	auto initial_conds = std::make_unique<real_t[]>(2);
+	initial_conds[0] = 0;
+	initial_conds[1] = 0;
+
+	auto m = std::make_unique<microenvironment>(mesh, substrates_count, timestep);
+	m->diffusion_coefficients = std::move(diff_coefs);
+	m->decay_rates = std::move(decay_rates);
+	m->initial_conditions = std::move(initial_conds);
+
+	return m;
+}
+
+// D(s, x, y, z) = x + 10y^2 + 1000s, quadratic in y to tell central and one-sided differences apart
+void fill_densities(const microenvironment& m, diffusion_solver& d_s)
+{
+	auto densities = noarr::make_bag(d_s.get_substrates_layout<3>(), d_s.get_substrates_pointer());
+
+	for (index_t z = 0; z < m.mesh.grid_shape[2]; z++)
+		for (index_t y = 0; y < m.mesh.grid_shape[1]; y++)
+			for (index_t x = 0; x < m.mesh.grid_shape[0]; x++)
+				for (index_t s = 0; s < m.substrates_count; s++)
+					densities.template at<'s', 'x', 'y', 'z'>(s, x, y, z) =
+						static_cast<real_t>(x + 10 * y * y + 1000 * s);
+}
+
+void create_agent(microenvironment& m, real_t x, real_t y)
+{
+	auto* a = m.agents->create();
+	a->position()[0] = x;
+	a->position()[1] = y;
+}
+} // namespace
+
+TEST(GradientSolverTest, Simple2D)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 60, 0 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+
+	diffusion_solver d_s;
+	d_s.prepare(*m, 1);
+	d_s.initialize();
+
+	fill_densities(*m, d_s);
+
+	// interior voxel (1, 1), lower boundary voxel (0, 0), upper boundary voxel (2, 2) and an inactive agent
+	create_agent(*m, 30, 30);
+	create_agent(*m, 5, 5);
+	create_agent(*m, 60, 60);
+	create_agent(*m, 30, 30);
+	m->agents->get_agent_at(3)->is_active() = 0;
+
+	gradient_solver g_s;
+
+#pragma omp parallel
+	g_s.compute_agent_gradients(*m, d_s);
+
+	const auto gradients = g_s.get_agent_gradients();
+
+	ASSERT_EQ(gradients.size(), 4 * m->substrates_count * 2);
+
+	for (index_t s = 0; s < m->substrates_count; s++)
+	{
+		// d/dx is 1 per voxel everywhere
+		EXPECT_DOUBLE_EQ(gradients[(0 * 2 + s) * 2 + 0], 1. / 20);
+		EXPECT_DOUBLE_EQ(gradients[(1 * 2 + s) * 2 + 0], 1. / 20);
+		EXPECT_DOUBLE_EQ(gradients[(2 * 2 + s) * 2 + 0], 1. / 20);
+
+		// central (40 - 0) / 40, one-sided (10 - 0) / 20 and (40 - 10) / 20
+		EXPECT_DOUBLE_EQ(gradients[(0 * 2 + s) * 2 + 1], 1);
+		EXPECT_DOUBLE_EQ(gradients[(1 * 2 + s) * 2 + 1], 0.5);
+		EXPECT_DOUBLE_EQ(gradients[(2 * 2 + s) * 2 + 1], 1.5);
+
+		EXPECT_DOUBLE_EQ(gradients[(3 * 2 + s) * 2 + 0], 0);
+		EXPECT_DOUBLE_EQ(gradients[(3 * 2 + s) * 2 + 1], 0);
+	}
+}
+
+TEST(GradientSolverTest, SingleVoxelDimension)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 20, 0 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+
+	diffusion_solver d_s;
+	d_s.prepare(*m, 1);
+	d_s.initialize();
+
+	fill_densities(*m, d_s);
+
+	create_agent(*m, 30, 10);
+
+	gradient_solver g_s;
+
+#pragma omp parallel
+	g_s.compute_agent_gradients(*m, d_s);
+
+	const auto gradients = g_s.get_agent_gradients();
+
+	for (index_t s = 0; s < m->substrates_count; s++)
+	{
+		EXPECT_DOUBLE_EQ(gradients[s * 2 + 0], 1. / 20);
+		EXPECT_DOUBLE_EQ(gradients[s * 2 + 1], 0);
+	}
+}
+
+TEST(GradientSolverTest, Field2D)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 60, 0 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+
+	diffusion_solver d_s;
+	d_s.prepare(*m, 1);
+	d_s.initialize();
+
+	fill_densities(*m, d_s);
+
+	std::vector<real_t> field_x(mesh.voxel_count());
+	std::vector<real_t> field_y(mesh.voxel_count());
+
+	gradient_solver::compute_gradient_field(*m, d_s, 1, 0, field_x);
+	gradient_solver::compute_gradient_field(*m, d_s, 1, 1, field_y);
+
+	// one-sided, central and one-sided differences of 10y^2 along y
+	const std::array<real_t, 3> expected_y = { 0.5, 1, 1.5 };
+
+	for (index_t y = 0; y < 3; y++)
+		for (index_t x = 0; x < 3; x++)
+		{
+			EXPECT_DOUBLE_EQ(field_x[y * 3 + x], 1. / 20);
+			EXPECT_DOUBLE_EQ(field_y[y * 3 + x], expected_y[y]);
+		}
+}
@@ -0,0 +1,73 @@
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <biofvm/microenvironment.h>
+#include <common/execution_context.h>
+#include <gtest/gtest.h>
+
+#include "openmp_solver.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+using namespace physicore::biofvm::kernels::openmp_solver;
+
+namespace {
+std::unique_ptr<microenvironment> default_microenv(cartesian_mesh mesh)
+{
+	const real_t timestep = 5;
+	const index_t substrates_count = 1;
+
+	auto diff_coefs = std::make_unique<real_t[]>(1);
+	diff_coefs[0] = 4;
+	auto decay_rates = std::make_unique<real_t[]>(1);
+	decay_rates[0] = 5;
+
+	auto initial_conds = std::make_unique<real_t[]>(1);
+	initial_conds[0] = 1;
+
+	auto m = std::make_unique<microenvironment>(mesh, substrates_count, timestep);
+	m->diffusion_coefficients = std::move(diff_coefs);
+	m->decay_rates = std::move(decay_rates);
+	m->initial_conditions = std::move(initial_conds);
+
+	return m;
+}
+} // namespace
+
+TEST(OpenmpSolverTest, PlanarLayoutIsRejected)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 200, 200, 0 }, { 20, 20, 0 });
+
+	auto m = default_microenv(mesh);
+	m->densities_layout = substrate_layout::planar;
+
+	openmp_solver solver;
+	EXPECT_THROW(solver.initialize(*m), std::runtime_error);
+}
+
+#ifdef __linux__
+TEST(OpenmpSolverTest, CallerAffinityIsRestored)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 200, 200, 0 }, { 20, 20, 0 });
+
+	auto m = default_microenv(mesh);
+	m->context = std::make_shared<execution_context>(2, std::vector<unsigned> { 0 });
+
+	cpu_set_t before;
+	CPU_ZERO(&before);
+	ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(before), &before), 0);
+
+	openmp_solver solver;
+	solver.initialize(*m);
+	solver.solve(*m, 2);
+	solver.solve_steps(*m, 2, [](index_t) {});
+
+	cpu_set_t after;
+	CPU_ZERO(&after);
+	ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(after), &after), 0);
+
+	EXPECT_TRUE(CPU_EQUAL(&before, &after));
+}
+#endif
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <iostream>
+#include <string_view>
 
 #include <biofvm/microenvironment.h>
 
@@ -20,12 +21,16 @@ void make_agents(microenvironment& m, index_t count, bool conflict)
 	sindex_t y = 0;
 	sindex_t z = 0;
 
-	for (index_t i = 0; i < count; i++)
+	// agents are populated through proxies, so no per-agent handles are allocated
+	auto& agents = dynamic_cast<agent_container&>(*m.agents);
+	agents.reserve(count + (conflict ? 1 : 0));
+
+	for (index_t i : agents.create_n(count))
 	{
-		auto* a = m.agents->create();
-		a->position()[0] = static_cast<real_t>(x);
-		a->position()[1] = static_cast<real_t>(y);
-		a->position()[2] = static_cast<real_t>(z);
+		auto a = agents.make_proxy(i);
+		a.position()[0] = static_cast<real_t>(x);
+		a.position()[1] = static_cast<real_t>(y);
+		a.position()[2] = static_cast<real_t>(z);
 
 		x += 20;
 		if (x >= m.mesh.bounding_box_maxs[0])
@@ -42,10 +47,10 @@ void make_agents(microenvironment& m, index_t count, bool conflict)
 
 	if (conflict)
 	{
-		auto* a = m.agents->create();
-		a->position()[0] = 0;
-		a->position()[1] = 0;
-		a->position()[2] = 0;
+		auto a = agents.make_proxy(agents.create_n(1).front());
+		a.position()[0] = 0;
+		a.position()[1] = 0;
+		a.position()[2] = 0;
 	}
 }
 } // namespace
@@ -87,11 +92,16 @@ struct bench_functor : device_bulk_functor
  *
  * Timing is performed using std::chrono, and parallel execution is managed with OpenMP.
  *
+ * The substrate layout is chosen by the first argument, "interleaved" (default) or "planar";
+ * running the benchmark with each compares the layouts on the same workload.
+ *
  * This benchmark is intended to evaluate the performance of the solvers under
  * realistic simulation conditions.
  */
-int main()
+int main(int argc, char** argv)
 {
+	const bool planar = argc > 1 && std::string_view(argv[1]) == "planar";
+
 	const cartesian_mesh mesh(3, { 0, 0, 0 }, { 5000, 5000, 5000 }, { 20, 20, 20 });
 
 	const real_t diffusion_timestep = 0.01;
@@ -99,6 +109,9 @@ int main()
 
 	microenvironment m(mesh, substrates_count, diffusion_timestep);
 	m.compute_internalized_substrates = true;
+	m.densities_layout = planar ? substrate_layout::planar : substrate_layout::interleaved;
+
+	std::cout << "Substrate layout: " << (planar ? "planar" : "interleaved") << std::endl;
 
 	// --- diffusion parameters -------------------------------
 	m.initial_conditions = std::make_unique<real_t[]>(substrates_count);
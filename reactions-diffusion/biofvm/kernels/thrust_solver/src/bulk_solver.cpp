@@ -14,20 +14,24 @@ using namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE;
 namespace {
 template <typename density_layout_t>
 void solve_single(real_t* _CCCL_RESTRICT densities, real_t time_step, device_bulk_functor* func,
-				  const density_layout_t dens_l)
+				  const density_layout_t dens_l, bool planar)
 {
 	const std::size_t n = (std::size_t)(dens_l | noarr::get_length<'s'>()) * (dens_l | noarr::get_length<'x'>())
 						  * (dens_l | noarr::get_length<'y'>()) * (dens_l | noarr::get_length<'z'>());
 
 	thrust::for_each(thrust::device, thrust::make_counting_iterator<std::size_t>(0),
 					 thrust::make_counting_iterator<std::size_t>(n),
-					 [dens_l, densities, time_step, func] PHYSICORE_THRUST_DEVICE_FN(std::size_t i) {
+					 [dens_l, densities, time_step, func, planar] PHYSICORE_THRUST_DEVICE_FN(std::size_t i) {
 						 const index_t x_dim = dens_l | noarr::get_length<'x'>();
 						 const index_t y_dim = dens_l | noarr::get_length<'y'>();
+						 const index_t z_dim = dens_l | noarr::get_length<'z'>();
 						 const index_t s_dim = dens_l | noarr::get_length<'s'>();
 
-						 const index_t s = i % s_dim;
-						 i /= s_dim;
+						 // enumerate densities in memory order, substrates are outermost in the planar layout
+						 const std::size_t voxels = (std::size_t)x_dim * y_dim * z_dim;
+						 const index_t s = planar ? i / voxels : i % s_dim;
+						 i = planar ? i % voxels : i / s_dim;
+
 						 const index_t x = i % x_dim;
 						 i /= x_dim;
 						 const index_t y = i % y_dim;
@@ -52,8 +56,10 @@ void bulk_solver::initialize(thrust::device_ptr<device_bulk_functor> functor) {
 void bulk_solver::solve(const microenvironment& m, diffusion_solver& d_solver)
 {
 	if (func)
-		solve_single(d_solver.get_substrates_pointer().get(), m.diffusion_timestep, func.get(),
-					 d_solver.get_substrates_layout());
+		d_solver.visit_substrates_layout([&](auto dens_l) {
+			solve_single(d_solver.get_substrates_pointer().get(), m.diffusion_timestep, func.get(), dens_l,
+						 d_solver.get_layout() == substrate_layout::planar);
+		});
 }
 
 bulk_solver::~bulk_solver()
@@ -51,7 +51,7 @@ constexpr auto fix_dims(const real_t* cell_position, const sindex_t* bounding_bo
 
 template <index_t dims, typename ballot_layout_t>
 void clear_ballots(const ballot_layout_t ballot_l, const real_t* _CCCL_RESTRICT cell_positions,
-				   const uint8_t* _CCCL_RESTRICT is_active, index_t* _CCCL_RESTRICT ballots,
+				   const index_t* _CCCL_RESTRICT active_indices, index_t* _CCCL_RESTRICT ballots,
 				   real_t* _CCCL_RESTRICT reduced_numerators, real_t* _CCCL_RESTRICT reduced_denominators,
 				   real_t* _CCCL_RESTRICT reduced_factors, index_t n, const cartesian_mesh& m,
 				   index_t substrate_densities)
@@ -62,12 +62,9 @@ void clear_ballots(const ballot_layout_t ballot_l, const real_t* _CCCL_RESTRICT
 																  m.voxel_shape[2] };
 
 	thrust::for_each(
-		thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(n),
-		[ballot_l, cell_positions, is_active, ballots, reduced_numerators, reduced_denominators, reduced_factors,
+		thrust::device, active_indices, active_indices + n,
+		[ballot_l, cell_positions, ballots, reduced_numerators, reduced_denominators, reduced_factors,
 		 bounding_box_mins, voxel_shape, substrate_densities] PHYSICORE_THRUST_DEVICE_FN(index_t i) {
-			if (!is_active[i])
-				return;
-
 			auto b_l =
 				ballot_l ^ fix_dims<dims>(cell_positions + dims * i, bounding_box_mins.data(), voxel_shape.data());
 
@@ -88,31 +85,34 @@ void clear_ballots(const ballot_layout_t ballot_l, const real_t* _CCCL_RESTRICT
 }
 
 void compute_intermediates(real_t* _CCCL_RESTRICT numerators, real_t* _CCCL_RESTRICT denominators,
-						   real_t* _CCCL_RESTRICT factors, const real_t* _CCCL_RESTRICT secretion_rates,
-						   const real_t* _CCCL_RESTRICT uptake_rates, const real_t* _CCCL_RESTRICT saturation_densities,
-						   const real_t* _CCCL_RESTRICT net_export_rates, const real_t* _CCCL_RESTRICT cell_volumes,
-						   const uint8_t* _CCCL_RESTRICT is_active, real_t voxel_volume, real_t time_step, index_t n,
-						   index_t substrates_count)
+						   real_t* _CCCL_RESTRICT factors, const parameter_t* _CCCL_RESTRICT secretion_rates,
+						   const parameter_t* _CCCL_RESTRICT uptake_rates,
+						   const parameter_t* _CCCL_RESTRICT saturation_densities,
+						   const parameter_t* _CCCL_RESTRICT net_export_rates,
+						   const real_t* _CCCL_RESTRICT cell_volumes,
+						   const index_t* _CCCL_RESTRICT parameter_rows, const index_t* _CCCL_RESTRICT active_indices,
+						   real_t voxel_volume, real_t time_step, index_t n, index_t substrates_count)
 {
-	thrust::for_each(thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(n),
+	thrust::for_each(thrust::device, active_indices, active_indices + n,
 					 [numerators, denominators, factors, secretion_rates, uptake_rates, saturation_densities,
-					  net_export_rates, cell_volumes, is_active, voxel_volume, time_step,
+					  net_export_rates, cell_volumes, parameter_rows, voxel_volume, time_step,
 					  substrates_count] PHYSICORE_THRUST_DEVICE_FN(index_t i) {
-						 if (!is_active[i])
-							 return;
+						 const index_t p = parameter_rows ? parameter_rows[i] : i;
 
 						 for (index_t s = 0; s < substrates_count; s++)
 						 {
-							 numerators[i * substrates_count + s] = secretion_rates[i * substrates_count + s]
-																	* saturation_densities[i * substrates_count + s]
-																	* time_step * cell_volumes[i] / voxel_volume;
+							 // parameters are widened before any arithmetic when stored in reduced precision
+							 const real_t S = secretion_rates[p * substrates_count + s];
+							 const real_t U = uptake_rates[p * substrates_count + s];
+							 const real_t T = saturation_densities[p * substrates_count + s];
+							 const real_t N = net_export_rates[p * substrates_count + s];
+
+							 numerators[i * substrates_count + s] = S * T * time_step * cell_volumes[i] / voxel_volume;
 
 							 denominators[i * substrates_count + s] =
-								 (uptake_rates[i * substrates_count + s] + secretion_rates[i * substrates_count + s])
-								 * time_step * cell_volumes[i] / voxel_volume;
+								 (U + S) * time_step * cell_volumes[i] / voxel_volume;
 
-							 factors[i * substrates_count + s] =
-								 net_export_rates[i * substrates_count + s] * time_step / voxel_volume;
+							 factors[i * substrates_count + s] = N * time_step / voxel_volume;
 						 }
 					 });
 }
@@ -122,7 +122,7 @@ void ballot_and_sum(const ballot_layout_t ballot_l, real_t* _CCCL_RESTRICT reduc
 					real_t* _CCCL_RESTRICT reduced_denominators, real_t* _CCCL_RESTRICT reduced_factors,
 					const real_t* _CCCL_RESTRICT numerators, const real_t* _CCCL_RESTRICT denominators,
 					const real_t* _CCCL_RESTRICT factors, const real_t* _CCCL_RESTRICT cell_positions,
-					const uint8_t* _CCCL_RESTRICT is_active, index_t* _CCCL_RESTRICT ballots, index_t n,
+					const index_t* _CCCL_RESTRICT active_indices, index_t* _CCCL_RESTRICT ballots, index_t n,
 					index_t substrates_count, const cartesian_mesh& m, bool* _CCCL_RESTRICT is_conflict)
 {
 	const PHYSICORE_THRUST_STD::array<sindex_t, 3> bounding_box_mins = { m.bounding_box_mins[0], m.bounding_box_mins[1],
@@ -131,13 +131,10 @@ void ballot_and_sum(const ballot_layout_t ballot_l, real_t* _CCCL_RESTRICT reduc
 																  m.voxel_shape[2] };
 
 	thrust::for_each(
-		thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(n),
+		thrust::device, active_indices, active_indices + n,
 		[ballot_l, reduced_numerators, reduced_denominators, reduced_factors, numerators, denominators, factors,
-		 cell_positions, is_active, ballots, substrates_count, bounding_box_mins, voxel_shape,
+		 cell_positions, ballots, substrates_count, bounding_box_mins, voxel_shape,
 		 is_conflict] PHYSICORE_THRUST_DEVICE_FN(index_t i) {
-			if (!is_active[i])
-				return;
-
 			auto b_l =
 				ballot_l ^ fix_dims<dims>(cell_positions + dims * i, bounding_box_mins.data(), voxel_shape.data());
 
@@ -238,7 +235,7 @@ void compute_result(const density_layout_t dens_l, const ballot_layout_t ballot_
 					real_t* substrates, const real_t* reduced_numerators, const real_t* reduced_denominators,
 					const real_t* reduced_factors, const real_t* numerators, const real_t* denominators,
 					const real_t* factors, const index_t* ballots, const real_t* positions,
-					real_t* internalized_substrates, const uint8_t* is_active, const index_t agents_count,
+					real_t* internalized_substrates, const index_t* active_indices, const index_t active_count,
 					bool with_internalized, thrust::device_ptr<bool> is_conflict_ptr)
 {
 	auto voxel_volume = (real_t)mesh.voxel_volume(); // expecting that voxel volume is the same for all voxels
@@ -254,13 +251,9 @@ void compute_result(const density_layout_t dens_l, const ballot_layout_t ballot_
 	if (with_internalized && !is_conflict)
 	{
 		thrust::for_each(
-			thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(agents_count),
+			thrust::device, active_indices, active_indices + active_count,
 			[dens_l, internalized_substrates, positions, bounding_box_mins, voxel_shape, substrates, reduced_numerators,
-			 reduced_denominators, reduced_factors, is_active,
-			 voxel_volume] PHYSICORE_THRUST_DEVICE_FN(index_t i) mutable {
-				if (!is_active[i])
-					return;
-
+			 reduced_denominators, reduced_factors, voxel_volume] PHYSICORE_THRUST_DEVICE_FN(index_t i) mutable {
 				const index_t substrates_count = dens_l | noarr::get_length<'s'>();
 				auto fixed_dims = fix_dims<dims>(positions + i * dims, bounding_box_mins.data(), voxel_shape.data());
 
@@ -273,12 +266,9 @@ void compute_result(const density_layout_t dens_l, const ballot_layout_t ballot_
 	}
 
 	thrust::for_each(
-		thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(agents_count),
+		thrust::device, active_indices, active_indices + active_count,
 		[dens_l, ballot_l, bounding_box_mins, voxel_shape, substrates, reduced_numerators, reduced_denominators,
-		 reduced_factors, positions, ballots, is_active] PHYSICORE_THRUST_DEVICE_FN(index_t i) {
-			if (!is_active[i])
-				return;
-
+		 reduced_factors, positions, ballots] PHYSICORE_THRUST_DEVICE_FN(index_t i) {
 			const index_t substrates_count = dens_l | noarr::get_length<'s'>();
 			auto fixed_dims = fix_dims<dims>(positions + i * dims, bounding_box_mins.data(), voxel_shape.data());
 
@@ -292,12 +282,9 @@ void compute_result(const density_layout_t dens_l, const ballot_layout_t ballot_
 	if (with_internalized)
 	{
 		thrust::for_each(
-			thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(agents_count),
+			thrust::device, active_indices, active_indices + active_count,
 			[dens_l, internalized_substrates, positions, bounding_box_mins, voxel_shape, substrates, numerators,
-			 denominators, factors, is_active, voxel_volume] PHYSICORE_THRUST_DEVICE_FN(index_t i) mutable {
-				if (!is_active[i])
-					return;
-
+			 denominators, factors, voxel_volume] PHYSICORE_THRUST_DEVICE_FN(index_t i) mutable {
 				const index_t substrates_count = dens_l | noarr::get_length<'s'>();
 				auto fixed_dims = fix_dims<dims>(positions + i * dims, bounding_box_mins.data(), voxel_shape.data());
 
@@ -315,31 +302,32 @@ void simulate(const auto dens_l, const auto ballot_l, data_manager& data, microe
 			  thrust::device_ptr<bool> is_conflict)
 {
 	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
-	const index_t agents_count = m.agents->size();
 
 	if (recompute)
 	{
 		compute_intermediates(numerators, denominators, factors, data.secretion_rates, data.uptake_rates,
-							  data.saturation_densities, data.net_export_rates, data.volumes, data.is_active,
-							  (real_t)m.mesh.voxel_volume(), m.diffusion_timestep, agents_count, substrates_count);
+							  data.saturation_densities, data.net_export_rates, data.volumes, data.parameter_rows,
+							  data.active_indices, (real_t)m.mesh.voxel_volume(), m.diffusion_timestep,
+							  data.active_count, substrates_count);
 
-		clear_ballots<dims>(ballot_l, data.positions, data.is_active, ballots, reduced_numerators, reduced_denominators,
-							reduced_factors, agents_count, m.mesh, substrates_count);
+		clear_ballots<dims>(ballot_l, data.positions, data.active_indices, ballots, reduced_numerators,
+							reduced_denominators, reduced_factors, data.active_count, m.mesh, substrates_count);
 
 		ballot_and_sum<dims>(ballot_l, reduced_numerators, reduced_denominators, reduced_factors, numerators,
-							 denominators, factors, data.positions, data.is_active, ballots, agents_count,
+							 denominators, factors, data.positions, data.active_indices, ballots, data.active_count,
 							 substrates_count, m.mesh, is_conflict.get());
 	}
 
 	compute_result<dims>(dens_l, ballot_l, m.mesh, substrates, reduced_numerators, reduced_denominators,
 						 reduced_factors, numerators, denominators, factors, ballots, data.positions,
-						 data.internalized_substrates, data.is_active, agents_count, with_internalized, is_conflict);
+						 data.internalized_substrates, data.active_indices, data.active_count, with_internalized,
+						 is_conflict);
 }
 
 template <typename density_layout_t>
 constexpr void release_internal(real_t* _CCCL_RESTRICT substrate_densities,
 								real_t* _CCCL_RESTRICT internalized_substrates,
-								const real_t* _CCCL_RESTRICT fraction_released_at_death, real_t voxel_volume,
+								const parameter_t* _CCCL_RESTRICT fraction_released_at_death, real_t voxel_volume,
 								density_layout_t dens_l)
 {
 	const index_t substrates_count = dens_l | noarr::get_length<'s'>();
@@ -369,11 +357,14 @@ void release_dim(const density_layout_t dens_l, data_manager& data, const cartes
 	thrust::for_each(
 		thrust::device, thrust::make_counting_iterator(index_begin), thrust::make_counting_iterator(index_end),
 		[substrates, internalized_substrates = data.internalized_substrates, substrates_count,
-		 fraction_released_at_death = data.fraction_released_at_death, voxel_volume, dens_l, positions = data.positions,
-		 bounding_box_mins, voxel_shape] PHYSICORE_THRUST_DEVICE_FN(index_t index) {
+		 fraction_released_at_death = data.fraction_released_at_death, parameter_rows = data.parameter_rows,
+		 voxel_volume, dens_l, positions = data.positions, bounding_box_mins,
+		 voxel_shape] PHYSICORE_THRUST_DEVICE_FN(index_t index) {
+			const index_t p = parameter_rows ? parameter_rows[index] : index;
+
 			release_internal(
 				substrates, internalized_substrates + index * substrates_count,
-				fraction_released_at_death + index * substrates_count, voxel_volume,
+				fraction_released_at_death + p * substrates_count, voxel_volume,
 				dens_l ^ fix_dims<dims>(positions + index * dims, bounding_box_mins.data(), voxel_shape.data()));
 		});
 }
@@ -384,6 +375,9 @@ void cell_solver::simulate_secretion_and_uptake(microenvironment& m, diffusion_s
 {
 	real_t* substrates = d_solver.get_substrates_pointer().get();
 
+	// agents activated or deactivated since the last call change the voxel sums as well
+	recompute = data.update_active_indices() || recompute;
+
 	if (recompute)
 	{
 		resize(m);
@@ -393,36 +387,39 @@ void cell_solver::simulate_secretion_and_uptake(microenvironment& m, diffusion_s
 	switch (m.mesh.dims)
 	{
 		case 1: {
-			const auto dens_l = d_solver.get_substrates_layout<1>();
 			const auto ballot_l = noarr::scalar<index_t>() ^ noarr::vectors<'x'>(m.mesh.grid_shape[0]);
 
-			simulate<1>(dens_l, ballot_l, data, m, substrates, reduced_numerators_.data().get(),
-						reduced_denominators_.data().get(), reduced_factors_.data().get(), numerators_.data().get(),
-						denominators_.data().get(), factors_.data().get(), ballots_.get(), recompute,
-						compute_internalized_substrates_, is_conflict_);
+			d_solver.visit_substrates_layout<1>([&](auto dens_l) {
+				simulate<1>(dens_l, ballot_l, data, m, substrates, reduced_numerators_.data().get(),
+							reduced_denominators_.data().get(), reduced_factors_.data().get(),
+							numerators_.data().get(), denominators_.data().get(), factors_.data().get(),
+							ballots_.get(), recompute, compute_internalized_substrates_, is_conflict_);
+			});
 			return;
 		}
 		case 2: {
-			const auto dens_l = d_solver.get_substrates_layout<2>();
 			const auto ballot_l =
 				noarr::scalar<index_t>() ^ noarr::vectors<'x', 'y'>(m.mesh.grid_shape[0], m.mesh.grid_shape[1]);
 
-			simulate<2>(dens_l, ballot_l, data, m, substrates, reduced_numerators_.data().get(),
-						reduced_denominators_.data().get(), reduced_factors_.data().get(), numerators_.data().get(),
-						denominators_.data().get(), factors_.data().get(), ballots_.get(), recompute,
-						compute_internalized_substrates_, is_conflict_);
+			d_solver.visit_substrates_layout<2>([&](auto dens_l) {
+				simulate<2>(dens_l, ballot_l, data, m, substrates, reduced_numerators_.data().get(),
+							reduced_denominators_.data().get(), reduced_factors_.data().get(),
+							numerators_.data().get(), denominators_.data().get(), factors_.data().get(),
+							ballots_.get(), recompute, compute_internalized_substrates_, is_conflict_);
+			});
 			return;
 		}
 		case 3: {
-			const auto dens_l = d_solver.get_substrates_layout<3>();
 			const auto ballot_l =
 				noarr::scalar<index_t>()
 				^ noarr::vectors<'x', 'y', 'z'>(m.mesh.grid_shape[0], m.mesh.grid_shape[1], m.mesh.grid_shape[2]);
 
-			simulate<3>(dens_l, ballot_l, data, m, substrates, reduced_numerators_.data().get(),
-						reduced_denominators_.data().get(), reduced_factors_.data().get(), numerators_.data().get(),
-						denominators_.data().get(), factors_.data().get(), ballots_.get(), recompute,
-						compute_internalized_substrates_, is_conflict_);
+			d_solver.visit_substrates_layout<3>([&](auto dens_l) {
+				simulate<3>(dens_l, ballot_l, data, m, substrates, reduced_numerators_.data().get(),
+							reduced_denominators_.data().get(), reduced_factors_.data().get(),
+							numerators_.data().get(), denominators_.data().get(), factors_.data().get(),
+							ballots_.get(), recompute, compute_internalized_substrates_, is_conflict_);
+			});
 			return;
 		}
 		default:
@@ -440,16 +437,22 @@ void cell_solver::release_internalized_substrates(const microenvironment& m, dif
 	switch (m.mesh.dims)
 	{
 		case 1:
-			release_dim<1>(d_solver.get_substrates_layout<1>(), data, m.mesh, d_solver.get_substrates_pointer().get(),
-						   agent_index, agent_index + 1);
+			d_solver.visit_substrates_layout<1>([&](auto dens_l) {
+				release_dim<1>(dens_l, data, m.mesh, d_solver.get_substrates_pointer().get(), agent_index,
+							   agent_index + 1);
+			});
 			return;
 		case 2:
-			release_dim<2>(d_solver.get_substrates_layout<2>(), data, m.mesh, d_solver.get_substrates_pointer().get(),
-						   agent_index, agent_index + 1);
+			d_solver.visit_substrates_layout<2>([&](auto dens_l) {
+				release_dim<2>(dens_l, data, m.mesh, d_solver.get_substrates_pointer().get(), agent_index,
+							   agent_index + 1);
+			});
 			return;
 		case 3:
-			release_dim<3>(d_solver.get_substrates_layout<3>(), data, m.mesh, d_solver.get_substrates_pointer().get(),
-						   agent_index, agent_index + 1);
+			d_solver.visit_substrates_layout<3>([&](auto dens_l) {
+				release_dim<3>(dens_l, data, m.mesh, d_solver.get_substrates_pointer().get(), agent_index,
+							   agent_index + 1);
+			});
 			return;
 		default:
 			assert(false);
@@ -466,16 +469,19 @@ void cell_solver::release_internalized_substrates(const microenvironment& m, dif
 	switch (m.mesh.dims)
 	{
 		case 1:
-			release_dim<1>(d_solver.get_substrates_layout<1>(), data, m.mesh, d_solver.get_substrates_pointer().get(),
-						   0, m.agents->size());
+			d_solver.visit_substrates_layout<1>([&](auto dens_l) {
+				release_dim<1>(dens_l, data, m.mesh, d_solver.get_substrates_pointer().get(), 0, m.agents->size());
+			});
 			return;
 		case 2:
-			release_dim<2>(d_solver.get_substrates_layout<2>(), data, m.mesh, d_solver.get_substrates_pointer().get(),
-						   0, m.agents->size());
+			d_solver.visit_substrates_layout<2>([&](auto dens_l) {
+				release_dim<2>(dens_l, data, m.mesh, d_solver.get_substrates_pointer().get(), 0, m.agents->size());
+			});
 			return;
 		case 3:
-			release_dim<3>(d_solver.get_substrates_layout<3>(), data, m.mesh, d_solver.get_substrates_pointer().get(),
-						   0, m.agents->size());
+			d_solver.visit_substrates_layout<3>([&](auto dens_l) {
+				release_dim<3>(dens_l, data, m.mesh, d_solver.get_substrates_pointer().get(), 0, m.agents->size());
+			});
 			return;
 		default:
 			assert(false);
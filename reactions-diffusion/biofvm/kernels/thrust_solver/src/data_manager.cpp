@@ -1,6 +1,8 @@
 #include "data_manager.h"
 
+#include <atomic>
 #include <memory>
+#include <utility>
 
 #include "diffusion_solver.h"
 #include "namespace_config.h"
@@ -62,6 +64,10 @@ void data_manager::transfer_to_device()
 {
 	auto& h_agent_data = retrieve_agent_data(*h_agent_container);
 
+	if (h_agent_data.active_indices_dirty.load(std::memory_order_relaxed))
+		active_indices_changed_ = true;
+	h_agent_data.refresh_active_indices();
+
 	d_positions = h_agent_data.base_data.positions;
 	d_secretion_rates = h_agent_data.secretion_rates;
 	d_saturation_densities = h_agent_data.saturation_densities;
@@ -72,6 +78,8 @@ void data_manager::transfer_to_device()
 	d_fraction_transferred_when_ingested = h_agent_data.fraction_transferred_when_ingested;
 	d_volumes = h_agent_data.volumes;
 	d_is_active = h_agent_data.is_active;
+	d_active_indices = h_agent_data.active_indices;
+	d_parameter_rows = h_agent_data.parameter_rows;
 
 	thrust::copy_n(h_substrate_densities.get(), densities_size_bytes / sizeof(real_t), d_substrate_densities);
 
@@ -87,15 +95,41 @@ void data_manager::transfer_to_device()
 		fraction_transferred_when_ingested = d_fraction_transferred_when_ingested.data().get();
 		volumes = d_volumes.data().get();
 		is_active = d_is_active.data().get();
+		active_indices = d_active_indices.data().get();
+		parameter_rows = h_agent_data.shared_parameters ? d_parameter_rows.data().get() : nullptr;
 	}
 
+	active_count = h_agent_data.active_indices.size();
+
 	residency = data_residency::DEVICE;
 }
+
+bool data_manager::update_active_indices() { return std::exchange(active_indices_changed_, false); }
+
+void data_manager::prepare_agents_reorder()
+{
+	// between transfer_to_device and transfer_to_host the device holds the current agent data
+	reordering_device_data_ = residency == data_residency::DEVICE;
+
+	if (reordering_device_data_)
+		transfer_to_host();
+}
+
+void data_manager::sync_reordered_agents()
+{
+	if (std::exchange(reordering_device_data_, false))
+		transfer_to_device();
+}
 #else
 void data_manager::transfer_to_host() { substrate_densities = d_substrate_densities.get(); }
 void data_manager::transfer_to_device()
 {
 	auto& h_agent_data = retrieve_agent_data(*h_agent_container);
+
+	if (h_agent_data.active_indices_dirty.load(std::memory_order_relaxed))
+		active_indices_changed_ = true;
+	h_agent_data.refresh_active_indices();
+
 	positions = h_agent_data.base_data.positions.data();
 	secretion_rates = h_agent_data.secretion_rates.data();
 	saturation_densities = h_agent_data.saturation_densities.data();
@@ -106,5 +140,29 @@ void data_manager::transfer_to_device()
 	fraction_transferred_when_ingested = h_agent_data.fraction_transferred_when_ingested.data();
 	volumes = h_agent_data.volumes.data();
 	is_active = h_agent_data.is_active.data();
+	active_indices = h_agent_data.active_indices.data();
+	active_count = h_agent_data.active_indices.size();
+	parameter_rows = h_agent_data.shared_parameters ? h_agent_data.parameter_rows.data() : nullptr;
 }
+
+bool data_manager::update_active_indices()
+{
+	auto& h_agent_data = retrieve_agent_data(*h_agent_container);
+
+	// agent kernels read is_active of the host
+	if (h_agent_data.active_indices_dirty.load(std::memory_order_relaxed))
+	{
+		h_agent_data.refresh_active_indices();
+		active_indices = h_agent_data.active_indices.data();
+		active_count = h_agent_data.active_indices.size();
+		active_indices_changed_ = true;
+	}
+
+	return std::exchange(active_indices_changed_, false);
+}
+
+void data_manager::prepare_agents_reorder() {}
+
+// the agents were reordered within the columns, the active agents list moved with them
+void data_manager::sync_reordered_agents() { transfer_to_device(); }
 #endif
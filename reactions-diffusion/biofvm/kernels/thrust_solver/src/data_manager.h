@@ -39,38 +39,62 @@ class data_manager : private generic_agent_solver<agent>
 	std::size_t densities_size_bytes;
 
 	thrust::device_vector<real_t> d_positions;
-	thrust::device_vector<real_t> d_secretion_rates;
-	thrust::device_vector<real_t> d_saturation_densities;
-	thrust::device_vector<real_t> d_uptake_rates;
-	thrust::device_vector<real_t> d_net_export_rates;
+	thrust::device_vector<parameter_t> d_secretion_rates;
+	thrust::device_vector<parameter_t> d_saturation_densities;
+	thrust::device_vector<parameter_t> d_uptake_rates;
+	thrust::device_vector<parameter_t> d_net_export_rates;
 	thrust::device_vector<real_t> d_internalized_substrates;
-	thrust::device_vector<real_t> d_fraction_released_at_death;
-	thrust::device_vector<real_t> d_fraction_transferred_when_ingested;
+	thrust::device_vector<parameter_t> d_fraction_released_at_death;
+	thrust::device_vector<parameter_t> d_fraction_transferred_when_ingested;
 	thrust::device_vector<real_t> d_volumes;
 	thrust::device_vector<uint8_t> d_is_active;
+	thrust::device_vector<index_t> d_active_indices;
+	thrust::device_vector<index_t> d_parameter_rows;
 	thrust::device_ptr<real_t> d_substrate_densities;
 
 	std::shared_ptr<agent_container_interface> h_agent_container;
 	std::unique_ptr<real_t[]> h_substrate_densities;
 
+	// the active agents list was rebuilt from a changed is_active, agent kernels have to recompute
+	bool active_indices_changed_ = false;
+
+	// the agent data was brought from the device to be reordered on the host, it has to be uploaded again
+	bool reordering_device_data_ = false;
+
 public:
 	void initialize(const microenvironment& m, diffusion_solver& d_solver);
 
 	void transfer_to_host();
 	void transfer_to_device();
 
+	// Returns whether the active agents changed since the last call, rebuilding their list first if needed
+	// With CUDA, agent data including is_active reaches the device only by transfer_to_device
+	bool update_active_indices();
+
+	// Brings the agent data to the host before the microenvironment reorders it there
+	void prepare_agents_reorder();
+	// Makes the agent kernels use the reordered host agent data, uploading it if it was brought from the device
+	void sync_reordered_agents();
+
 	real_t* substrate_densities = nullptr;
 
 	real_t* positions = nullptr;
-	real_t* secretion_rates = nullptr;
-	real_t* saturation_densities = nullptr;
-	real_t* uptake_rates = nullptr;
-	real_t* net_export_rates = nullptr;
+	parameter_t* secretion_rates = nullptr;
+	parameter_t* saturation_densities = nullptr;
+	parameter_t* uptake_rates = nullptr;
+	parameter_t* net_export_rates = nullptr;
 	real_t* internalized_substrates = nullptr;
-	real_t* fraction_released_at_death = nullptr;
-	real_t* fraction_transferred_when_ingested = nullptr;
+	parameter_t* fraction_released_at_death = nullptr;
+	parameter_t* fraction_transferred_when_ingested = nullptr;
 	real_t* volumes = nullptr;
 	uint8_t* is_active = nullptr;
+
+	// indices of the active agents as of the last transfer_to_device or refresh, agent kernels iterate only these
+	index_t* active_indices = nullptr;
+	index_t active_count = 0;
+
+	// row of each agent in the parameter columns, nullptr unless agent_data shares parameters by agent type
+	index_t* parameter_rows = nullptr;
 };
 
 
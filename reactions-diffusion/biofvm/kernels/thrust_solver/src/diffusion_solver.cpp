@@ -66,20 +66,31 @@ void diffusion_solver::initialize(microenvironment& m, index_t substrate_factor)
 	nx_ = m.mesh.grid_shape[0];
 	ny_ = m.mesh.grid_shape[1];
 	nz_ = m.mesh.grid_shape[2];
+	layout_ = m.densities_layout;
 
-	substrate_densities_ = thrust::device_new<real_t>((std::size_t)ns_ * nx_ * ny_ * nz_);
+	const std::size_t voxels = (std::size_t)nx_ * ny_ * nz_;
+
+	substrate_densities_ = thrust::device_new<real_t>(ns_ * voxels);
 
 	initial_conditions_ = thrust::device_new<real_t>(ns_);
 	thrust::copy(m.initial_conditions.get(), m.initial_conditions.get() + ns_, initial_conditions_);
 
-	thrust::for_each(
-		thrust::make_counting_iterator<std::size_t>(0),
-		thrust::make_counting_iterator((std::size_t)ns_ * nx_ * ny_ * nz_),
-		[ns = ns_, densities = substrate_densities_.get(),
-		 initial_conditions = initial_conditions_.get()] PHYSICORE_THRUST_DEVICE_FN(std::size_t voxel_idx) {
-			const index_t s = voxel_idx % ns;
-			densities[voxel_idx] = initial_conditions[s];
-		});
+	// substrate of a density is the innermost index of the interleaved layout and the outermost of the planar one
+	thrust::for_each(thrust::make_counting_iterator<std::size_t>(0), thrust::make_counting_iterator(ns_ * voxels),
+					 [ns = ns_, voxels, planar = layout_ == substrate_layout::planar,
+					  densities = substrate_densities_.get(),
+					  initial_conditions = initial_conditions_.get()] PHYSICORE_THRUST_DEVICE_FN(std::size_t i) {
+						 const index_t s = planar ? i / voxels : i % ns;
+						 densities[i] = initial_conditions[s];
+					 });
+}
+
+std::array<index_t, 4> diffusion_solver::get_substrates_strides() const
+{
+	if (layout_ == substrate_layout::planar)
+		return { nx_ * ny_ * nz_, 1, nx_, nx_ * ny_ };
+
+	return { 1, ns_, ns_ * nx_, ns_ * nx_ * ny_ };
 }
 
 void diffusion_solver::precompute_values(thrust::device_ptr<real_t>& db, thrust::device_ptr<real_t>& dc,
@@ -193,74 +204,97 @@ constexpr void solve_slice(real_t* _CCCL_RESTRICT densities, const real_t* _CCCL
 			* (diag_l | noarr::get_at<'i', 's'>(b, i, s));
 	}
 }
-} // namespace
 
-thrust::device_ptr<real_t> diffusion_solver::get_substrates_pointer() { return substrate_densities_; }
+// Splits a work item of a sweep along one dimension into the substrate and the indices a, b of the other two
+// dimensions (a varying faster), in the memory order of the layout
+constexpr void split_work_item(std::size_t i, bool planar, index_t s_len, index_t a_len, index_t b_len, index_t& s,
+							   index_t& a, index_t& b)
+{
+	if (planar)
+	{
+		a = i % a_len;
+		i /= a_len;
+		b = i % b_len;
+		s = i / b_len;
+	}
+	else
+	{
+		s = i % s_len;
+		i /= s_len;
+		a = i % a_len;
+		b = i / a_len;
+	}
+}
 
-void diffusion_solver::solve()
+template <typename density_layout_t>
+void solve_sweeps(const density_layout_t dens_l, bool planar, real_t* densities, const real_t* bx, const real_t* cx,
+				  const real_t* ex, const real_t* by, const real_t* cy, const real_t* ey, const real_t* bz,
+				  const real_t* cz, const real_t* ez)
 {
-	auto dens_l = get_substrates_layout();
+	const index_t s_len = dens_l | noarr::get_length<'s'>();
+	const index_t x_len = dens_l | noarr::get_length<'x'>();
+	const index_t y_len = dens_l | noarr::get_length<'y'>();
+	const index_t z_len = dens_l | noarr::get_length<'z'>();
 
-	const std::size_t x_work = (std::size_t)ns_ * ny_ * nz_;
+	const std::size_t x_work = (std::size_t)s_len * y_len * z_len;
 
 	// swipe x
-	thrust::for_each(
-		thrust::device, thrust::make_counting_iterator<std::size_t>(0), thrust::make_counting_iterator(x_work),
-		[dens_l, densities = substrate_densities_.get(), b = bx_.get(), c = cx_.get(),
-		 e = ex_.get()] PHYSICORE_THRUST_DEVICE_FN(std::size_t voxel_idx) {
-			const index_t s_len = dens_l | noarr::get_length<'s'>();
-			const index_t y_len = dens_l | noarr::get_length<'y'>();
-
-			const index_t s = voxel_idx % s_len;
-			voxel_idx /= s_len;
-			const index_t y = voxel_idx % y_len;
-			const index_t z = voxel_idx / y_len;
-
-			solve_slice<'x'>(densities, b, c, e, dens_l ^ noarr::fix<'y'>(y) ^ noarr::fix<'z'>(z), (sindex_t)s);
-		});
-
-	if (ny_ != 1)
+	thrust::for_each(thrust::device, thrust::make_counting_iterator<std::size_t>(0),
+					 thrust::make_counting_iterator(x_work),
+					 [dens_l, planar, s_len, y_len, z_len, densities, b = bx, c = cx,
+					  e = ex] PHYSICORE_THRUST_DEVICE_FN(std::size_t voxel_idx) {
+						 index_t s, y, z;
+						 split_work_item(voxel_idx, planar, s_len, y_len, z_len, s, y, z);
+
+						 solve_slice<'x'>(densities, b, c, e, dens_l ^ noarr::fix<'y'>(y) ^ noarr::fix<'z'>(z),
+										  (sindex_t)s);
+					 });
+
+	if (y_len != 1)
 	{
-		const std::size_t y_work = (std::size_t)ns_ * nx_ * nz_;
+		const std::size_t y_work = (std::size_t)s_len * x_len * z_len;
 
 		// swipe y
-		thrust::for_each(
-			thrust::device, thrust::make_counting_iterator<std::size_t>(0), thrust::make_counting_iterator(y_work),
-			[dens_l, densities = substrate_densities_.get(), b = by_.get(), c = cy_.get(),
-			 e = ey_.get()] PHYSICORE_THRUST_DEVICE_FN(std::size_t voxel_idx) {
-				const index_t s_len = dens_l | noarr::get_length<'s'>();
-				const index_t x_len = dens_l | noarr::get_length<'x'>();
-
-				const index_t s = voxel_idx % s_len;
-				voxel_idx /= s_len;
-				const index_t x = voxel_idx % x_len;
-				const index_t z = voxel_idx / x_len;
-
-				solve_slice<'y'>(densities, b, c, e, dens_l ^ noarr::fix<'x'>(x) ^ noarr::fix<'z'>(z), (sindex_t)s);
-			});
+		thrust::for_each(thrust::device, thrust::make_counting_iterator<std::size_t>(0),
+						 thrust::make_counting_iterator(y_work),
+						 [dens_l, planar, s_len, x_len, z_len, densities, b = by, c = cy,
+						  e = ey] PHYSICORE_THRUST_DEVICE_FN(std::size_t voxel_idx) {
+							 index_t s, x, z;
+							 split_work_item(voxel_idx, planar, s_len, x_len, z_len, s, x, z);
+
+							 solve_slice<'y'>(densities, b, c, e, dens_l ^ noarr::fix<'x'>(x) ^ noarr::fix<'z'>(z),
+											  (sindex_t)s);
+						 });
 	}
 
-	if (nz_ != 1)
+	if (z_len != 1)
 	{
-		const std::size_t z_work = (std::size_t)ns_ * nx_ * ny_;
-
-		// swipe y
-		thrust::for_each(
-			thrust::device, thrust::make_counting_iterator<std::size_t>(0), thrust::make_counting_iterator(z_work),
-			[dens_l, densities = substrate_densities_.get(), b = bz_.get(), c = cz_.get(),
-			 e = ez_.get()] PHYSICORE_THRUST_DEVICE_FN(std::size_t voxel_idx) {
-				const index_t s_len = dens_l | noarr::get_length<'s'>();
-				const index_t x_len = dens_l | noarr::get_length<'x'>();
-
-				const index_t s = voxel_idx % s_len;
-				voxel_idx /= s_len;
-				const index_t x = voxel_idx % x_len;
-				const index_t y = voxel_idx / x_len;
-
-				solve_slice<'z'>(densities, b, c, e, dens_l ^ noarr::fix<'x'>(x) ^ noarr::fix<'y'>(y), (sindex_t)s);
-			});
+		const std::size_t z_work = (std::size_t)s_len * x_len * y_len;
+
+		// swipe z
+		thrust::for_each(thrust::device, thrust::make_counting_iterator<std::size_t>(0),
+						 thrust::make_counting_iterator(z_work),
+						 [dens_l, planar, s_len, x_len, y_len, densities, b = bz, c = cz,
+						  e = ez] PHYSICORE_THRUST_DEVICE_FN(std::size_t voxel_idx) {
+							 index_t s, x, y;
+							 split_work_item(voxel_idx, planar, s_len, x_len, y_len, s, x, y);
+
+							 solve_slice<'z'>(densities, b, c, e, dens_l ^ noarr::fix<'x'>(x) ^ noarr::fix<'y'>(y),
+											  (sindex_t)s);
+						 });
 	}
 }
+} // namespace
+
+thrust::device_ptr<real_t> diffusion_solver::get_substrates_pointer() { return substrate_densities_; }
+
+void diffusion_solver::solve()
+{
+	visit_substrates_layout([&](auto dens_l) {
+		solve_sweeps(dens_l, layout_ == substrate_layout::planar, substrate_densities_.get(), bx_.get(), cx_.get(),
+					 ex_.get(), by_.get(), cy_.get(), ey_.get(), bz_.get(), cz_.get(), ez_.get());
+	});
+}
 
 void diffusion_solver::deinitialize()
 {
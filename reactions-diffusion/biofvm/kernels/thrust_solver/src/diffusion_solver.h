@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include <biofvm/microenvironment.h>
 #include <thrust/device_ptr.h>
 
@@ -28,6 +30,10 @@ d_i'  == d_i - e_i*d_(i-1)                                    1 <  i <= n
 The backpropagation (2n multiplication + n subtractions):
 d_n'' == d_n'/b_n'
 d_i'' == (d_i' - c_i*d_(i+1)'')*b_i'                          n >  i >= 1
+
+Densities are stored either interleaved (substrates innermost) or planar (one x-y-z grid per substrate), as selected
+by microenvironment::densities_layout. Kernels are templated on the noarr layout and instantiated for both; work items
+are enumerated in the memory order of the layout, so consecutive items touch adjacent densities in both.
 */
 
 namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE {
@@ -45,6 +51,8 @@ class diffusion_solver
 	index_t ny_ = 0;
 	index_t nz_ = 0;
 
+	substrate_layout layout_ = substrate_layout::interleaved;
+
 	thrust::device_ptr<real_t> substrate_densities_;
 
 	thrust::device_ptr<real_t> initial_conditions_;
@@ -58,6 +66,7 @@ public:
 								  thrust::device_ptr<real_t>& e, index_t shape, index_t dims, index_t n,
 								  const microenvironment& m, index_t copies);
 
+	// Interleaved layout, valid only if it is the selected one
 	template <std::size_t dims = 3>
 	auto get_substrates_layout() const
 	{
@@ -69,6 +78,33 @@ public:
 			return noarr::scalar<real_t>() ^ noarr::vectors<'s', 'x', 'y', 'z'>(ns_, nx_, ny_, nz_);
 	}
 
+	// Planar layout, valid only if it is the selected one
+	template <std::size_t dims = 3>
+	auto get_planar_substrates_layout() const
+	{
+		if constexpr (dims == 1)
+			return noarr::scalar<real_t>() ^ noarr::vectors<'x', 's'>(nx_, ns_);
+		else if constexpr (dims == 2)
+			return noarr::scalar<real_t>() ^ noarr::vectors<'x', 'y', 's'>(nx_, ny_, ns_);
+		else if constexpr (dims == 3)
+			return noarr::scalar<real_t>() ^ noarr::vectors<'x', 'y', 'z', 's'>(nx_, ny_, nz_, ns_);
+	}
+
+	// Calls f with the selected substrates layout, so f is instantiated for both layouts
+	template <std::size_t dims = 3, typename F>
+	decltype(auto) visit_substrates_layout(F&& f) const
+	{
+		if (layout_ == substrate_layout::planar)
+			return f(get_planar_substrates_layout<dims>());
+
+		return f(get_substrates_layout<dims>());
+	}
+
+	substrate_layout get_layout() const { return layout_; }
+
+	// Element strides of s, x, y and z in the selected layout
+	std::array<index_t, 4> get_substrates_strides() const;
+
 	thrust::device_ptr<real_t> get_substrates_pointer();
 
 	void initialize(microenvironment& m);
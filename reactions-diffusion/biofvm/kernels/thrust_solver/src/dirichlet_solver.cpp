@@ -219,13 +219,14 @@ void dirichlet_solver::initialize(microenvironment& m)
 
 void dirichlet_solver::solve(microenvironment& m, diffusion_solver& d_solver)
 {
-	solve_boundaries(d_solver.get_substrates_layout(), d_solver.get_substrates_pointer().get(), m,
-					 dirichlet_min_boundary_values, dirichlet_max_boundary_values, dirichlet_min_boundary_conditions,
-					 dirichlet_max_boundary_conditions);
-
-	if (m.dirichlet_interior_voxels_count != 0)
-		solve_interior(d_solver.get_substrates_layout(), d_solver.get_substrates_pointer().get(),
-					   dirichlet_interior_voxels.data().get(), dirichlet_interior_values.data().get(),
-					   dirichlet_interior_conditions.data().get(), m.substrates_count,
-					   m.dirichlet_interior_voxels_count, m.mesh.dims);
+	d_solver.visit_substrates_layout([&](auto dens_l) {
+		solve_boundaries(dens_l, d_solver.get_substrates_pointer().get(), m, dirichlet_min_boundary_values,
+						 dirichlet_max_boundary_values, dirichlet_min_boundary_conditions,
+						 dirichlet_max_boundary_conditions);
+
+		if (m.dirichlet_interior_voxels_count != 0)
+			solve_interior(dens_l, d_solver.get_substrates_pointer().get(), dirichlet_interior_voxels.data().get(),
+						   dirichlet_interior_values.data().get(), dirichlet_interior_conditions.data().get(),
+						   m.substrates_count, m.dirichlet_interior_voxels_count, m.mesh.dims);
+	});
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include <common/execution_context.h>
+#include <thrust/detail/config.h>
+
+#include "namespace_config.h"
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_TBB
+	#include <oneapi/tbb/task_arena.h>
+	#include <oneapi/tbb/task_scheduler_observer.h>
+#endif
+
+namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE {
+
+/*
+Runs the solver's thrust algorithms on the worker threads of an execution context.
+
+With the TBB device system, algorithms started inside a task arena run only on the threads of that arena, which are
+pinned to the context cpus as they join it; the thread calling execute is pinned only until it leaves the arena.
+Other device systems manage their own threads, so the work runs directly.
+*/
+class execution_arena
+{
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_TBB
+	class pinning_observer : public oneapi::tbb::task_scheduler_observer
+	{
+		std::shared_ptr<const execution_context> context_;
+
+	public:
+		pinning_observer(oneapi::tbb::task_arena& arena, std::shared_ptr<const execution_context> context)
+			: oneapi::tbb::task_scheduler_observer(arena), context_(std::move(context))
+		{
+			observe(true);
+		}
+
+		~pinning_observer() override { observe(false); }
+
+		// Workers stay in the arena's pool and keep their pinning, the thread calling execute goes on running the
+		// caller's code afterwards, so it gets its previous affinity back when it leaves the arena
+		void on_scheduler_entry(bool is_worker) override
+		{
+			const auto worker_index = static_cast<index_t>(oneapi::tbb::this_task_arena::current_thread_index());
+
+			if (is_worker)
+				context_->pin_current_thread(worker_index);
+			else if (!caller_pin())
+				caller_pin().emplace(context_.get(), worker_index, true);
+		}
+
+		void on_scheduler_exit(bool is_worker) override
+		{
+			if (!is_worker)
+				caller_pin().reset();
+		}
+
+	private:
+		static std::optional<execution_context::scoped_pin>& caller_pin()
+		{
+			thread_local std::optional<execution_context::scoped_pin> pin;
+			return pin;
+		}
+	};
+
+	std::unique_ptr<oneapi::tbb::task_arena> arena_;
+	std::unique_ptr<pinning_observer> observer_;
+#endif
+
+public:
+	// Null context or a zero threads count keeps the global TBB arena
+	void initialize(std::shared_ptr<const execution_context> context)
+	{
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_TBB
+		if (!context || context->get_threads_count() == 0)
+			return;
+
+		arena_ = std::make_unique<oneapi::tbb::task_arena>(static_cast<int>(context->get_threads_count()));
+		arena_->initialize();
+
+		if (!context->get_cpus().empty())
+			observer_ = std::make_unique<pinning_observer>(*arena_, std::move(context));
+#else
+		(void)context;
+#endif
+	}
+
+	template <typename F>
+	void execute(F&& f)
+	{
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_TBB
+		if (arena_)
+		{
+			arena_->execute(std::forward<F>(f));
+			return;
+		}
+#endif
+		std::forward<F>(f)();
+	}
+};
+
+} // namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE
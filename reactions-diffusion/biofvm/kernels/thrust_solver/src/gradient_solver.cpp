@@ -0,0 +1,96 @@
+#include "gradient_solver.h"
+
+#include <noarr/structures_extended.hpp>
+#include <thrust/copy.h>
+#include <thrust/execution_policy.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include "namespace_config.h"
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+	#include <cuda/std/array>
+#endif
+
+using namespace physicore;
+using namespace physicore::biofvm;
+using namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE;
+
+namespace {
+template <index_t dims>
+constexpr auto fix_voxel(const index_t* voxel)
+{
+	if constexpr (dims == 1)
+		return noarr::fix<'x'>(voxel[0]);
+	else if constexpr (dims == 2)
+		return noarr::fix<'x'>(voxel[0]) ^ noarr::fix<'y'>(voxel[1]);
+	else if constexpr (dims == 3)
+		return noarr::fix<'x'>(voxel[0]) ^ noarr::fix<'y'>(voxel[1]) ^ noarr::fix<'z'>(voxel[2]);
+}
+
+template <index_t dims, typename density_layout_t>
+void compute_field_dim(const density_layout_t dens_l, const real_t* _CCCL_RESTRICT substrates,
+					   const cartesian_mesh& m, index_t s, index_t dim, real_t* _CCCL_RESTRICT output)
+{
+	const PHYSICORE_THRUST_STD::array<index_t, 3> grid_shape = { m.grid_shape[0], m.grid_shape[1], m.grid_shape[2] };
+	const auto dx = (real_t)m.voxel_shape[dim];
+	const index_t n = m.voxel_count();
+
+	thrust::for_each(thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(n),
+					 [dens_l, substrates, output, grid_shape, s, dim, dx] PHYSICORE_THRUST_DEVICE_FN(index_t i) {
+						 index_t lower[3] = { i % grid_shape[0], (i / grid_shape[0]) % grid_shape[1],
+											  i / (grid_shape[0] * grid_shape[1]) };
+						 index_t upper[3] = { lower[0], lower[1], lower[2] };
+
+						 if (lower[dim] > 0)
+							 lower[dim]--;
+						 if (upper[dim] + 1 < grid_shape[dim])
+							 upper[dim]++;
+
+						 if (lower[dim] == upper[dim])
+						 {
+							 output[i] = 0;
+							 return;
+						 }
+
+						 const real_t lower_density =
+							 (dens_l ^ fix_voxel<dims>(lower)) | noarr::get_at<'s'>(substrates, s);
+						 const real_t upper_density =
+							 (dens_l ^ fix_voxel<dims>(upper)) | noarr::get_at<'s'>(substrates, s);
+
+						 output[i] = (upper_density - lower_density) / ((real_t)(upper[dim] - lower[dim]) * dx);
+					 });
+}
+} // namespace
+
+void gradient_solver::compute_gradient_field(const microenvironment& m, diffusion_solver& d_solver, index_t s,
+											 index_t dim, std::span<real_t> output)
+{
+	output_.resize(m.mesh.voxel_count());
+
+	real_t* substrates = d_solver.get_substrates_pointer().get();
+
+	switch (m.mesh.dims)
+	{
+		case 1:
+			d_solver.visit_substrates_layout<1>([&](auto dens_l) {
+				compute_field_dim<1>(dens_l, substrates, m.mesh, s, dim, output_.data().get());
+			});
+			break;
+		case 2:
+			d_solver.visit_substrates_layout<2>([&](auto dens_l) {
+				compute_field_dim<2>(dens_l, substrates, m.mesh, s, dim, output_.data().get());
+			});
+			break;
+		case 3:
+			d_solver.visit_substrates_layout<3>([&](auto dens_l) {
+				compute_field_dim<3>(dens_l, substrates, m.mesh, s, dim, output_.data().get());
+			});
+			break;
+		default:
+			assert(false);
+			return;
+	}
+
+	thrust::copy(output_.begin(), output_.end(), output.begin());
+}
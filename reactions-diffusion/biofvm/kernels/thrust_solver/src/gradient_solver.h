@@ -0,0 +1,33 @@
+#pragma once
+
+#include <span>
+
+#include <biofvm/microenvironment.h>
+#include <thrust/device_vector.h>
+
+#include "diffusion_solver.h"
+#include "namespace_config.h"
+
+/*
+Computes the gradient field of a single substrate along a single dimension.
+
+For each voxel v, the gradient along dimension d is the central difference of the neighbouring voxels:
+G = (D[v + e_d] - D[v - e_d]) / (2*dx_d)
+At the domain boundary, the one-sided difference with the voxel itself is used instead. Dimensions with a single voxel
+have zero gradient.
+
+The field is computed on the device, one voxel per thread, and copied back to the host output (x varying fastest).
+*/
+
+namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE {
+
+class gradient_solver
+{
+	thrust::device_vector<real_t> output_;
+
+public:
+	void compute_gradient_field(const microenvironment& m, diffusion_solver& d_solver, index_t s, index_t dim,
+								std::span<real_t> output);
+};
+
+} // namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE
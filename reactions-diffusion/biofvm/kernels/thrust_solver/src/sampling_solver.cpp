@@ -0,0 +1,149 @@
+#include "sampling_solver.h"
+
+#include <noarr/structures_extended.hpp>
+#include <thrust/copy.h>
+#include <thrust/execution_policy.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include "data_manager.h"
+#include "namespace_config.h"
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+	#include <cuda/std/array>
+#endif
+
+using namespace physicore;
+using namespace physicore::biofvm;
+using namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE;
+
+namespace {
+struct axis_sample
+{
+	index_t lower;
+	index_t upper;
+	real_t weight; // weight of the upper voxel
+};
+
+PHYSICORE_THRUST_DEVICE_FN axis_sample sample_axis(real_t position, sindex_t mesh_min, index_t voxel_size,
+												   index_t grid_size, bool nearest)
+{
+	const real_t t = (position - (real_t)mesh_min) / (real_t)voxel_size;
+
+	if (nearest)
+	{
+		index_t voxel = t <= 0 ? 0 : (index_t)t;
+		voxel = voxel < grid_size ? voxel : grid_size - 1;
+		return { voxel, voxel, 0 };
+	}
+
+	const real_t c = t - (real_t)0.5;
+
+	if (c <= 0)
+		return { 0, 0, 0 };
+
+	const auto lower = (index_t)c;
+
+	if (lower >= grid_size - 1)
+		return { grid_size - 1, grid_size - 1, 0 };
+
+	return { lower, lower + 1, c - (real_t)lower };
+}
+
+template <index_t dims>
+constexpr auto fix_voxel(const index_t* voxel)
+{
+	if constexpr (dims == 1)
+		return noarr::fix<'x'>(voxel[0]);
+	else if constexpr (dims == 2)
+		return noarr::fix<'x'>(voxel[0]) ^ noarr::fix<'y'>(voxel[1]);
+	else if constexpr (dims == 3)
+		return noarr::fix<'x'>(voxel[0]) ^ noarr::fix<'y'>(voxel[1]) ^ noarr::fix<'z'>(voxel[2]);
+}
+
+template <index_t dims, typename density_layout_t>
+void sample_dim(const density_layout_t dens_l, const real_t* _CCCL_RESTRICT substrates, const cartesian_mesh& m,
+				const real_t* _CCCL_RESTRICT positions, real_t* _CCCL_RESTRICT output, index_t n, bool nearest)
+{
+	const PHYSICORE_THRUST_STD::array<sindex_t, 3> bounding_box_mins = { m.bounding_box_mins[0], m.bounding_box_mins[1],
+																		 m.bounding_box_mins[2] };
+	const PHYSICORE_THRUST_STD::array<index_t, 3> voxel_shape = { m.voxel_shape[0], m.voxel_shape[1],
+																  m.voxel_shape[2] };
+	const PHYSICORE_THRUST_STD::array<index_t, 3> grid_shape = { m.grid_shape[0], m.grid_shape[1], m.grid_shape[2] };
+
+	thrust::for_each(thrust::device, thrust::make_counting_iterator<index_t>(0), thrust::make_counting_iterator(n),
+					 [dens_l, substrates, positions, output, bounding_box_mins, voxel_shape, grid_shape,
+					  nearest] PHYSICORE_THRUST_DEVICE_FN(index_t i) {
+						 const index_t substrates_count = dens_l | noarr::get_length<'s'>();
+
+						 axis_sample axes[dims];
+						 for (index_t d = 0; d < dims; d++)
+							 axes[d] = sample_axis(positions[i * dims + d], bounding_box_mins[d], voxel_shape[d],
+												   grid_shape[d], nearest);
+
+						 real_t* out = output + i * substrates_count;
+
+						 for (index_t s = 0; s < substrates_count; s++)
+							 out[s] = 0;
+
+						 for (index_t corner = 0; corner < (index_t(1) << dims); corner++)
+						 {
+							 index_t voxel[dims];
+							 real_t weight = 1;
+
+							 for (index_t d = 0; d < dims; d++)
+							 {
+								 const bool upper = (corner >> d) & 1;
+								 voxel[d] = upper ? axes[d].upper : axes[d].lower;
+								 weight *= upper ? axes[d].weight : 1 - axes[d].weight;
+							 }
+
+							 // nearest sampling and clamped dimensions give zero weight to all upper corners
+							 if (weight == 0)
+								 continue;
+
+							 const auto voxel_l = dens_l ^ fix_voxel<dims>(voxel);
+
+							 for (index_t s = 0; s < substrates_count; s++)
+								 out[s] += weight * (voxel_l | noarr::get_at<'s'>(substrates, s));
+						 }
+					 });
+}
+} // namespace
+
+void sampling_solver::sample(const microenvironment& m, diffusion_solver& d_solver, std::span<const real_t> positions,
+							 std::span<real_t> output, interpolation mode)
+{
+	const index_t n = positions.size() / m.mesh.dims;
+
+	positions_.assign(positions.begin(), positions.end());
+	output_.resize(n * m.substrates_count);
+
+	const bool nearest = mode == interpolation::nearest;
+
+	real_t* substrates = d_solver.get_substrates_pointer().get();
+
+	switch (m.mesh.dims)
+	{
+		case 1:
+			d_solver.visit_substrates_layout<1>([&](auto dens_l) {
+				sample_dim<1>(dens_l, substrates, m.mesh, positions_.data().get(), output_.data().get(), n, nearest);
+			});
+			break;
+		case 2:
+			d_solver.visit_substrates_layout<2>([&](auto dens_l) {
+				sample_dim<2>(dens_l, substrates, m.mesh, positions_.data().get(), output_.data().get(), n, nearest);
+			});
+			break;
+		case 3:
+			d_solver.visit_substrates_layout<3>([&](auto dens_l) {
+				sample_dim<3>(dens_l, substrates, m.mesh, positions_.data().get(), output_.data().get(), n, nearest);
+			});
+			break;
+		default:
+			assert(false);
+			return;
+	}
+
+	thrust::copy(output_.begin(), output_.end(), output.begin());
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <span>
+
+#include <biofvm/microenvironment.h>
+#include <thrust/device_vector.h>
+
+#include "diffusion_solver.h"
+#include "namespace_config.h"
+
+/*
+Samples substrate densities at arbitrary positions.
+
+For each position p and each dimension d, the position is converted to voxel coordinates:
+t_d = (p_d - min_d) / dx_d
+
+Nearest: D(p) = D[floor(t)] (clamped to the grid)
+
+Trilinear: the voxel centers are at t = i + 0.5, so with c_d = t_d - 0.5, l_d = floor(c_d) and w_d = c_d - l_d:
+D(p) = sum_{corners} prod_d (w_d if upper corner in d else 1 - w_d) * D[corner]
+Positions closer to the domain boundary than half a voxel are clamped to the boundary voxel centers.
+
+Positions are copied to the device, sampled there and the result is copied back to the host output.
+*/
+
+namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE {
+
+class sampling_solver
+{
+	thrust::device_vector<real_t> positions_;
+	thrust::device_vector<real_t> output_;
+
+public:
+	void sample(const microenvironment& m, diffusion_solver& d_solver, std::span<const real_t> positions,
+				std::span<real_t> output, interpolation mode);
+};
+
+} // namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE
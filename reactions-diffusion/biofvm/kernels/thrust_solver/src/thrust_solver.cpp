@@ -9,13 +9,17 @@ void thrust_solver::initialize(biofvm::microenvironment& m)
 	if (initialized)
 		return;
 
-	d_solver.initialize(m, 1);
+	arena.initialize(m.context);
 
-	dir_solver.initialize(m);
+	arena.execute([&] {
+		d_solver.initialize(m, 1);
 
-	c_solver.initialize(m);
+		dir_solver.initialize(m);
 
-	mgr.initialize(m, d_solver);
+		c_solver.initialize(m);
+
+		mgr.initialize(m, d_solver);
+	});
 
 	initialized = true;
 }
@@ -24,34 +28,62 @@ void thrust_solver::solve(biofvm::microenvironment& m, index_t iterations)
 {
 	initialize(m);
 
-	for (index_t it = 0; it < iterations; it++)
-	{
-		d_solver.solve();
+	arena.execute([&] {
+		for (index_t it = 0; it < iterations; it++)
+		{
+			d_solver.solve();
 
-		dir_solver.solve(m, d_solver);
+			dir_solver.solve(m, d_solver);
 
-		b_solver.solve(m, d_solver);
+			b_solver.solve(m, d_solver);
 
-		c_solver.simulate_secretion_and_uptake(m, d_solver, mgr, recompute_cells);
-	}
+			c_solver.simulate_secretion_and_uptake(m, d_solver, mgr, recompute_cells);
+		}
+	});
 
 	recompute_cells = false;
 }
 
 real_t thrust_solver::get_substrate_density(index_t s, index_t x, index_t y, index_t z) const
 {
-	auto dens_l = d_solver.get_substrates_layout<3>();
 	auto* densities = mgr.substrate_densities;
 
-	return dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(densities, s, x, y, z);
+	return d_solver.visit_substrates_layout([&](auto dens_l) -> real_t {
+		return dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(densities, s, x, y, z);
+	});
 }
 
 real_t& thrust_solver::get_substrate_density(index_t s, index_t x, index_t y, index_t z)
 {
-	auto dens_l = d_solver.get_substrates_layout<3>();
 	auto* densities = mgr.substrate_densities;
 
-	return dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(densities, s, x, y, z);
+	return d_solver.visit_substrates_layout([&](auto dens_l) -> real_t& {
+		return dens_l | noarr::get_at<'s', 'x', 'y', 'z'>(densities, s, x, y, z);
+	});
+}
+
+substrate_field_view thrust_solver::get_substrate_field_view() const
+{
+	const auto dens_l = d_solver.get_substrates_layout<3>();
+
+	const index_t ns = dens_l | noarr::get_length<'s'>();
+	const index_t nx = dens_l | noarr::get_length<'x'>();
+	const index_t ny = dens_l | noarr::get_length<'y'>();
+	const index_t nz = dens_l | noarr::get_length<'z'>();
+
+	return { mgr.substrate_densities, { ns, nx, ny, nz }, d_solver.get_substrates_strides() };
+}
+
+void thrust_solver::sample_substrate_densities(const microenvironment& m, std::span<const real_t> positions,
+											   std::span<real_t> output, interpolation mode)
+{
+	arena.execute([&] { s_solver.sample(m, d_solver, positions, output, mode); });
+}
+
+void thrust_solver::compute_gradient_field(const microenvironment& m, index_t s, index_t dim,
+										   std::span<real_t> output)
+{
+	arena.execute([&] { g_solver.compute_gradient_field(m, d_solver, s, dim, output); });
 }
 
 void thrust_solver::transfer_to_device(microenvironment& /*m*/) { mgr.transfer_to_device(); }
@@ -60,4 +92,16 @@ void thrust_solver::transfer_to_host(microenvironment& /*m*/) { mgr.transfer_to_
 
 void thrust_solver::reinitialize_dirichlet(microenvironment& m) { dir_solver.initialize(m); }
 
-void thrust_solver::recompute_positional_data([[maybe_unused]] microenvironment& m) { recompute_cells = true; }
+void thrust_solver::prepare_agents_reorder(microenvironment& /*m*/)
+{
+	if (initialized)
+		mgr.prepare_agents_reorder();
+}
+
+void thrust_solver::recompute_positional_data(microenvironment& /*m*/)
+{
+	recompute_cells = true;
+
+	if (initialized)
+		mgr.sync_reordered_agents();
+}
@@ -7,7 +7,10 @@
 #include "data_manager.h"
 #include "diffusion_solver.h"
 #include "dirichlet_solver.h"
+#include "execution_arena.h"
+#include "gradient_solver.h"
 #include "namespace_config.h"
+#include "sampling_solver.h"
 
 namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE {
 
@@ -20,17 +23,27 @@ class thrust_solver : public solver
 	cell_solver c_solver;
 	diffusion_solver d_solver;
 	dirichlet_solver dir_solver;
+	sampling_solver s_solver;
+	gradient_solver g_solver;
 
 	data_manager mgr;
 
+	execution_arena arena;
+
 public:
 	void initialize(microenvironment& m) override;
 	void solve(microenvironment& m, index_t iterations) override;
 	real_t get_substrate_density(index_t s, index_t x, index_t y, index_t z) const override;
 	real_t& get_substrate_density(index_t s, index_t x, index_t y, index_t z) override;
+	substrate_field_view get_substrate_field_view() const override;
+	void sample_substrate_densities(const microenvironment& m, std::span<const real_t> positions,
+									std::span<real_t> output, interpolation mode) override;
+	void compute_gradient_field(const microenvironment& m, index_t s, index_t dim,
+								std::span<real_t> output) override;
 	void transfer_to_device(microenvironment& m) override;
 	void transfer_to_host(microenvironment& m) override;
 	void reinitialize_dirichlet(microenvironment& m) override;
+	void prepare_agents_reorder(microenvironment& m) override;
 	void recompute_positional_data(microenvironment& m) override;
 };
 
@@ -414,6 +414,99 @@ TEST_P(RecomputeTest, Simple3D)
 	}
 }
 
+// Same scenario as Simple3D with one contiguous grid per substrate
+TEST_P(RecomputeTest, Simple3DPlanar)
+{
+	const bool compute_internalized = std::get<0>(GetParam());
+	const bool recompute = std::get<1>(GetParam());
+
+	const cartesian_mesh mesh(3, { 0, 0, 0 }, { 60, 60, 60 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh, compute_internalized);
+	m->densities_layout = substrate_layout::planar;
+
+	auto* a1 = m->agents->create();
+	auto* a2 = m->agents->create();
+	auto* a3 = m->agents->create();
+
+	set_default_agent_values(a1, 0, 1000, { 10, 10, 10 }, 3);
+	set_default_agent_values(a2, 400, 1000, { 30, 30, 30 }, 3);
+	set_default_agent_values(a3, 800, 1000, { 50, 50, 50 }, 3);
+
+	diffusion_solver d_s;
+	cell_solver s;
+	data_manager mgr;
+
+	d_s.initialize(*m, 1);
+	s.initialize(*m);
+	mgr.initialize(*m, d_s);
+
+	mgr.transfer_to_device();
+	s.simulate_secretion_and_uptake(*m, d_s, mgr, true);
+	mgr.transfer_to_host();
+
+	ASSERT_EQ(d_s.get_layout(), substrate_layout::planar);
+
+	auto dens_l = d_s.get_planar_substrates_layout<3>();
+	auto densities = noarr::make_bag(dens_l, mgr.substrate_densities);
+
+	if (compute_internalized)
+	{
+		EXPECT_NEAR(a1->internalized_substrates()[0], -216000.000000, 1e-6);
+		EXPECT_NEAR(a1->internalized_substrates()[1], -4, 1e-6);
+
+		EXPECT_NEAR(a2->internalized_substrates()[0], -1469052.6, 0.1);
+		EXPECT_NEAR(a2->internalized_substrates()[1], -8, 1e-6);
+
+		EXPECT_NEAR(a3->internalized_substrates()[0], -2927703.8, 0.1);
+		EXPECT_NEAR(a3->internalized_substrates()[1], -12, 1e-6);
+	}
+
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(0, 0, 0, 0)), 28, 1e-6);
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(0, 0, 0, 1)), 1.0005, 1e-6);
+
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(1, 1, 1, 0)), 184.63158, 1e-5);
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(1, 1, 1, 1)), 1.001, 1e-6);
+
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(2, 2, 2, 0)), 366.963, 1e-3);
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(2, 2, 2, 1)), 1.0015, 1e-6);
+
+	s.simulate_secretion_and_uptake(*m, d_s, mgr, recompute);
+	mgr.transfer_to_host();
+
+	if (compute_internalized)
+	{
+		EXPECT_NEAR(a1->internalized_substrates()[0], -373091, 0.1);
+		EXPECT_NEAR(a1->internalized_substrates()[1], -8, 1e-6);
+
+		EXPECT_NEAR(a2->internalized_substrates()[0], -2087601.1, 0.1);
+		EXPECT_NEAR(a2->internalized_substrates()[1], -16, 1e-6);
+
+		EXPECT_NEAR(a3->internalized_substrates()[0], -3795171.5, 0.1);
+		EXPECT_NEAR(a3->internalized_substrates()[1], -24, 1e-6);
+	}
+
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(0, 0, 0, 0)), 47.636364, 1e-6);
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(0, 0, 0, 1)), 1.001, 1e-6);
+
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(1, 1, 1, 0)), 261.95, 1e-2);
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(1, 1, 1, 1)), 1.002, 1e-6);
+
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(2, 2, 2, 0)), 475.39642, 1e-4);
+	EXPECT_NEAR((densities.at<'x', 'y', 'z', 's'>(2, 2, 2, 1)), 1.003, 1e-6);
+
+	s.release_internalized_substrates(*m, d_s, mgr, 0);
+	mgr.transfer_to_host();
+
+	if (compute_internalized)
+	{
+		EXPECT_DOUBLE_EQ((densities.at<'x', 'y', 'z', 's'>(0, 0, 0, 0)), 1);
+		EXPECT_DOUBLE_EQ((densities.at<'x', 'y', 'z', 's'>(0, 0, 0, 1)), 1);
+		EXPECT_DOUBLE_EQ(a1->internalized_substrates()[0], 0);
+		EXPECT_DOUBLE_EQ(a1->internalized_substrates()[1], 0);
+	}
+}
+
 class agent_retriever : public generic_agent_solver<agent>
 {};
 
@@ -791,3 +884,54 @@ TEST(PREPEND_TEST_NAME(ThrustCellSolverTest), InactiveAgentReactivation)
 	EXPECT_NEAR((densities.at<'x', 's'>(0, 0)), 47.636364, 1e-4);
 	EXPECT_NEAR((densities.at<'x', 's'>(0, 1)), 1.001, 1e-6);
 }
+
+TEST(PREPEND_TEST_NAME(ThrustCellSolverTest), InactiveAgentWithoutRecompute)
+{
+	// Writing is_active alone has to rebuild the active agents list on the next step
+	const bool compute_internalized = true;
+
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 40, 20, 20 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh, compute_internalized);
+
+	auto* agent = m->agents->create();
+	set_default_agent_values(agent, 0, 1000, { 10, 0, 0 }, 1);
+
+	diffusion_solver d_s;
+	cell_solver s;
+	data_manager mgr;
+
+	d_s.initialize(*m, 1);
+	s.initialize(*m);
+	mgr.initialize(*m, d_s);
+	mgr.transfer_to_device();
+
+	auto dens_l = d_s.get_substrates_layout<1>();
+	auto densities = noarr::make_bag(dens_l, mgr.substrate_densities);
+
+	agent->is_active() = 1;
+
+	s.simulate_secretion_and_uptake(*m, d_s, mgr, true);
+	mgr.transfer_to_host();
+
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 0)), 28, 1e-6);
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 1)), 1.0005, 1e-6);
+
+	agent->is_active() = 0;
+
+	mgr.transfer_to_device();
+	s.simulate_secretion_and_uptake(*m, d_s, mgr, false);
+	mgr.transfer_to_host();
+
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 0)), 28, 1e-6);
+	EXPECT_NEAR((densities.template at<'x', 's'>(0, 1)), 1.0005, 1e-6);
+
+	agent->is_active() = 1;
+
+	mgr.transfer_to_device();
+	s.simulate_secretion_and_uptake(*m, d_s, mgr, false);
+	mgr.transfer_to_host();
+
+	EXPECT_NEAR((densities.at<'x', 's'>(0, 0)), 47.636364, 1e-4);
+	EXPECT_NEAR((densities.at<'x', 's'>(0, 1)), 1.001, 1e-6);
+}
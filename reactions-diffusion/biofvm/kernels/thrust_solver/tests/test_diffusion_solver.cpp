@@ -279,3 +279,58 @@ TEST(PREPEND_TEST_NAME(ThrustDiffusionSolverTest), Random3D)
 								1e-6);
 				}
 }
+
+TEST(PREPEND_TEST_NAME(ThrustDiffusionSolverTest), Random3DPlanar)
+{
+	cartesian_mesh mesh(3, { 0, 0, 0 }, { 60, 60, 60 }, { 20, 20, 20 });
+
+	auto m = biorobots_microenv(mesh);
+	m->densities_layout = substrate_layout::planar;
+
+	diffusion_solver s;
+	data_manager mgr;
+
+	s.initialize(*m, 1);
+	mgr.initialize(*m, s);
+
+	auto dens_l = s.get_planar_substrates_layout<3>();
+	real_t* densities = mgr.substrate_densities;
+
+	// fill with random values
+	for (index_t s = 0; s < m->substrates_count; ++s)
+		for (index_t x = 0; x < mesh.grid_shape[0]; ++x)
+			for (index_t y = 0; y < mesh.grid_shape[1]; ++y)
+				for (index_t z = 0; z < mesh.grid_shape[2]; ++z)
+				{
+					const index_t index = s + x * m->substrates_count + y * m->substrates_count * mesh.grid_shape[0]
+										  + z * m->substrates_count * mesh.grid_shape[0] * mesh.grid_shape[1];
+					(dens_l | noarr::get_at<'x', 'y', 'z', 's'>(densities, x, y, z, s)) = static_cast<real_t>(index);
+				}
+
+	mgr.transfer_to_device();
+	s.solve();
+	mgr.transfer_to_host();
+
+	std::vector<double> expected = {
+		0.6333066643,  1.6268066007,  2.5825920996,	 3.5703051208,	4.5318775349,  5.5138036408,  6.4811629703,
+		7.4573021609,  8.4304484056,  9.4008006809,	 10.3797338410, 11.3442992010, 12.3290192763, 13.2877977210,
+		14.2783047117, 15.2312962410, 16.2275901470, 17.1747947611, 18.1768755823, 19.1182932811, 20.1261610177,
+		21.0617918012, 22.0754464530, 23.0052903212, 24.0247318884, 24.9487888412, 25.9740173237, 26.8922873613,
+		27.9233027591, 28.8357858813, 29.8725881944, 30.7792844014, 31.8218736297, 32.7227829214, 33.7711590651,
+		34.6662814414, 35.7204445004, 36.6097799615, 37.6697299358, 38.5532784815, 39.6190153711, 40.4967770016,
+		41.5683008064, 42.4402755216, 43.5175862418, 44.3837740416, 45.4668716771, 46.3272725617, 47.4161571125,
+		48.2707710817, 49.3654425478, 50.2142696018, 51.3147279832, 52.1577681218
+	};
+
+	for (index_t s = 0; s < m->substrates_count; ++s)
+		for (index_t x = 0; x < mesh.grid_shape[0]; ++x)
+			for (index_t y = 0; y < mesh.grid_shape[1]; ++y)
+				for (index_t z = 0; z < mesh.grid_shape[2]; ++z)
+				{
+					const index_t index = s + x * m->substrates_count + y * m->substrates_count * mesh.grid_shape[0]
+										  + z * m->substrates_count * mesh.grid_shape[0] * mesh.grid_shape[1];
+
+					EXPECT_NEAR((dens_l | noarr::get_at<'x', 'y', 'z', 's'>(densities, x, y, z, s)), expected[index],
+								1e-6);
+				}
+}
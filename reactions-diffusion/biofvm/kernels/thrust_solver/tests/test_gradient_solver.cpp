@@ -0,0 +1,123 @@
+#include <array>
+
+#include <biofvm/microenvironment.h>
+#include <gtest/gtest.h>
+#include <noarr/structures/interop/bag.hpp>
+
+#include "data_manager.h"
+#include "diffusion_solver.h"
+#include "gradient_solver.h"
+#include "namespace_config.h"
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+	#define PREPEND_TEST_NAME(name) cuda##name
+#else
+	#define PREPEND_TEST_NAME(name) tbb##name
+#endif
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+using namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE;
+
+namespace {
+std::unique_ptr<microenvironment> default_microenv(cartesian_mesh mesh)
+{
+	const real_t timestep = 0.01;
+	const index_t substrates_count = 2;
+
+	auto diff_coefs = std::make_unique<real_t[]>(2);
+	diff_coefs[0] = 4;
+	diff_coefs[1] = 2;
+	auto decay_rates = std::make_unique<real_t[]>(2);
+	decay_rates[0] = 5;
+	decay_rates[1] = 3;
+
+	auto initial_conds = std::make_unique<real_t[]>(2);
+	initial_conds[0] = 0;
+	initial_conds[1] = 0;
+
+	auto m = std::make_unique<microenvironment>(mesh, substrates_count, timestep);
+	m->diffusion_coefficients = std::move(diff_coefs);
+	m->decay_rates = std::move(decay_rates);
+	m->initial_conditions = std::move(initial_conds);
+
+	return m;
+}
+
+// D(s, x, y, z) = x + 10y^2 + 100z + 1000s, quadratic in y to tell central and one-sided differences apart
+void fill_densities(const microenvironment& m, diffusion_solver& d_s, data_manager& mgr)
+{
+	auto densities = noarr::make_bag(d_s.get_substrates_layout<3>(), mgr.substrate_densities);
+
+	for (index_t z = 0; z < m.mesh.grid_shape[2]; z++)
+		for (index_t y = 0; y < m.mesh.grid_shape[1]; y++)
+			for (index_t x = 0; x < m.mesh.grid_shape[0]; x++)
+				for (index_t s = 0; s < m.substrates_count; s++)
+					densities.template at<'s', 'x', 'y', 'z'>(s, x, y, z) =
+						static_cast<real_t>(x + 10 * y * y + 100 * z + 1000 * s);
+
+	mgr.transfer_to_device();
+}
+} // namespace
+
+TEST(PREPEND_TEST_NAME(GradientSolverTest), Field2D)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 60, 0 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+
+	diffusion_solver d_s;
+	data_manager mgr;
+	gradient_solver g_s;
+
+	d_s.initialize(*m, 1);
+	mgr.initialize(*m, d_s);
+
+	fill_densities(*m, d_s, mgr);
+
+	std::vector<real_t> field_x(mesh.voxel_count());
+	std::vector<real_t> field_y(mesh.voxel_count());
+
+	g_s.compute_gradient_field(*m, d_s, 1, 0, field_x);
+	g_s.compute_gradient_field(*m, d_s, 1, 1, field_y);
+
+	// one-sided, central and one-sided differences of 10y^2 along y
+	const std::array<real_t, 3> expected_y = { 0.5, 1, 1.5 };
+
+	for (index_t y = 0; y < 3; y++)
+		for (index_t x = 0; x < 3; x++)
+		{
+			EXPECT_DOUBLE_EQ(field_x[y * 3 + x], 1. / 20);
+			EXPECT_DOUBLE_EQ(field_y[y * 3 + x], expected_y[y]);
+		}
+}
+
+TEST(PREPEND_TEST_NAME(GradientSolverTest), Field3DSingleVoxelDimension)
+{
+	const cartesian_mesh mesh(3, { 0, 0, 0 }, { 60, 20, 60 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+
+	diffusion_solver d_s;
+	data_manager mgr;
+	gradient_solver g_s;
+
+	d_s.initialize(*m, 1);
+	mgr.initialize(*m, d_s);
+
+	fill_densities(*m, d_s, mgr);
+
+	std::vector<real_t> field_y(mesh.voxel_count());
+	std::vector<real_t> field_z(mesh.voxel_count());
+
+	g_s.compute_gradient_field(*m, d_s, 0, 1, field_y);
+	g_s.compute_gradient_field(*m, d_s, 0, 2, field_z);
+
+	// a single voxel along y has zero gradient, 100z changes by 5 per unit length along z
+	for (index_t i = 0; i < mesh.voxel_count(); i++)
+	{
+		EXPECT_DOUBLE_EQ(field_y[i], 0);
+		EXPECT_DOUBLE_EQ(field_z[i], 5);
+	}
+}
@@ -0,0 +1,125 @@
+#include <biofvm/microenvironment.h>
+#include <gtest/gtest.h>
+#include <noarr/structures/interop/bag.hpp>
+
+#include "data_manager.h"
+#include "diffusion_solver.h"
+#include "namespace_config.h"
+#include "sampling_solver.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+using namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE;
+
+namespace {
+std::unique_ptr<microenvironment> default_microenv(cartesian_mesh mesh)
+{
+	const real_t timestep = 0.01;
+	const index_t substrates_count = 2;
+
+	auto diff_coefs = std::make_unique<real_t[]>(2);
+	diff_coefs[0] = 4;
+	diff_coefs[1] = 2;
+	auto decay_rates = std::make_unique<real_t[]>(2);
+	decay_rates[0] = 5;
+	decay_rates[1] = 3;
+
+	auto initial_conds = std::make_unique<real_t[]>(2);
+	initial_conds[0] = 0;
+	initial_conds[1] = 0;
+
+	auto m = std::make_unique<microenvironment>(mesh, substrates_count, timestep);
+	m->diffusion_coefficients = std::move(diff_coefs);
+	m->decay_rates = std::move(decay_rates);
+	m->initial_conditions = std::move(initial_conds);
+
+	return m;
+}
+
+// D(s, x, y, z) = x + 10y + 100z + 1000s, linear so trilinear sampling is exact inside the domain
+// Densities are written through the layout selected by the microenvironment
+void fill_linear_densities(const microenvironment& m, diffusion_solver& d_s, data_manager& mgr)
+{
+	d_s.visit_substrates_layout([&](auto dens_l) {
+		auto densities = noarr::make_bag(dens_l, mgr.substrate_densities);
+
+		for (index_t z = 0; z < m.mesh.grid_shape[2]; z++)
+			for (index_t y = 0; y < m.mesh.grid_shape[1]; y++)
+				for (index_t x = 0; x < m.mesh.grid_shape[0]; x++)
+					for (index_t s = 0; s < m.substrates_count; s++)
+						densities.template at<'s', 'x', 'y', 'z'>(s, x, y, z) =
+							static_cast<real_t>(x + 10 * y + 100 * z + 1000 * s);
+	});
+
+	mgr.transfer_to_device();
+}
+} // namespace
+
+class SamplingLayoutTest : public testing::TestWithParam<substrate_layout>
+{};
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+INSTANTIATE_TEST_SUITE_P(cudaSamplingSolverTest, SamplingLayoutTest,
+						 testing::Values(substrate_layout::interleaved, substrate_layout::planar));
+#else
+INSTANTIATE_TEST_SUITE_P(tbbSamplingSolverTest, SamplingLayoutTest,
+						 testing::Values(substrate_layout::interleaved, substrate_layout::planar));
+#endif
+
+TEST_P(SamplingLayoutTest, Nearest2D)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 60, 0 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+	m->densities_layout = GetParam();
+
+	diffusion_solver d_s;
+	data_manager mgr;
+	sampling_solver s;
+
+	d_s.initialize(*m, 1);
+	mgr.initialize(*m, d_s);
+
+	fill_linear_densities(*m, d_s, mgr);
+
+	const std::vector<real_t> positions = { 25, 45, 0, 0, 60, 60 };
+	std::vector<real_t> output(3 * m->substrates_count);
+
+	s.sample(*m, d_s, positions, output, interpolation::nearest);
+
+	EXPECT_DOUBLE_EQ(output[0], 21);
+	EXPECT_DOUBLE_EQ(output[1], 1021);
+	EXPECT_DOUBLE_EQ(output[2], 0);
+	EXPECT_DOUBLE_EQ(output[3], 1000);
+	EXPECT_DOUBLE_EQ(output[4], 22);
+	EXPECT_DOUBLE_EQ(output[5], 1022);
+}
+
+TEST_P(SamplingLayoutTest, Trilinear3D)
+{
+	const cartesian_mesh mesh(3, { 0, 0, 0 }, { 60, 60, 60 }, { 20, 20, 20 });
+
+	auto m = default_microenv(mesh);
+	m->densities_layout = GetParam();
+
+	diffusion_solver d_s;
+	data_manager mgr;
+	sampling_solver s;
+
+	d_s.initialize(*m, 1);
+	mgr.initialize(*m, d_s);
+
+	fill_linear_densities(*m, d_s, mgr);
+
+	// interior point and point clamped in all dimensions
+	const std::vector<real_t> positions = { 25, 35, 45, 5, 5, 5 };
+	std::vector<real_t> output(2 * m->substrates_count);
+
+	s.sample(*m, d_s, positions, output, interpolation::trilinear);
+
+	EXPECT_DOUBLE_EQ(output[0], 0.75 + 12.5 + 175);
+	EXPECT_DOUBLE_EQ(output[1], 1000 + 0.75 + 12.5 + 175);
+	EXPECT_DOUBLE_EQ(output[2], 0);
+	EXPECT_DOUBLE_EQ(output[3], 1000);
+}
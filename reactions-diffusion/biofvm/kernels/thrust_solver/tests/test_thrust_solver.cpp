@@ -0,0 +1,143 @@
+#include <memory>
+#include <vector>
+
+#ifdef __linux__
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+#include <biofvm/microenvironment.h>
+#include <common/execution_context.h>
+#include <gtest/gtest.h>
+
+#include "namespace_config.h"
+#include "thrust_solver.h"
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+	#define PREPEND_TEST_NAME(name) cuda##name
+#else
+	#define PREPEND_TEST_NAME(name) tbb##name
+#endif
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+using namespace physicore::biofvm::kernels::PHYSICORE_THRUST_SOLVER_NAMESPACE;
+
+namespace {
+std::unique_ptr<microenvironment> default_microenv(cartesian_mesh mesh)
+{
+	const real_t timestep = 0.01;
+	const index_t substrates_count = 1;
+
+	auto diff_coefs = std::make_unique<real_t[]>(1);
+	diff_coefs[0] = 4;
+	auto decay_rates = std::make_unique<real_t[]>(1);
+	decay_rates[0] = 5;
+
+	auto initial_conds = std::make_unique<real_t[]>(1);
+	initial_conds[0] = 1;
+
+	auto m = std::make_unique<microenvironment>(mesh, substrates_count, timestep);
+	m->diffusion_coefficients = std::move(diff_coefs);
+	m->decay_rates = std::move(decay_rates);
+	m->initial_conditions = std::move(initial_conds);
+
+	m->compute_internalized_substrates = true;
+	m->solver = std::make_unique<thrust_solver>();
+
+	return m;
+}
+
+// Agents on the diagonal of an 8x8 mesh created from the far corner, each with rates of its own
+std::vector<agent_interface*> make_reversed_agents(microenvironment& m)
+{
+	std::vector<agent_interface*> agents;
+
+	for (index_t i = 0; i < 8; i++)
+	{
+		auto* a = m.agents->create();
+		a->position()[0] = static_cast<real_t>(75 - 10 * i);
+		a->position()[1] = static_cast<real_t>(75 - 10 * i);
+		a->secretion_rates()[0] = static_cast<real_t>(10 + i);
+		a->saturation_densities()[0] = static_cast<real_t>(20 + i);
+		a->uptake_rates()[0] = static_cast<real_t>(i);
+		a->volume() = static_cast<real_t>(100 + i);
+		agents.push_back(a);
+	}
+
+	return agents;
+}
+
+// Runs single timesteps and batched steps between the transfers of the documented device loop
+void run(microenvironment& m)
+{
+	m.solver->initialize(m);
+
+	for (index_t i = 0; i < 2; i++)
+	{
+		m.solver->transfer_to_device(m);
+		m.run_single_timestep();
+		m.solver->transfer_to_host(m);
+	}
+
+	m.solver->transfer_to_device(m);
+	m.run_steps(3);
+	m.solver->transfer_to_host(m);
+}
+} // namespace
+
+TEST(PREPEND_TEST_NAME(ThrustSolverTest), SortingKeepsAgentsAndResults)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 80, 80, 0 }, { 10, 10, 10 });
+
+	auto unsorted = default_microenv(mesh);
+	auto sorted = default_microenv(mesh);
+	sorted->agents_sort_interval = 1;
+
+	auto unsorted_agents = make_reversed_agents(*unsorted);
+	auto sorted_agents = make_reversed_agents(*sorted);
+
+	run(*unsorted);
+	run(*sorted);
+
+	EXPECT_DOUBLE_EQ(sorted->measure_agents_disorder(), 0.0);
+
+	for (index_t i = 0; i < 8; i++)
+	{
+		EXPECT_DOUBLE_EQ(sorted_agents[i]->volume(), static_cast<real_t>(100 + i));
+		EXPECT_DOUBLE_EQ(sorted_agents[i]->secretion_rates()[0], parameter_t(10 + i));
+		EXPECT_DOUBLE_EQ(sorted_agents[i]->position()[0], static_cast<real_t>(75 - 10 * i));
+		EXPECT_NEAR(sorted_agents[i]->internalized_substrates()[0], unsorted_agents[i]->internalized_substrates()[0],
+					1e-6);
+	}
+
+	for (index_t x = 0; x < 8; x++)
+		for (index_t y = 0; y < 8; y++)
+			EXPECT_NEAR(sorted->get_substrate_density(0, x, y, 0), unsorted->get_substrate_density(0, x, y, 0), 1e-6);
+}
+
+#if defined(__linux__) && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_TBB
+TEST(PREPEND_TEST_NAME(ThrustSolverTest), CallerAffinityIsRestored)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 80, 80, 0 }, { 10, 10, 10 });
+
+	auto m = default_microenv(mesh);
+	m->context = std::make_shared<execution_context>(2, std::vector<unsigned> { 0 });
+	make_reversed_agents(*m);
+
+	cpu_set_t before;
+	CPU_ZERO(&before);
+	ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(before), &before), 0);
+
+	m->solver->initialize(*m);
+	m->run_single_timestep();
+	m->run_steps(2);
+
+	cpu_set_t after;
+	CPU_ZERO(&after);
+	ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(after), &after), 0);
+
+	EXPECT_TRUE(CPU_EQUAL(&before, &after));
+}
+#endif
@@ -1,8 +1,12 @@
 #include "microenvironment.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
 
 #include <common/base_agent_data.h>
+#include <common/generic_agent_solver.h>
+#include <common/morton.h>
 
 #include "agent_container.h"
 #include "config_reader.h"
@@ -11,14 +15,17 @@
 using namespace physicore;
 using namespace physicore::biofvm;
 
-microenvironment::microenvironment(const cartesian_mesh& mesh, index_t substrates_count, real_t timestep)
+microenvironment::microenvironment(const cartesian_mesh& mesh, index_t substrates_count, real_t timestep,
+								   std::pmr::memory_resource* agents_resource)
 	: diffusion_timestep(timestep), mesh(mesh), substrates_count(substrates_count)
 {
-	auto base_data = std::make_unique<base_agent_data>(mesh.dims);
-	auto data = std::make_unique<agent_data>(*base_data, substrates_count);
+	auto base_data = std::make_unique<base_agent_data>(mesh.dims, agents_resource);
+	auto data = std::make_unique<agent_data>(*base_data, substrates_count, agents_resource);
 	agents = make_unique<agent_container>(std::move(base_data), std::move(data));
 }
 
+microenvironment::~microenvironment() { stop_async(); }
+
 std::unique_ptr<microenvironment> microenvironment::create_from_config(const std::filesystem::path& config_file)
 {
 	// Parse the XML configuration file
@@ -75,6 +82,11 @@ std::unique_ptr<microenvironment> microenvironment::create_from_config(const std
 		builder.do_compute_internalized_substrates();
 	}
 
+	if (config.microenvironment.calculate_gradients)
+	{
+		builder.do_compute_gradients();
+	}
+
 	if (!config.solver.name.empty())
 	{
 		builder.select_solver(config.solver.name);
@@ -84,7 +96,61 @@ std::unique_ptr<microenvironment> microenvironment::create_from_config(const std
 	return builder.build();
 }
 
-void microenvironment::run_single_timestep() { solver->solve(*this, 1); }
+void microenvironment::run_single_timestep()
+{
+	solver->solve(*this, 1);
+	densities_version_++;
+
+	if (publish_snapshots)
+		publish_substrate_snapshot();
+
+	sort_agents_if_due();
+}
+
+real_t microenvironment::get_timestep() const { return diffusion_timestep; }
+
+data_access microenvironment::get_timestep_access() const
+{
+	data_access access { .reads = { "positions", "is_active", "volumes", "secretion_rates", "saturation_densities",
+									"uptake_rates", "net_export_rates", "parameter_rows" },
+						 .writes = { "substrate_densities", "internalized_substrates" } };
+
+	// sorting reorders all agent data
+	if (agents_sort_interval != 0 || agents_sort_disorder_threshold > 0)
+		access.writes.insert({ "positions", "is_active", "volumes", "secretion_rates", "saturation_densities",
+							   "uptake_rates", "net_export_rates", "fraction_released_at_death",
+							   "fraction_transferred_when_ingested", "parameter_rows" });
+
+	return access;
+}
+
+data_access microenvironment::get_serialization_access() const
+{
+	data_access access { .reads = { "substrate_densities" }, .writes = {} };
+
+	if (agents_serializer)
+		access.reads.insert({ "positions", "volumes", "secretion_rates", "saturation_densities", "uptake_rates",
+							  "net_export_rates", "internalized_substrates", "fraction_released_at_death",
+							  "fraction_transferred_when_ingested", "parameter_rows" });
+
+	return access;
+}
+
+void microenvironment::run_steps(index_t steps, const step_callback& on_step)
+{
+	solver->solve_steps(*this, steps, [&](index_t step) {
+		densities_version_++;
+
+		if (publish_snapshots)
+			publish_substrate_snapshot();
+
+		// the solver recomputes its positional data before the next step if the agents were reordered
+		sort_agents_if_due();
+
+		if (on_step)
+			on_step(step);
+	});
+}
 
 void microenvironment::serialize_state(real_t current_time)
 {
@@ -100,6 +166,255 @@ real_t microenvironment::get_substrate_density(index_t s, index_t x, index_t y,
 	return solver_ptr->get_substrate_density(s, x, y, z);
 }
 
+substrate_field_view microenvironment::get_substrate_field_view() const { return solver->get_substrate_field_view(); }
+
+std::shared_ptr<const substrate_snapshot> microenvironment::get_substrate_snapshot() const
+{
+#ifdef __cpp_lib_atomic_shared_ptr
+	return snapshot_.load(std::memory_order_acquire);
+#else
+	return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+#endif
+}
+
+void microenvironment::publish_substrate_snapshot()
+{
+	// the published snapshot is the other buffer, so once nobody holds this one, nobody can acquire it anymore
+	// the acquire load pairs with the release in the deleter of the last reader, whose reads then precede the rewrite
+	auto& buffer = snapshot_buffers_[snapshot_epoch_ % 2];
+	if (!buffer || buffer->leased.load(std::memory_order_acquire))
+		buffer = std::make_shared<snapshot_buffer>();
+
+	buffer->leased.store(true, std::memory_order_relaxed);
+
+	// the deleter keeps the buffer alive for readers outliving the microenvironment
+	std::shared_ptr<const substrate_snapshot> published(&buffer->snapshot, [owner = buffer](const substrate_snapshot*) {
+		owner->leased.store(false, std::memory_order_release);
+	});
+
+	substrate_snapshot* snapshot = &buffer->snapshot;
+
+	const auto field = get_substrate_field_view();
+	const auto [ns, nx, ny, nz] = field.extents;
+
+	snapshot->epoch = snapshot_epoch_++;
+	snapshot->extents = field.extents;
+	snapshot->densities.resize(ns * nx * ny * nz);
+
+	real_t* densities = snapshot->densities.data();
+
+#pragma omp parallel for collapse(2) num_threads(get_team_size(context.get()))
+	for (index_t z = 0; z < nz; z++)
+		for (index_t y = 0; y < ny; y++)
+		{
+			real_t* row = densities + (z * ny + y) * nx * ns;
+
+			for (index_t x = 0; x < nx; x++)
+				for (index_t s = 0; s < ns; s++)
+					row[x * ns + s] = field(s, x, y, z);
+		}
+
+#ifdef __cpp_lib_atomic_shared_ptr
+	snapshot_.store(std::move(published), std::memory_order_release);
+#else
+	std::atomic_store_explicit(&snapshot_, std::move(published), std::memory_order_release);
+#endif
+}
+
+namespace {
+// No prey may appear twice or be a predator in the same batch
+[[maybe_unused]] bool is_valid_ingestion(std::span<const std::pair<index_t, index_t>> pairs)
+{
+	std::vector<index_t> prey(pairs.size());
+	std::transform(pairs.begin(), pairs.end(), prey.begin(), [](const auto& pair) { return pair.second; });
+	std::sort(prey.begin(), prey.end());
+
+	if (std::adjacent_find(prey.begin(), prey.end()) != prey.end())
+		return false;
+
+	return std::none_of(pairs.begin(), pairs.end(),
+						[&](const auto& pair) { return std::binary_search(prey.begin(), prey.end(), pair.first); });
+}
+} // namespace
+
+void microenvironment::ingest_agents(std::span<const std::pair<index_t, index_t>> predator_prey_pairs)
+{
+	assert(is_valid_ingestion(predator_prey_pairs) && "A prey must be unique and must not be a predator in the batch");
+
+	auto& data = generic_agent_solver<agent>().retrieve_agent_data(*agents);
+
+	// sorting by predator groups all prey of a predator together, so each predator is updated by a single thread
+	std::vector<std::pair<index_t, index_t>> pairs(predator_prey_pairs.begin(), predator_prey_pairs.end());
+	std::sort(pairs.begin(), pairs.end());
+
+	std::vector<index_t> segments;
+	for (index_t k = 0; k < pairs.size(); k++)
+		if (k == 0 || pairs[k].first != pairs[k - 1].first)
+			segments.push_back(k);
+	segments.push_back(pairs.size());
+
+	const index_t substrates = data.substrate_count;
+
+#pragma omp parallel for num_threads(get_team_size(context.get()))
+	for (index_t segment = 0; segment < segments.size() - 1; segment++)
+	{
+		real_t* predator_internalized =
+			data.internalized_substrates.data() + pairs[segments[segment]].first * substrates;
+
+		for (index_t k = segments[segment]; k < segments[segment + 1]; k++)
+		{
+			const index_t prey = pairs[k].second;
+
+			real_t* prey_internalized = data.internalized_substrates.data() + prey * substrates;
+			const parameter_t* fraction_transferred =
+				data.fraction_transferred_when_ingested.data() + data.parameters_row(prey) * substrates;
+
+			for (index_t s = 0; s < substrates; s++)
+			{
+				predator_internalized[s] += prey_internalized[s] * fraction_transferred[s];
+				prey_internalized[s] = 0;
+			}
+		}
+	}
+
+	std::vector<index_t> prey(pairs.size());
+	std::transform(pairs.begin(), pairs.end(), prey.begin(), [](const auto& pair) { return pair.second; });
+
+	agents->remove_many(prey);
+
+	if (solver)
+		solver->recompute_positional_data(*this);
+}
+
+namespace {
+std::uint64_t agent_morton_key(const cartesian_mesh& mesh, const real_t* positions, index_t agent)
+{
+	return morton_key(mesh.voxel_position(std::span<const real_t>(positions + agent * mesh.dims, mesh.dims)));
+}
+} // namespace
+
+void microenvironment::sort_agents_spatially()
+{
+	const auto& positions = generic_agent_solver<agent>().retrieve_agent_data(*agents).base_data.positions;
+	const index_t count = agents->size();
+
+	// ties keep their current order, so sorting is deterministic and an already sorted population stays in place
+	std::vector<std::pair<std::uint64_t, index_t>> keys(count);
+
+#pragma omp parallel for num_threads(get_team_size(context.get()))
+	for (index_t i = 0; i < count; i++)
+		keys[i] = { agent_morton_key(mesh, positions.data(), i), i };
+
+	// sorting and the permutation stay sequential, they run once every many timesteps, and inside run_steps on the
+	// single thread of the step callback
+	std::sort(keys.begin(), keys.end());
+
+	std::vector<index_t> order(count);
+	std::transform(keys.begin(), keys.end(), order.begin(), [](const auto& key) { return key.second; });
+
+	if (solver)
+		solver->prepare_agents_reorder(*this);
+
+	agents->permute(order);
+	timesteps_since_agents_sort_ = 0;
+
+	if (solver)
+		solver->recompute_positional_data(*this);
+}
+
+real_t microenvironment::measure_agents_disorder() const
+{
+	const auto& positions = generic_agent_solver<agent>().retrieve_agent_data(*agents).base_data.positions;
+	const index_t count = agents->size();
+
+	if (count < 2)
+		return 0;
+
+	index_t descents = 0;
+
+#pragma omp parallel for num_threads(get_team_size(context.get())) reduction(+ : descents)
+	for (index_t i = 1; i < count; i++)
+		if (agent_morton_key(mesh, positions.data(), i - 1) > agent_morton_key(mesh, positions.data(), i))
+			descents++;
+
+	return static_cast<real_t>(descents) / static_cast<real_t>(count - 1);
+}
+
+void microenvironment::sort_agents_if_due()
+{
+	timesteps_since_agents_sort_++;
+
+	const bool interval_due = agents_sort_interval != 0 && timesteps_since_agents_sort_ >= agents_sort_interval;
+
+	if (interval_due
+		|| (agents_sort_disorder_threshold > 0 && measure_agents_disorder() > agents_sort_disorder_threshold))
+		sort_agents_spatially();
+}
+
+void microenvironment::sample_substrate_densities(std::span<const real_t> positions, std::span<real_t> output,
+												  interpolation mode) const
+{
+	if (positions.size() % mesh.dims != 0)
+	{
+		throw std::runtime_error("Positions must contain mesh dims coordinates per point");
+	}
+
+	if (output.size() < positions.size() / mesh.dims * substrates_count)
+	{
+		throw std::runtime_error("Output is too small to hold all sampled densities");
+	}
+
+	solver->sample_substrate_densities(*this, positions, output, mode);
+}
+
+void microenvironment::sample_agent_substrate_densities(std::span<const index_t> agent_indices,
+														std::span<real_t> output, interpolation mode) const
+{
+	const auto& agent_positions = generic_agent_solver<agent>().retrieve_agent_data(*agents).base_data.positions;
+
+	std::vector<real_t> positions(agent_indices.size() * mesh.dims);
+
+#pragma omp parallel for num_threads(get_team_size(context.get()))
+	for (index_t i = 0; i < agent_indices.size(); i++)
+		for (index_t d = 0; d < mesh.dims; d++)
+			positions[i * mesh.dims + d] = agent_positions[agent_indices[i] * mesh.dims + d];
+
+	sample_substrate_densities(positions, output, mode);
+}
+
+std::span<const real_t> microenvironment::get_agent_gradients() const { return solver->get_agent_gradients(); }
+
+std::span<const real_t> microenvironment::get_gradient_field(index_t s, index_t dim)
+{
+	if (s >= substrates_count || dim >= mesh.dims)
+		throw std::runtime_error("Gradient field requested for a non-existent substrate or dimension");
+
+	gradient_fields_.resize(substrates_count * 3);
+
+	auto& [version, field] = gradient_fields_[s * 3 + dim];
+
+	if (version != densities_version_)
+	{
+		field.resize(mesh.voxel_count());
+		solver->compute_gradient_field(*this, s, dim, field);
+		version = densities_version_;
+	}
+
+	return field;
+}
+
+void microenvironment::release_gradient_field(index_t s, index_t dim)
+{
+	if (s * 3 + dim >= gradient_fields_.size())
+		return;
+
+	auto& [version, field] = gradient_fields_[s * 3 + dim];
+	version = 0;
+	field = {};
+}
+
+void microenvironment::invalidate_gradient_fields() { densities_version_++; }
+
 void microenvironment::print_info(std::ostream& os) const
 {
 	os << "Microenvironment config:" << std::endl;
@@ -109,6 +109,15 @@ void microenvironment_builder::set_bulk_functions(std::unique_ptr<bulk_functor>
 
 void microenvironment_builder::do_compute_internalized_substrates() { compute_internalized_substrates = true; }
 
+void microenvironment_builder::do_compute_gradients() { compute_gradients = true; }
+
+void microenvironment_builder::do_use_sparse_agent_interactions() { sparse_agent_interactions = true; }
+
+void microenvironment_builder::set_agents_memory_resource(std::pmr::memory_resource* resource)
+{
+	agents_resource = resource;
+}
+
 namespace {
 void fill_one(index_t dim_idx, index_t substrates_count, const std::vector<std::array<real_t, 3>>& values,
 			  const std::vector<std::array<bool, 3>>& conditions,
@@ -160,7 +169,7 @@ std::unique_ptr<microenvironment> microenvironment_builder::build()
 		throw std::runtime_error("Microenvironment cannot be built wit no densities");
 	}
 
-	auto m = std::make_unique<microenvironment>(*mesh, substrates_names.size(), timestep);
+	auto m = std::make_unique<microenvironment>(*mesh, substrates_names.size(), timestep, agents_resource);
 
 	m->name = std::move(name);
 	m->time_units = std::move(time_units);
@@ -195,6 +204,8 @@ std::unique_ptr<microenvironment> microenvironment_builder::build()
 	m->bulk_fnc = std::move(bulk_fnc);
 
 	m->compute_internalized_substrates = compute_internalized_substrates;
+	m->compute_gradients = compute_gradients;
+	m->sparse_agent_interactions = sparse_agent_interactions;
 
 	auto solver = solver_registry::instance().get(solver_name);
 
@@ -26,25 +26,25 @@ vtk_agents_serializer::vtk_agents_serializer(std::string_view output_dir, const
 	// Initialize substrate-related arrays (one array per substrate)
 	for (index_t i = 0; i < substrate_count; ++i)
 	{
-		auto secretion_array = vtkSmartPointer<vtkRealArray>::New();
+		auto secretion_array = vtkSmartPointer<vtkParameterArray>::New();
 		secretion_array->SetNumberOfComponents(1);
 		secretion_array->SetName((m.substrates_names[i] + "_secretion_rate").c_str());
 		secretion_rates_arrays.push_back(secretion_array);
 		unstructured_grid->GetPointData()->AddArray(secretion_array);
 
-		auto saturation_array = vtkSmartPointer<vtkRealArray>::New();
+		auto saturation_array = vtkSmartPointer<vtkParameterArray>::New();
 		saturation_array->SetNumberOfComponents(1);
 		saturation_array->SetName((m.substrates_names[i] + "_saturation_density").c_str());
 		saturation_densities_arrays.push_back(saturation_array);
 		unstructured_grid->GetPointData()->AddArray(saturation_array);
 
-		auto uptake_array = vtkSmartPointer<vtkRealArray>::New();
+		auto uptake_array = vtkSmartPointer<vtkParameterArray>::New();
 		uptake_array->SetNumberOfComponents(1);
 		uptake_array->SetName((m.substrates_names[i] + "_uptake_rate").c_str());
 		uptake_rates_arrays.push_back(uptake_array);
 		unstructured_grid->GetPointData()->AddArray(uptake_array);
 
-		auto net_export_array = vtkSmartPointer<vtkRealArray>::New();
+		auto net_export_array = vtkSmartPointer<vtkParameterArray>::New();
 		net_export_array->SetNumberOfComponents(1);
 		net_export_array->SetName((m.substrates_names[i] + "_net_export_rate").c_str());
 		net_export_rates_arrays.push_back(net_export_array);
@@ -56,13 +56,13 @@ vtk_agents_serializer::vtk_agents_serializer(std::string_view output_dir, const
 		internalized_substrates_arrays.push_back(internalized_array);
 		unstructured_grid->GetPointData()->AddArray(internalized_array);
 
-		auto fraction_released_array = vtkSmartPointer<vtkRealArray>::New();
+		auto fraction_released_array = vtkSmartPointer<vtkParameterArray>::New();
 		fraction_released_array->SetNumberOfComponents(1);
 		fraction_released_array->SetName((m.substrates_names[i] + "_fraction_released_at_death").c_str());
 		fraction_released_at_death_arrays.push_back(fraction_released_array);
 		unstructured_grid->GetPointData()->AddArray(fraction_released_array);
 
-		auto fraction_transferred_array = vtkSmartPointer<vtkRealArray>::New();
+		auto fraction_transferred_array = vtkSmartPointer<vtkParameterArray>::New();
 		fraction_transferred_array->SetNumberOfComponents(1);
 		fraction_transferred_array->SetName((m.substrates_names[i] + "_fraction_transferred_when_ingested").c_str());
 		fraction_transferred_when_ingested_arrays.push_back(fraction_transferred_array);
@@ -123,19 +123,23 @@ void vtk_agents_serializer::serialize(const microenvironment& m, real_t current_
 	{
 		volumes_array->SetValue(static_cast<vtkIdType>(i), biofvm_data.volumes[i]);
 
+		const index_t parameters_row = biofvm_data.parameters_row(i);
+
 		for (index_t s = 0; s < substrate_count; ++s)
 		{
 			const index_t idx = i * substrate_count + s;
-			secretion_rates_arrays[s]->SetValue(static_cast<vtkIdType>(i), biofvm_data.secretion_rates[idx]);
-			saturation_densities_arrays[s]->SetValue(static_cast<vtkIdType>(i), biofvm_data.saturation_densities[idx]);
-			uptake_rates_arrays[s]->SetValue(static_cast<vtkIdType>(i), biofvm_data.uptake_rates[idx]);
-			net_export_rates_arrays[s]->SetValue(static_cast<vtkIdType>(i), biofvm_data.net_export_rates[idx]);
+			const index_t p_idx = parameters_row * substrate_count + s;
+			secretion_rates_arrays[s]->SetValue(static_cast<vtkIdType>(i), biofvm_data.secretion_rates[p_idx]);
+			saturation_densities_arrays[s]->SetValue(static_cast<vtkIdType>(i),
+													 biofvm_data.saturation_densities[p_idx]);
+			uptake_rates_arrays[s]->SetValue(static_cast<vtkIdType>(i), biofvm_data.uptake_rates[p_idx]);
+			net_export_rates_arrays[s]->SetValue(static_cast<vtkIdType>(i), biofvm_data.net_export_rates[p_idx]);
 			internalized_substrates_arrays[s]->SetValue(static_cast<vtkIdType>(i),
 														biofvm_data.internalized_substrates[idx]);
 			fraction_released_at_death_arrays[s]->SetValue(static_cast<vtkIdType>(i),
-														   biofvm_data.fraction_released_at_death[idx]);
-			fraction_transferred_when_ingested_arrays[s]->SetValue(static_cast<vtkIdType>(i),
-																   biofvm_data.fraction_transferred_when_ingested[idx]);
+														   biofvm_data.fraction_released_at_death[p_idx]);
+			fraction_transferred_when_ingested_arrays[s]->SetValue(
+				static_cast<vtkIdType>(i), biofvm_data.fraction_transferred_when_ingested[p_idx]);
 		}
 	}
 
@@ -20,13 +20,14 @@ class vtk_agents_serializer : public vtk_serializer_base, public serializer, pri
 	vtkSmartPointer<vtkUnstructuredGrid> unstructured_grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
 
 	vtkSmartPointer<vtkRealArray> volumes_array;
-	std::vector<vtkSmartPointer<vtkRealArray>> secretion_rates_arrays;
-	std::vector<vtkSmartPointer<vtkRealArray>> saturation_densities_arrays;
-	std::vector<vtkSmartPointer<vtkRealArray>> uptake_rates_arrays;
-	std::vector<vtkSmartPointer<vtkRealArray>> net_export_rates_arrays;
+	// parameter columns are written in the precision they are stored in
+	std::vector<vtkSmartPointer<vtkParameterArray>> secretion_rates_arrays;
+	std::vector<vtkSmartPointer<vtkParameterArray>> saturation_densities_arrays;
+	std::vector<vtkSmartPointer<vtkParameterArray>> uptake_rates_arrays;
+	std::vector<vtkSmartPointer<vtkParameterArray>> net_export_rates_arrays;
 	std::vector<vtkSmartPointer<vtkRealArray>> internalized_substrates_arrays;
-	std::vector<vtkSmartPointer<vtkRealArray>> fraction_released_at_death_arrays;
-	std::vector<vtkSmartPointer<vtkRealArray>> fraction_transferred_when_ingested_arrays;
+	std::vector<vtkSmartPointer<vtkParameterArray>> fraction_released_at_death_arrays;
+	std::vector<vtkSmartPointer<vtkParameterArray>> fraction_transferred_when_ingested_arrays;
 
 	index_t substrate_count;
 
@@ -1,5 +1,6 @@
 #include "vtk_serializer.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <iomanip>
 #include <sstream>
@@ -53,15 +54,26 @@ vtk_serializer::vtk_serializer(std::string_view output_dir, microenvironment& m)
 
 void vtk_serializer::serialize(const microenvironment& m, real_t current_time)
 {
-	for (index_t z_idx = 0; z_idx < m.mesh.grid_shape[2]; ++z_idx)
-		for (index_t y_idx = 0; y_idx < m.mesh.grid_shape[1]; ++y_idx)
-			for (index_t x_idx = 0; x_idx < m.mesh.grid_shape[0]; ++x_idx)
-				for (index_t s_idx = 0; s_idx < m.substrates_count; ++s_idx)
-				{
-					const std::size_t voxel_idx = m.mesh.linearize(x_idx, y_idx, z_idx);
-					data_arrays[s_idx]->SetValue(static_cast<vtkIdType>(voxel_idx),
-												 m.get_substrate_density(s_idx, x_idx, y_idx, z_idx));
-				}
+	const auto field = m.get_substrate_field_view();
+
+	// copy the field row by row straight from the solver layout
+	for (index_t s_idx = 0; s_idx < m.substrates_count; ++s_idx)
+	{
+		real_t* values = data_arrays[s_idx]->GetPointer(0);
+
+		for (index_t z_idx = 0; z_idx < m.mesh.grid_shape[2]; ++z_idx)
+			for (index_t y_idx = 0; y_idx < m.mesh.grid_shape[1]; ++y_idx)
+			{
+				const real_t* row = &field(s_idx, 0, y_idx, z_idx);
+				real_t* out = values + m.mesh.linearize(0, y_idx, z_idx);
+
+				if (field.strides[1] == 1)
+					std::copy_n(row, m.mesh.grid_shape[0], out);
+				else
+					for (index_t x_idx = 0; x_idx < m.mesh.grid_shape[0]; ++x_idx)
+						out[x_idx] = row[x_idx * field.strides[1]];
+			}
+	}
 
 	std::ostringstream ss;
 
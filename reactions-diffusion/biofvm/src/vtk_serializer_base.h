@@ -11,6 +11,7 @@
 namespace physicore::biofvm {
 
 using vtkRealArray = std::conditional_t<std::is_same_v<real_t, float>, vtkFloatArray, vtkDoubleArray>;
+using vtkParameterArray = std::conditional_t<std::is_same_v<parameter_t, float>, vtkFloatArray, vtkDoubleArray>;
 
 class vtk_serializer_base
 {
@@ -34,8 +34,8 @@ TEST_F(AgentTest, SecretionRates)
 	// Test setting and getting values
 	rates[0] = 1.5;
 	rates[1] = 2.5;
-	EXPECT_EQ(test_agent.secretion_rates()[0], 1.5);
-	EXPECT_EQ(test_agent.secretion_rates()[1], 2.5);
+	EXPECT_EQ(test_agent.secretion_rates()[0], parameter_t(1.5));
+	EXPECT_EQ(test_agent.secretion_rates()[1], parameter_t(2.5));
 }
 
 TEST_F(AgentTest, SaturationDensities)
@@ -46,8 +46,8 @@ TEST_F(AgentTest, SaturationDensities)
 
 	densities[0] = 10.0;
 	densities[1] = 20.0;
-	EXPECT_EQ(test_agent.saturation_densities()[0], 10.0);
-	EXPECT_EQ(test_agent.saturation_densities()[1], 20.0);
+	EXPECT_EQ(test_agent.saturation_densities()[0], parameter_t(10.0));
+	EXPECT_EQ(test_agent.saturation_densities()[1], parameter_t(20.0));
 }
 
 TEST_F(AgentTest, UptakeRates)
@@ -58,8 +58,8 @@ TEST_F(AgentTest, UptakeRates)
 
 	rates[0] = 0.5;
 	rates[1] = 1.0;
-	EXPECT_EQ(test_agent.uptake_rates()[0], 0.5);
-	EXPECT_EQ(test_agent.uptake_rates()[1], 1.0);
+	EXPECT_EQ(test_agent.uptake_rates()[0], parameter_t(0.5));
+	EXPECT_EQ(test_agent.uptake_rates()[1], parameter_t(1.0));
 }
 
 TEST_F(AgentTest, NetExportRates)
@@ -70,8 +70,8 @@ TEST_F(AgentTest, NetExportRates)
 
 	rates[0] = 3.0;
 	rates[1] = 4.0;
-	EXPECT_EQ(test_agent.net_export_rates()[0], 3.0);
-	EXPECT_EQ(test_agent.net_export_rates()[1], 4.0);
+	EXPECT_EQ(test_agent.net_export_rates()[0], parameter_t(3.0));
+	EXPECT_EQ(test_agent.net_export_rates()[1], parameter_t(4.0));
 }
 
 TEST_F(AgentTest, InternalizedSubstrates)
@@ -94,8 +94,8 @@ TEST_F(AgentTest, FractionReleasedAtDeath)
 
 	fractions[0] = 0.75;
 	fractions[1] = 0.85;
-	EXPECT_EQ(test_agent.fraction_released_at_death()[0], 0.75);
-	EXPECT_EQ(test_agent.fraction_released_at_death()[1], 0.85);
+	EXPECT_EQ(test_agent.fraction_released_at_death()[0], parameter_t(0.75));
+	EXPECT_EQ(test_agent.fraction_released_at_death()[1], parameter_t(0.85));
 }
 
 TEST_F(AgentTest, FractionTransferredWhenIngested)
@@ -106,8 +106,8 @@ TEST_F(AgentTest, FractionTransferredWhenIngested)
 
 	fractions[0] = 0.25;
 	fractions[1] = 0.35;
-	EXPECT_EQ(test_agent.fraction_transferred_when_ingested()[0], 0.25);
-	EXPECT_EQ(test_agent.fraction_transferred_when_ingested()[1], 0.35);
+	EXPECT_EQ(test_agent.fraction_transferred_when_ingested()[0], parameter_t(0.25));
+	EXPECT_EQ(test_agent.fraction_transferred_when_ingested()[1], parameter_t(0.35));
 }
 
 TEST_F(AgentTest, Volume)
@@ -87,39 +87,39 @@ TEST_P(RemoveAgentTest, RemoveAgentsAndCheckProperties)
 	if (remove_idx != 0)
 	{
 		EXPECT_DOUBLE_EQ(agent0->volume(), 1.0);
-		EXPECT_DOUBLE_EQ(agent0->secretion_rates()[0], 0.1);
-		EXPECT_DOUBLE_EQ(agent0->saturation_densities()[0], 0.2);
-		EXPECT_DOUBLE_EQ(agent0->uptake_rates()[0], 0.3);
-		EXPECT_DOUBLE_EQ(agent0->net_export_rates()[0], 0.4);
+		EXPECT_DOUBLE_EQ(agent0->secretion_rates()[0], parameter_t(0.1));
+		EXPECT_DOUBLE_EQ(agent0->saturation_densities()[0], parameter_t(0.2));
+		EXPECT_DOUBLE_EQ(agent0->uptake_rates()[0], parameter_t(0.3));
+		EXPECT_DOUBLE_EQ(agent0->net_export_rates()[0], parameter_t(0.4));
 		EXPECT_DOUBLE_EQ(agent0->internalized_substrates()[0], 0.5);
-		EXPECT_DOUBLE_EQ(agent0->fraction_released_at_death()[0], 0.6);
-		EXPECT_DOUBLE_EQ(agent0->fraction_transferred_when_ingested()[0], 0.7);
+		EXPECT_DOUBLE_EQ(agent0->fraction_released_at_death()[0], parameter_t(0.6));
+		EXPECT_DOUBLE_EQ(agent0->fraction_transferred_when_ingested()[0], parameter_t(0.7));
 		EXPECT_DOUBLE_EQ(agent0->position()[0], 0.8);
 		EXPECT_EQ(agent0->is_active(), 10);
 	}
 	if (remove_idx != 1)
 	{
 		EXPECT_DOUBLE_EQ(agent1->volume(), 2.0);
-		EXPECT_DOUBLE_EQ(agent1->secretion_rates()[0], 1.1);
-		EXPECT_DOUBLE_EQ(agent1->saturation_densities()[0], 1.2);
-		EXPECT_DOUBLE_EQ(agent1->uptake_rates()[0], 1.3);
-		EXPECT_DOUBLE_EQ(agent1->net_export_rates()[0], 1.4);
+		EXPECT_DOUBLE_EQ(agent1->secretion_rates()[0], parameter_t(1.1));
+		EXPECT_DOUBLE_EQ(agent1->saturation_densities()[0], parameter_t(1.2));
+		EXPECT_DOUBLE_EQ(agent1->uptake_rates()[0], parameter_t(1.3));
+		EXPECT_DOUBLE_EQ(agent1->net_export_rates()[0], parameter_t(1.4));
 		EXPECT_DOUBLE_EQ(agent1->internalized_substrates()[0], 1.5);
-		EXPECT_DOUBLE_EQ(agent1->fraction_released_at_death()[0], 1.6);
-		EXPECT_DOUBLE_EQ(agent1->fraction_transferred_when_ingested()[0], 1.7);
+		EXPECT_DOUBLE_EQ(agent1->fraction_released_at_death()[0], parameter_t(1.6));
+		EXPECT_DOUBLE_EQ(agent1->fraction_transferred_when_ingested()[0], parameter_t(1.7));
 		EXPECT_DOUBLE_EQ(agent1->position()[0], 1.8);
 		EXPECT_EQ(agent1->is_active(), 11);
 	}
 	if (remove_idx != 2)
 	{
 		EXPECT_DOUBLE_EQ(agent2->volume(), 3.0);
-		EXPECT_DOUBLE_EQ(agent2->secretion_rates()[0], 2.1);
-		EXPECT_DOUBLE_EQ(agent2->saturation_densities()[0], 2.2);
-		EXPECT_DOUBLE_EQ(agent2->uptake_rates()[0], 2.3);
-		EXPECT_DOUBLE_EQ(agent2->net_export_rates()[0], 2.4);
+		EXPECT_DOUBLE_EQ(agent2->secretion_rates()[0], parameter_t(2.1));
+		EXPECT_DOUBLE_EQ(agent2->saturation_densities()[0], parameter_t(2.2));
+		EXPECT_DOUBLE_EQ(agent2->uptake_rates()[0], parameter_t(2.3));
+		EXPECT_DOUBLE_EQ(agent2->net_export_rates()[0], parameter_t(2.4));
 		EXPECT_DOUBLE_EQ(agent2->internalized_substrates()[0], 2.5);
-		EXPECT_DOUBLE_EQ(agent2->fraction_released_at_death()[0], 2.6);
-		EXPECT_DOUBLE_EQ(agent2->fraction_transferred_when_ingested()[0], 2.7);
+		EXPECT_DOUBLE_EQ(agent2->fraction_released_at_death()[0], parameter_t(2.6));
+		EXPECT_DOUBLE_EQ(agent2->fraction_transferred_when_ingested()[0], parameter_t(2.7));
 		EXPECT_DOUBLE_EQ(agent2->position()[0], 2.8);
 		EXPECT_EQ(agent2->is_active(), 12);
 	}
@@ -151,19 +151,19 @@ TEST(AgentContainerTest, GetAgentAt)
 	auto* retrieved0 = container.get_agent_at(0);
 	ASSERT_NE(retrieved0, nullptr);
 	EXPECT_DOUBLE_EQ(retrieved0->volume(), 1.5);
-	EXPECT_DOUBLE_EQ(retrieved0->secretion_rates()[0], 0.1);
+	EXPECT_DOUBLE_EQ(retrieved0->secretion_rates()[0], parameter_t(0.1));
 	EXPECT_EQ(retrieved0, agent0);
 
 	auto* retrieved1 = container.get_agent_at(1);
 	ASSERT_NE(retrieved1, nullptr);
 	EXPECT_DOUBLE_EQ(retrieved1->volume(), 2.5);
-	EXPECT_DOUBLE_EQ(retrieved1->secretion_rates()[0], 0.2);
+	EXPECT_DOUBLE_EQ(retrieved1->secretion_rates()[0], parameter_t(0.2));
 	EXPECT_EQ(retrieved1, agent1);
 
 	auto* retrieved2 = container.get_agent_at(2);
 	ASSERT_NE(retrieved2, nullptr);
 	EXPECT_DOUBLE_EQ(retrieved2->volume(), 3.5);
-	EXPECT_DOUBLE_EQ(retrieved2->secretion_rates()[0], 0.3);
+	EXPECT_DOUBLE_EQ(retrieved2->secretion_rates()[0], parameter_t(0.3));
 	EXPECT_EQ(retrieved2, agent2);
 
 #ifdef NDEBUG
@@ -172,3 +172,170 @@ TEST(AgentContainerTest, GetAgentAt)
 	EXPECT_EQ(container.get_agent_at(std::numeric_limits<index_t>::max()), nullptr);
 #endif
 }
+
+TEST(AgentContainerTest, CreateN)
+{
+	agent_container container = make_agent_container();
+	container.create();
+
+	container.reserve(6);
+	const auto* positions = std::get<0>(container.agent_datas)->positions.data();
+	const auto* volumes = std::get<1>(container.agent_datas)->volumes.data();
+
+	auto indices = container.create_n(5);
+
+	ASSERT_EQ(indices.size(), 5);
+	EXPECT_EQ(indices.front(), 1);
+	EXPECT_EQ(indices.back(), 5);
+	EXPECT_EQ(container.size(), 6);
+
+	// reserved storage is not reallocated
+	EXPECT_EQ(std::get<0>(container.agent_datas)->positions.data(), positions);
+	EXPECT_EQ(std::get<1>(container.agent_datas)->volumes.data(), volumes);
+
+	for (index_t i : indices)
+	{
+		auto* a = container.get_agent_at(i);
+		ASSERT_NE(a, nullptr);
+		EXPECT_EQ(a->is_active(), 1);
+		EXPECT_DOUBLE_EQ(a->fraction_transferred_when_ingested()[0], parameter_t(1.0));
+
+		a->volume() = static_cast<real_t>(i);
+	}
+
+	container.remove_at(1);
+
+	EXPECT_EQ(container.size(), 5);
+	EXPECT_DOUBLE_EQ(container.get_agent_at(1)->volume(), 5.0);
+}
+
+TEST(AgentContainerTest, RemoveManyMovesAllProperties)
+{
+	agent_container container = make_agent_container();
+
+	for (index_t i : container.create_n(6))
+	{
+		auto* a = container.get_agent_at(i);
+		const auto value = static_cast<real_t>(i);
+
+		a->volume() = value;
+		a->secretion_rates()[0] = value + 0.1;
+		a->saturation_densities()[0] = value + 0.2;
+		a->uptake_rates()[0] = value + 0.3;
+		a->net_export_rates()[0] = value + 0.4;
+		a->internalized_substrates()[0] = value + 0.5;
+		a->fraction_released_at_death()[0] = value + 0.6;
+		a->fraction_transferred_when_ingested()[0] = value + 0.7;
+		a->position()[2] = value + 0.8;
+		a->is_active() = static_cast<uint8_t>(i);
+	}
+
+	const std::vector<index_t> removed = { 0, 4 };
+	container.remove_many(removed);
+
+	ASSERT_EQ(container.size(), 4);
+	EXPECT_EQ(std::get<1>(container.agent_datas)->agents_count, 4);
+	EXPECT_EQ(std::get<1>(container.agent_datas)->secretion_rates.size(), 4);
+	EXPECT_EQ(std::get<1>(container.agent_datas)->is_active.size(), 4);
+
+	std::vector<real_t> volumes;
+	for (index_t i = 0; i < container.size(); ++i)
+	{
+		auto* a = container.get_agent_at(i);
+		const real_t value = a->volume();
+
+		EXPECT_DOUBLE_EQ(a->secretion_rates()[0], parameter_t(value + 0.1));
+		EXPECT_DOUBLE_EQ(a->saturation_densities()[0], parameter_t(value + 0.2));
+		EXPECT_DOUBLE_EQ(a->uptake_rates()[0], parameter_t(value + 0.3));
+		EXPECT_DOUBLE_EQ(a->net_export_rates()[0], parameter_t(value + 0.4));
+		EXPECT_DOUBLE_EQ(a->internalized_substrates()[0], value + 0.5);
+		EXPECT_DOUBLE_EQ(a->fraction_released_at_death()[0], parameter_t(value + 0.6));
+		EXPECT_DOUBLE_EQ(a->fraction_transferred_when_ingested()[0], parameter_t(value + 0.7));
+		EXPECT_DOUBLE_EQ(a->position()[2], value + 0.8);
+		EXPECT_EQ(a->is_active(), static_cast<uint8_t>(value));
+
+		volumes.push_back(value);
+	}
+
+	// the last survivor fills the first hole
+	EXPECT_EQ(volumes, (std::vector<real_t> { 5, 1, 2, 3 }));
+}
+
+TEST(AgentContainerTest, SharedParameters)
+{
+	agent_container container = make_agent_container();
+	auto& data = *std::get<1>(container.agent_datas);
+
+	data.use_shared_parameters(2);
+	data.secretion_rates[1] = 10;
+	data.fraction_released_at_death[1] = 0.5;
+
+	for (index_t i : container.create_n(4))
+		data.parameter_rows[i] = i % 2;
+
+	EXPECT_EQ(data.parameters_count(), 2);
+	EXPECT_EQ(data.secretion_rates.size(), 2);
+	EXPECT_EQ(data.internalized_substrates.size(), 4);
+	EXPECT_DOUBLE_EQ(container.get_agent_at(3)->secretion_rates()[0], parameter_t(10));
+	EXPECT_DOUBLE_EQ(container.get_agent_at(3)->fraction_released_at_death()[0], parameter_t(0.5));
+	EXPECT_DOUBLE_EQ(container.get_agent_at(2)->fraction_transferred_when_ingested()[0], parameter_t(1));
+
+	// writes through an agent change its whole type
+	container.get_agent_at(2)->uptake_rates()[0] = 3;
+	EXPECT_DOUBLE_EQ(container.get_agent_at(0)->uptake_rates()[0], parameter_t(3));
+
+	// until the agent gets parameters of its own
+	EXPECT_EQ(data.override_parameters(2), 2);
+	container.get_agent_at(2)->uptake_rates()[0] = 7;
+	EXPECT_DOUBLE_EQ(container.get_agent_at(0)->uptake_rates()[0], parameter_t(3));
+	EXPECT_DOUBLE_EQ(container.get_agent_at(2)->uptake_rates()[0], parameter_t(7));
+
+	const std::vector<index_t> removed = { 0 };
+	container.remove_many(removed);
+
+	ASSERT_EQ(container.size(), 3);
+	EXPECT_TRUE(std::ranges::equal(data.parameter_rows, std::vector<index_t> { 1, 1, 2 }));
+	EXPECT_EQ(data.column<columns::uptake_rates>().size(), 3);
+	EXPECT_DOUBLE_EQ(container.get_agent_at(2)->uptake_rates()[0], parameter_t(7));
+
+	EXPECT_THROW(data.use_shared_parameters(1), std::runtime_error);
+}
+
+TEST(AgentContainerTest, SharedParameterTypes)
+{
+	agent_container container = make_agent_container();
+	auto& data = *std::get<1>(container.agent_datas);
+
+	data.use_shared_parameters(2);
+	data.secretion_rates[1] = 10;
+
+	container.create_n(4);
+	container.get_agent_at(1)->set_type(1);
+	EXPECT_DOUBLE_EQ(container.get_agent_at(1)->secretion_rates()[0], parameter_t(10));
+	EXPECT_THROW(container.get_agent_at(1)->set_type(2), std::runtime_error);
+
+	EXPECT_EQ(data.override_parameters(0), 2);
+	EXPECT_EQ(data.override_parameters(2), 3);
+	EXPECT_EQ(data.override_parameters(3), 4);
+	container.get_agent_at(3)->secretion_rates()[0] = 7;
+
+	// the rows of agent 0, set back to a type, and of the removed agent 2 are no longer referenced
+	container.get_agent_at(0)->set_type(1);
+	const std::vector<index_t> removed = { 2 };
+	container.remove_many(removed, true);
+
+	data.compact_parameters();
+
+	ASSERT_EQ(data.parameters_count(), 3);
+	EXPECT_TRUE(std::ranges::equal(data.parameter_rows, std::vector<index_t> { 1, 1, 2 }));
+	EXPECT_DOUBLE_EQ(container.get_agent_at(2)->secretion_rates()[0], parameter_t(7));
+	EXPECT_DOUBLE_EQ(container.get_agent_at(0)->secretion_rates()[0], parameter_t(10));
+}
+
+TEST(AgentContainerTest, TypesRequireSharedParameters)
+{
+	agent_container container = make_agent_container();
+
+	container.create();
+	EXPECT_THROW(container.get_agent_at(0)->set_type(0), std::runtime_error);
+}
@@ -1,6 +1,11 @@
+#include <algorithm>
+#include <memory_resource>
+
 #include <common/base_agent_data.h>
+#include <common/storage_policies.h>
 #include <gtest/gtest.h>
 
+#include "agent.h"
 #include "agent_data.h"
 
 using namespace physicore::biofvm;
@@ -107,3 +112,125 @@ TEST(AgentDataTest, RemoveShrinksVectorsCorrectly)
 	EXPECT_EQ(data.volumes.size(), expected_size);
 	EXPECT_EQ(data.is_active.size(), expected_size);
 }
+
+TEST(AgentDataTest, AddCountInitializesVectorsCorrectly)
+{
+	base_agent_data base = make_base_agent_data(0);
+	const index_t substrate_count = 2;
+	agent_data data(base, substrate_count);
+
+	data.add(4);
+
+	EXPECT_EQ(data.agents_count, 4);
+	EXPECT_EQ(data.secretion_rates.size(), substrate_count * 4);
+	EXPECT_EQ(data.internalized_substrates.size(), substrate_count * 4);
+	EXPECT_EQ(data.volumes.size(), 4);
+	EXPECT_TRUE(
+		std::ranges::equal(data.fraction_transferred_when_ingested, std::vector<parameter_t>(substrate_count * 4, 1)));
+	EXPECT_TRUE(std::ranges::equal(data.is_active, std::vector<uint8_t>(4, 1)));
+
+	data.reserve(1000);
+	const auto* volumes = data.volumes.data();
+
+	for (index_t i = 4; i < 1000; ++i)
+		data.add();
+
+	EXPECT_EQ(data.agents_count, 1000);
+	EXPECT_EQ(data.volumes.data(), volumes);
+	EXPECT_EQ(data.net_export_rates.size(), substrate_count * 1000);
+}
+
+TEST(AgentDataTest, ColumnViews)
+{
+	base_agent_data base = make_base_agent_data(0);
+	const index_t substrate_count = 2;
+	agent_data data(base, substrate_count);
+
+	base.add(3);
+	data.add(3);
+
+	auto secretion = data.column<columns::secretion_rates>();
+	auto volumes = data.column<columns::volumes>();
+
+	ASSERT_EQ(secretion.size(), 3);
+	EXPECT_EQ(secretion.width(), substrate_count);
+	ASSERT_EQ(volumes.size(), 3);
+
+	for (auto [rates, volume, position] : zip_columns(secretion, volumes, base.column<columns::positions>()))
+	{
+		volume = 2.0;
+		rates[1] = volume * 3;
+		position[2] = rates[1];
+	}
+
+	EXPECT_TRUE(std::ranges::equal(data.secretion_rates, std::vector<parameter_t> { 0, 6, 0, 6, 0, 6 }));
+	EXPECT_TRUE(std::ranges::equal(data.volumes, std::vector<real_t> { 2, 2, 2 }));
+	EXPECT_EQ(base.positions[8], 6.0);
+
+	EXPECT_EQ(data.column<columns::is_active>()[2], 1);
+	EXPECT_EQ(data.column<columns::fraction_transferred_when_ingested>()[1][0], 1.0);
+}
+
+TEST(AgentDataTest, RefreshActiveIndices)
+{
+	base_agent_data base = make_base_agent_data(0);
+	agent_data data(base, 1);
+
+	data.add(5);
+	data.refresh_active_indices();
+
+	EXPECT_TRUE(std::ranges::equal(data.active_indices, std::vector<index_t> { 0, 1, 2, 3, 4 }));
+
+	data.is_active[0] = 0;
+	data.is_active[3] = 0;
+	data.refresh_active_indices();
+
+	EXPECT_TRUE(std::ranges::equal(data.active_indices, std::vector<index_t> { 1, 2, 4 }));
+
+	data.remove_at(4);
+	data.refresh_active_indices();
+
+	EXPECT_TRUE(std::ranges::equal(data.active_indices, std::vector<index_t> { 1, 2 }));
+}
+
+TEST(AgentDataTest, ActiveIndicesDirty)
+{
+	base_agent_data base = make_base_agent_data(2);
+	agent_data data(base, 1);
+
+	data.add(2);
+	EXPECT_TRUE(data.active_indices_dirty.load());
+
+	data.refresh_active_indices();
+	EXPECT_FALSE(data.active_indices_dirty.load());
+
+	// the accessor hands out a writable reference
+	agent a(1, data);
+	a.is_active() = 0;
+	EXPECT_TRUE(data.active_indices_dirty.load());
+
+	data.refresh_active_indices();
+	EXPECT_TRUE(std::ranges::equal(data.active_indices, std::vector<index_t> { 0 }));
+
+	data.refresh_active_indices();
+	data.remove_at(0);
+	EXPECT_TRUE(data.active_indices_dirty.load());
+}
+
+TEST(AgentDataTest, ArenaColumnsUseGivenResource)
+{
+	std::pmr::monotonic_buffer_resource arena;
+
+	base_agent_data_generic_storage<arena_vector> base(3, &arena);
+	agent_data_generic_storage<arena_vector> data(base, 2, &arena);
+
+	base.add(2);
+	data.add(2);
+	data.refresh_active_indices();
+
+	EXPECT_EQ(data.secretion_rates.get_allocator().resource(), &arena);
+	EXPECT_EQ(data.internalized_substrates.get_allocator().resource(), &arena);
+	EXPECT_EQ(data.is_active.get_allocator().resource(), &arena);
+	EXPECT_EQ(data.active_indices.get_allocator().resource(), &arena);
+	EXPECT_EQ(data.parameter_rows.get_allocator().resource(), &arena);
+}
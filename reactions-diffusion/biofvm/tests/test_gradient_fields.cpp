@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "microenvironment.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+namespace {
+// Fills gradient fields with the number of fields computed so far
+class counting_solver : public solver
+{
+public:
+	index_t computed_fields = 0;
+
+	void initialize(microenvironment& /*m*/) override {}
+	void solve(microenvironment& /*m*/, index_t /*iterations*/) override {}
+	real_t get_substrate_density(index_t /*s*/, index_t /*x*/, index_t /*y*/, index_t /*z*/) const override
+	{
+		return 0;
+	}
+	real_t& get_substrate_density(index_t /*s*/, index_t /*x*/, index_t /*y*/, index_t /*z*/) override
+	{
+		static real_t dummy = 0;
+		return dummy;
+	}
+	void sample_substrate_densities(const microenvironment& /*m*/, std::span<const real_t> /*positions*/,
+									std::span<real_t> /*output*/, interpolation /*mode*/) override
+	{}
+	void compute_gradient_field(const microenvironment& /*m*/, index_t /*s*/, index_t /*dim*/,
+								std::span<real_t> output) override
+	{
+		computed_fields++;
+		std::fill(output.begin(), output.end(), (real_t)computed_fields);
+	}
+	substrate_field_view get_substrate_field_view() const override { return {}; }
+	void reinitialize_dirichlet(microenvironment& /*m*/) override {}
+	void recompute_positional_data(microenvironment& /*m*/) override {}
+};
+} // namespace
+
+TEST(GradientFieldsTest, CachedUntilDensitiesChange)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 40, 0 }, { 20, 20, 20 });
+	microenvironment m(mesh, 2, 0.01);
+
+	auto solver = std::make_unique<counting_solver>();
+	auto* s = solver.get();
+	m.solver = std::move(solver);
+
+	auto field = m.get_gradient_field(1, 0);
+	ASSERT_EQ(field.size(), 6U);
+	EXPECT_EQ(field[0], 1);
+
+	// repeated requests within a timestep are free
+	EXPECT_EQ(m.get_gradient_field(1, 0)[0], 1);
+	EXPECT_EQ(s->computed_fields, 1U);
+
+	// other fields are computed separately
+	EXPECT_EQ(m.get_gradient_field(0, 1)[0], 2);
+	EXPECT_EQ(s->computed_fields, 2U);
+
+	m.run_single_timestep();
+
+	EXPECT_EQ(m.get_gradient_field(1, 0)[0], 3);
+	EXPECT_EQ(m.get_gradient_field(1, 0)[0], 3);
+
+	m.invalidate_gradient_fields();
+
+	EXPECT_EQ(m.get_gradient_field(1, 0)[0], 4);
+
+	m.release_gradient_field(1, 0);
+
+	EXPECT_EQ(m.get_gradient_field(1, 0)[0], 5);
+	EXPECT_EQ(s->computed_fields, 5U);
+}
+
+TEST(GradientFieldsTest, InvalidRequest)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 40, 0 }, { 20, 20, 20 });
+	microenvironment m(mesh, 2, 0.01);
+
+	m.solver = std::make_unique<counting_solver>();
+
+	EXPECT_THROW(m.get_gradient_field(2, 0), std::runtime_error);
+	EXPECT_THROW(m.get_gradient_field(0, 2), std::runtime_error);
+}
@@ -0,0 +1,53 @@
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include "agent_container.h"
+#include "microenvironment.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+TEST(IngestionTest, TransfersScaledSubstratesAndRemovesPrey)
+{
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 60, 20, 20 }, { 20, 20, 20 });
+	microenvironment m(mesh, 2, 0.01);
+
+	std::vector<agent_interface*> agents;
+	for (index_t i = 0; i < 5; i++)
+	{
+		auto* a = m.agents->create();
+		a->internalized_substrates()[0] = static_cast<real_t>(10 * (i + 1));
+		a->internalized_substrates()[1] = static_cast<real_t>(100 * (i + 1));
+		a->fraction_transferred_when_ingested()[0] = 0.5;
+		agents.push_back(a);
+	}
+
+	// agent 0 eats agents 3 and 4, agent 2 eats agent 1
+	const std::vector<std::pair<index_t, index_t>> pairs = { { 0, 4 }, { 2, 1 }, { 0, 3 } };
+
+	m.ingest_agents(pairs);
+
+	ASSERT_EQ(m.agents->size(), 2U);
+
+	EXPECT_DOUBLE_EQ(agents[0]->internalized_substrates()[0], 10 + 0.5 * (40 + 50));
+	EXPECT_DOUBLE_EQ(agents[0]->internalized_substrates()[1], 100 + 400 + 500);
+
+	EXPECT_DOUBLE_EQ(agents[2]->internalized_substrates()[0], 30 + 0.5 * 20);
+	EXPECT_DOUBLE_EQ(agents[2]->internalized_substrates()[1], 300 + 200);
+
+	const std::set<agent_interface*> survivors = { m.agents->get_agent_at(0), m.agents->get_agent_at(1) };
+	EXPECT_EQ(survivors, (std::set<agent_interface*> { agents[0], agents[2] }));
+}
+
+TEST(IngestionTest, EmptyBatch)
+{
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 60, 20, 20 }, { 20, 20, 20 });
+	microenvironment m(mesh, 1, 0.01);
+
+	m.agents->create();
+
+	m.ingest_agents({});
+
+	EXPECT_EQ(m.agents->size(), 1U);
+}
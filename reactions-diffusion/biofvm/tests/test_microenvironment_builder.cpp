@@ -200,6 +200,22 @@ TEST(MicroenvironmentBuilder, BulkFunctionsAndInternalizedSubstrates)
 	ASSERT_EQ(ret, 42);
 }
 
+TEST(MicroenvironmentBuilder, ComputeGradients)
+{
+	microenvironment_builder builder;
+	builder.add_density("O2", "mmHg", 1.0, 0.01, 20.0);
+	builder.resize(3, { 0, 0, 0 }, { 10, 10, 10 }, { 1, 1, 1 });
+
+	EXPECT_FALSE(builder.build()->compute_gradients);
+
+	microenvironment_builder gradients_builder;
+	gradients_builder.add_density("O2", "mmHg", 1.0, 0.01, 20.0);
+	gradients_builder.resize(3, { 0, 0, 0 }, { 10, 10, 10 }, { 1, 1, 1 });
+	gradients_builder.do_compute_gradients();
+
+	EXPECT_TRUE(gradients_builder.build()->compute_gradients);
+}
+
 TEST(MicroenvironmentBuilder, BuildThrows)
 {
 	microenvironment_builder builder;
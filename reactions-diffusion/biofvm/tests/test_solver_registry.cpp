@@ -20,6 +20,13 @@ public:
 		static real_t dummy = 0;
 		return dummy;
 	}
+	void sample_substrate_densities(const microenvironment& /*m*/, std::span<const real_t> /*positions*/,
+									std::span<real_t> /*output*/, interpolation /*mode*/) override
+	{}
+	void compute_gradient_field(const microenvironment& /*m*/, index_t /*s*/, index_t /*dim*/,
+								std::span<real_t> /*output*/) override
+	{}
+	substrate_field_view get_substrate_field_view() const override { return {}; }
 	void reinitialize_dirichlet(microenvironment& /*m*/) override {}
 	void recompute_positional_data(microenvironment& /*m*/) override {}
 };
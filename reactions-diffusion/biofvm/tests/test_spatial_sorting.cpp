@@ -0,0 +1,166 @@
+#include <vector>
+
+#include <common/morton.h>
+#include <gtest/gtest.h>
+
+#include "microenvironment.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+namespace {
+// Solves nothing, counts how often positional data had to be recomputed
+class counting_solver : public solver
+{
+	real_t density_ = 0;
+
+public:
+	index_t recomputes = 0;
+
+	void initialize(microenvironment& /*m*/) override {}
+	void solve(microenvironment& /*m*/, index_t /*iterations*/) override {}
+	real_t get_substrate_density(index_t /*s*/, index_t /*x*/, index_t /*y*/, index_t /*z*/) const override
+	{
+		return density_;
+	}
+	real_t& get_substrate_density(index_t /*s*/, index_t /*x*/, index_t /*y*/, index_t /*z*/) override
+	{
+		return density_;
+	}
+	substrate_field_view get_substrate_field_view() const override { return {}; }
+	void sample_substrate_densities(const microenvironment& /*m*/, std::span<const real_t> /*positions*/,
+									std::span<real_t> /*output*/, interpolation /*mode*/) override
+	{}
+	void compute_gradient_field(const microenvironment& /*m*/, index_t /*s*/, index_t /*dim*/,
+								std::span<real_t> /*output*/) override
+	{}
+	void reinitialize_dirichlet(microenvironment& /*m*/) override {}
+	void recompute_positional_data(microenvironment& /*m*/) override { recomputes++; }
+};
+
+// Agents on the diagonal of an 8x8 mesh of 10x10 voxels, created from the far corner
+std::vector<agent_interface*> make_reversed_agents(microenvironment& m)
+{
+	std::vector<agent_interface*> agents;
+
+	for (index_t i = 0; i < 8; i++)
+	{
+		auto* a = m.agents->create();
+		a->position()[0] = static_cast<real_t>(75 - 10 * i);
+		a->position()[1] = static_cast<real_t>(75 - 10 * i);
+		a->volume() = static_cast<real_t>(i);
+		agents.push_back(a);
+	}
+
+	return agents;
+}
+} // namespace
+
+TEST(SpatialSortingTest, MortonKeys)
+{
+	EXPECT_EQ(morton_key({ 0, 0, 0 }), 0U);
+	EXPECT_EQ(morton_key({ 1, 0, 0 }), 1U);
+	EXPECT_EQ(morton_key({ 0, 1, 0 }), 2U);
+	EXPECT_EQ(morton_key({ 0, 0, 1 }), 4U);
+	EXPECT_EQ(morton_key({ 3, 3, 3 }), 63U);
+	EXPECT_EQ(morton_key({ 2, 0, 0 }), 8U);
+	EXPECT_EQ(morton_key({ 0x1fffff, 0x1fffff, 0x1fffff }), (std::uint64_t(1) << 63) - 1);
+}
+
+TEST(SpatialSortingTest, SortsAlongMortonCurve)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 80, 80, 0 }, { 10, 10, 10 });
+	microenvironment m(mesh, 1, 0.01);
+
+	auto agents = make_reversed_agents(m);
+	EXPECT_DOUBLE_EQ(m.measure_agents_disorder(), 1.0);
+
+	m.sort_agents_spatially();
+
+	EXPECT_DOUBLE_EQ(m.measure_agents_disorder(), 0.0);
+
+	for (index_t i = 0; i < 8; i++)
+	{
+		// handles follow their agents to the reversed positions
+		EXPECT_EQ(m.agents->get_agent_at(i), agents[7 - i]);
+		EXPECT_DOUBLE_EQ(m.agents->get_agent_at(i)->volume(), static_cast<real_t>(7 - i));
+		EXPECT_DOUBLE_EQ(m.agents->get_agent_at(i)->position()[0], static_cast<real_t>(5 + 10 * i));
+	}
+}
+
+TEST(SpatialSortingTest, SortsEveryInterval)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 80, 80, 0 }, { 10, 10, 10 });
+	microenvironment m(mesh, 1, 0.01);
+	auto s = std::make_unique<counting_solver>();
+	auto* solver = s.get();
+	m.solver = std::move(s);
+
+	make_reversed_agents(m);
+
+	m.run_single_timestep();
+	EXPECT_EQ(solver->recomputes, 0);
+	EXPECT_EQ(m.get_timestep_access().writes.count("volumes"), 0);
+
+	m.agents_sort_interval = 2;
+	EXPECT_EQ(m.get_timestep_access().writes.count("volumes"), 1);
+
+	m.run_single_timestep();
+	EXPECT_EQ(solver->recomputes, 1);
+	EXPECT_DOUBLE_EQ(m.measure_agents_disorder(), 0.0);
+
+	m.run_single_timestep();
+	EXPECT_EQ(solver->recomputes, 1);
+	m.run_single_timestep();
+	EXPECT_EQ(solver->recomputes, 2);
+}
+
+TEST(SpatialSortingTest, SortsWhenDisordered)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 80, 80, 0 }, { 10, 10, 10 });
+	microenvironment m(mesh, 1, 0.01);
+	auto s = std::make_unique<counting_solver>();
+	auto* solver = s.get();
+	m.solver = std::move(s);
+
+	make_reversed_agents(m);
+	m.agents_sort_disorder_threshold = 0.5;
+
+	m.run_single_timestep();
+	EXPECT_EQ(solver->recomputes, 1);
+
+	// sorted agents stay in place
+	m.run_single_timestep();
+	EXPECT_EQ(solver->recomputes, 1);
+}
+
+TEST(SpatialSortingTest, SortsBetweenBatchedSteps)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 80, 80, 0 }, { 10, 10, 10 });
+	microenvironment m(mesh, 1, 0.01);
+	auto s = std::make_unique<counting_solver>();
+	auto* solver = s.get();
+	m.solver = std::move(s);
+
+	auto agents = make_reversed_agents(m);
+	m.agents_sort_interval = 2;
+
+	std::vector<real_t> disorder_after_step;
+	m.run_steps(4, [&](index_t /*step*/) {
+		disorder_after_step.push_back(m.measure_agents_disorder());
+
+		// reverse the agents again after the first sort, so the second one has work to do
+		if (disorder_after_step.size() == 2)
+			for (index_t i = 0; i < 8; i++)
+			{
+				m.agents->get_agent_at(i)->position()[0] = static_cast<real_t>(75 - 10 * i);
+				m.agents->get_agent_at(i)->position()[1] = static_cast<real_t>(75 - 10 * i);
+			}
+	});
+
+	EXPECT_EQ(disorder_after_step, (std::vector<real_t> { 1.0, 0.0, 1.0, 0.0 }));
+	EXPECT_EQ(solver->recomputes, 2);
+
+	for (index_t i = 0; i < 8; i++)
+		EXPECT_EQ(m.agents->get_agent_at(i), agents[i]);
+}
@@ -0,0 +1,164 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "microenvironment.h"
+
+using namespace physicore;
+using namespace physicore::biofvm;
+
+namespace {
+// Keeps dense densities, each solve adds 1 to all of them
+class incrementing_solver : public solver
+{
+	std::array<index_t, 4> extents_;
+	std::vector<real_t> densities_;
+
+public:
+	explicit incrementing_solver(const microenvironment& m)
+		: extents_ { m.substrates_count, m.mesh.grid_shape[0], m.mesh.grid_shape[1], m.mesh.grid_shape[2] },
+		  densities_(m.substrates_count * m.mesh.voxel_count(), 0)
+	{
+		for (std::size_t i = 0; i < densities_.size(); i++)
+			densities_[i] = (real_t)i;
+	}
+
+	void initialize(microenvironment& /*m*/) override {}
+	void solve(microenvironment& /*m*/, index_t iterations) override
+	{
+		for (auto& d : densities_)
+			d += (real_t)iterations;
+	}
+	real_t get_substrate_density(index_t s, index_t x, index_t y, index_t z) const override
+	{
+		return get_substrate_field_view()(s, x, y, z);
+	}
+	real_t& get_substrate_density(index_t /*s*/, index_t /*x*/, index_t /*y*/, index_t /*z*/) override
+	{
+		return densities_[0];
+	}
+	substrate_field_view get_substrate_field_view() const override
+	{
+		// x varying fastest, substrates slowest
+		const index_t y_stride = extents_[1];
+		const index_t z_stride = y_stride * extents_[2];
+		return { densities_.data(), extents_, { z_stride * extents_[3], 1, y_stride, z_stride } };
+	}
+	void sample_substrate_densities(const microenvironment& /*m*/, std::span<const real_t> /*positions*/,
+									std::span<real_t> /*output*/, interpolation /*mode*/) override
+	{}
+	void compute_gradient_field(const microenvironment& /*m*/, index_t /*s*/, index_t /*dim*/,
+								std::span<real_t> /*output*/) override
+	{}
+	void reinitialize_dirichlet(microenvironment& /*m*/) override {}
+	void recompute_positional_data(microenvironment& /*m*/) override {}
+};
+} // namespace
+
+TEST(SubstrateSnapshotTest, PublishedAfterEachTimestep)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 40, 0 }, { 20, 20, 20 });
+	microenvironment m(mesh, 2, 0.01);
+	m.solver = std::make_unique<incrementing_solver>(m);
+
+	EXPECT_EQ(m.get_substrate_snapshot(), nullptr);
+
+	m.run_single_timestep();
+	EXPECT_EQ(m.get_substrate_snapshot(), nullptr);
+
+	m.publish_snapshots = true;
+	m.run_single_timestep();
+
+	auto first = m.get_substrate_snapshot();
+	ASSERT_NE(first, nullptr);
+	EXPECT_EQ(first->epoch, 0U);
+	EXPECT_EQ(first->densities.size(), 12U);
+
+	const auto view = first->view();
+	for (index_t s = 0; s < 2; s++)
+		for (index_t y = 0; y < 2; y++)
+			for (index_t x = 0; x < 3; x++)
+				EXPECT_EQ(view(s, x, y, 0), m.get_substrate_density(s, x, y, 0));
+
+	// a held snapshot stays intact while the following timesteps run
+	const real_t held = view(1, 2, 1, 0);
+	for (int i = 0; i < 3; i++)
+		m.run_single_timestep();
+
+	EXPECT_EQ(first->view()(1, 2, 1, 0), held);
+	EXPECT_EQ(m.get_substrate_snapshot()->epoch, 3U);
+	EXPECT_EQ(m.get_substrate_snapshot()->view()(1, 2, 1, 0), held + 3);
+}
+
+TEST(SubstrateSnapshotTest, ReleasedBufferIsReused)
+{
+	const cartesian_mesh mesh(2, { 0, 0, 0 }, { 60, 40, 0 }, { 20, 20, 20 });
+	microenvironment m(mesh, 2, 0.01);
+	m.solver = std::make_unique<incrementing_solver>(m);
+	m.publish_snapshots = true;
+
+	m.run_single_timestep();
+	auto first = m.get_substrate_snapshot();
+	const substrate_snapshot* first_address = first.get();
+
+	// held by a reader, the buffer is not rewritten two timesteps later
+	m.run_single_timestep();
+	m.run_single_timestep();
+	EXPECT_NE(m.get_substrate_snapshot().get(), first_address);
+	EXPECT_EQ(first->epoch, 0U);
+
+	// once released, the older buffer is rewritten instead of allocating a new one
+	first.reset();
+	m.run_single_timestep();
+	const substrate_snapshot* second_address = m.get_substrate_snapshot().get();
+	m.run_single_timestep();
+	m.run_single_timestep();
+	EXPECT_EQ(m.get_substrate_snapshot().get(), second_address);
+}
+
+TEST(SubstrateSnapshotTest, ConcurrentReader)
+{
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 200, 20, 20 }, { 20, 20, 20 });
+	microenvironment m(mesh, 3, 0.01);
+	m.solver = std::make_unique<incrementing_solver>(m);
+	m.publish_snapshots = true;
+	m.run_single_timestep();
+
+	std::atomic<bool> done = false;
+
+	// every snapshot must be consistent: all densities advanced by the same number of steps
+	std::thread reader([&] {
+		while (!done.load())
+		{
+			auto snapshot = m.get_substrate_snapshot();
+			const real_t offset = snapshot->densities[0];
+			for (std::size_t i = 0; i < snapshot->densities.size(); i++)
+			{
+				const auto [s, x] = std::pair { i % 3, i / 3 };
+				ASSERT_EQ(snapshot->densities[i], offset + (real_t)(s * 10 + x));
+			}
+		}
+	});
+
+	for (int i = 0; i < 200; i++)
+		m.run_single_timestep();
+
+	done = true;
+	reader.join();
+}
+
+TEST(SubstrateSnapshotTest, PublishedAfterEachOfRunSteps)
+{
+	const cartesian_mesh mesh(1, { 0, 0, 0 }, { 60, 20, 20 }, { 20, 20, 20 });
+	microenvironment m(mesh, 1, 0.5);
+	m.solver = std::make_unique<incrementing_solver>(m);
+	m.publish_snapshots = true;
+
+	std::vector<real_t> seen;
+	const real_t reached =
+		m.run_until(0, 2, [&](index_t /*step*/) { seen.push_back(m.get_substrate_snapshot()->densities[0]); });
+
+	EXPECT_DOUBLE_EQ(reached, 2);
+	EXPECT_EQ(seen, (std::vector<real_t> { 1, 2, 3, 4 }));
+	EXPECT_EQ(m.get_substrate_snapshot()->epoch, 3U);
+}